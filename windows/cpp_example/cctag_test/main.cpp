@@ -1,7 +1,9 @@
 ﻿#include <iostream>
+#include <fstream>
 #include <vector>
 #include <cctag/CCTag.hpp>
 #include <opencv2/opencv.hpp>
+#include "circle_grid.h"
 
 int main(int argc, char** argv) {
     std::cout << "=== CCTag Detection Test ===" << std::endl;
@@ -39,6 +41,7 @@ int main(int argc, char** argv) {
     
     // Output: list of detected markers
     boost::ptr_list<cctag::ICCTag> markers;
+    int validCount = 0;       // markers with status == 1
     
     try {
         // Call cctagDetection with correct signature
@@ -55,7 +58,6 @@ int main(int argc, char** argv) {
         std::cout << "  Total detected: " << markers.size() << std::endl;
         
         // Count valid markers (status == 1)
-        int validCount = 0;
         for (const auto& marker : markers) {
             if (marker.getStatus() == 1) {
                 validCount++;
@@ -69,7 +71,8 @@ int main(int argc, char** argv) {
     }
     
     // Print marker details (only valid ones)
-    if (!markers.empty()) {
+    std::vector<CircleGridResult> grids;
+    if (validCount > 0) {
         std::cout << "\n=== Detected Markers ===" << std::endl;
         
         int idx = 1;
@@ -83,30 +86,26 @@ int main(int argc, char** argv) {
             }
         }
     } else {
-        std::cout << "\nNo CCTag markers detected!" << std::endl;
+        std::cout << "\nNo valid CCTag markers detected!" << std::endl;
         std::cout << "This could mean:" << std::endl;
         std::cout << "  1. No CCTag markers in the image" << std::endl;
         std::cout << "  2. Your calibration target uses simple circles (not CCTag)" << std::endl;
-        std::cout << "\nTrying Hough Circle detection as fallback..." << std::endl;
+        std::cout << "\nTrying circle-grid detection as fallback..." << std::endl;
         
-        // Fallback: Hough circles
-        std::vector<cv::Vec3f> circles;
-        cv::HoughCircles(image, circles, cv::HOUGH_GRADIENT,
-                        1,      // dp
-                        20,     // minDist
-                        50,     // param1
-                        30,     // param2
-                        5,      // minRadius
-                        100);   // maxRadius
+        // Fallback: circle-grid board (dark dots, one grid per plane)
+        grids = detectCircleGrids(image);
         
-        std::cout << "Hough detected " << circles.size() << " circles" << std::endl;
+        std::cout << "Circle-grid detected " << grids.size() << " grids" << std::endl;
         
-        if (!circles.empty()) {
-            std::cout << "\n=== Detected Circles (Hough) ===" << std::endl;
-            for (size_t i = 0; i < circles.size(); i++) {
-                std::cout << "Circle " << i+1 << ": "
-                         << "center=(" << circles[i][0] << ", " << circles[i][1] << "), "
-                         << "radius=" << circles[i][2] << std::endl;
+        int circleIdx = 1;
+        for (size_t g = 0; g < grids.size(); g++) {
+            std::cout << "\n=== Grid " << g + 1 << ": " << grids[g].cols << "x" << grids[g].rows
+                      << (grids[g].complete ? "" : " (incomplete)") << " ===" << std::endl;
+            for (const auto& dot : grids[g].dots) {
+                std::cout << "Circle " << circleIdx++ << ": "
+                         << "center=(" << dot.center.x << ", " << dot.center.y << "), "
+                         << "radius=" << dot.radius << ", "
+                         << "row=" << dot.row << ", col=" << dot.col << std::endl;
             }
         }
     }
@@ -117,7 +116,6 @@ int main(int argc, char** argv) {
     cv::cvtColor(image, vis_image, cv::COLOR_GRAY2BGR);
     
     // Draw CCTag markers in green (only valid ones)
-    int markerCount = 0;
     for (const auto& marker : markers) {
         if (marker.getStatus() == 1) {  // Only draw valid markers
             cv::Point center(cvRound(marker.x()), cvRound(marker.y()));
@@ -133,33 +131,30 @@ int main(int argc, char** argv) {
                        0.7, 
                        cv::Scalar(0, 255, 0), 
                        2);
-            
-            markerCount++;
         }
     }
     
-    // If no valid CCTag, draw Hough circles in yellow
-    if (markerCount == 0) {
-        std::vector<cv::Vec3f> circles;
-        cv::HoughCircles(image, circles, cv::HOUGH_GRADIENT,
-                        1, 20, 50, 30, 5, 100);
-        
-        for (size_t i = 0; i < circles.size(); i++) {
-            cv::Point center(cvRound(circles[i][0]), cvRound(circles[i][1]));
-            int radius = cvRound(circles[i][2]);
-            
-            // Draw circle outline
-            cv::circle(vis_image, center, radius, cv::Scalar(0, 255, 255), 2);
-            // Draw center
-            cv::circle(vis_image, center, 5, cv::Scalar(0, 255, 255), -1);
-            // Draw number
-            cv::putText(vis_image,
-                       "#" + std::to_string(i+1),
-                       cv::Point(center.x + 10, center.y),
-                       cv::FONT_HERSHEY_SIMPLEX,
-                       0.6,
-                       cv::Scalar(255, 255, 0),
-                       2);
+    // If no valid CCTag, draw grid circles in yellow
+    if (validCount == 0) {
+        int circleIdx = 1;
+        for (const auto& grid : grids) {
+            for (const auto& dot : grid.dots) {
+                cv::Point center(cvRound(dot.center.x), cvRound(dot.center.y));
+                int radius = cvRound(dot.radius);
+                
+                // Draw circle outline
+                cv::circle(vis_image, center, radius, cv::Scalar(0, 255, 255), 2);
+                // Draw center
+                cv::circle(vis_image, center, 5, cv::Scalar(0, 255, 255), -1);
+                // Draw number
+                cv::putText(vis_image,
+                           "#" + std::to_string(circleIdx++),
+                           cv::Point(center.x + 10, center.y),
+                           cv::FONT_HERSHEY_SIMPLEX,
+                           0.6,
+                           cv::Scalar(255, 255, 0),
+                           2);
+            }
         }
     }
     
@@ -169,7 +164,7 @@ int main(int argc, char** argv) {
     std::cout << "Result saved to: " << output_path << std::endl;
 
     // Save marker coordinates to file
-    if (markerCount > 0) {
+    if (validCount > 0) {
         std::string coordFile = "cctag_markers.txt";
         std::ofstream out(coordFile);
         if (out.is_open()) {
@@ -187,6 +182,28 @@ int main(int argc, char** argv) {
             std::cout << "Use this file with: xsctt.exe data_bright.bmp data_depth_map.tiff cctag_markers.txt" << std::endl;
         }
     }
+    else if (!grids.empty()) {
+        // Same format; IDs run row-major through each grid
+        std::string coordFile = "cctag_markers.txt";
+        std::ofstream out(coordFile);
+        if (out.is_open()) {
+            out << "# Circle-Grid Coordinates" << std::endl;
+            out << "# x y id" << std::endl;
+            
+            int nextId = 1;
+            for (const auto& grid : grids) {
+                for (const auto& dot : grid.dots) {
+                    out << dot.center.x << " " << dot.center.y << " "
+                        << nextId + dot.row * grid.cols + dot.col << std::endl;
+                }
+                nextId += grid.rows * grid.cols;
+            }
+            
+            out.close();
+            std::cout << "\nCircle coordinates saved to: " << coordFile << std::endl;
+            std::cout << "Use this file with: xsctt.exe data_bright.bmp data_depth_map.tiff cctag_markers.txt" << std::endl;
+        }
+    }
     
     // Show window
     cv::namedWindow("CCTag Detection", cv::WINDOW_NORMAL);
@@ -0,0 +1,220 @@
+#include "auto_exposure.h"
+#include "confidence.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+// ═══════════════════════════════════════════════════════════════════════
+// Histogram
+// ═══════════════════════════════════════════════════════════════════════
+
+BrightnessStats brightnessStats(const cv::Mat& brightness, const cv::Rect& roi, float saturationLevel) {
+    CV_Assert(brightness.type() == CV_8UC1);
+    const cv::Rect frame(0, 0, brightness.cols, brightness.rows);
+    const cv::Rect area = roi.area() > 0 ? roi & frame : frame;
+
+    BrightnessStats stats;
+    std::memset(stats.histogram, 0, sizeof(stats.histogram));
+    std::mutex mutex;
+
+    cv::parallel_for_(cv::Range(area.y, area.y + area.height), [&](const cv::Range& range) {
+        // Consecutive pixels of similar value would serialize on one counter;
+        // four tables let them increment independently
+        std::vector<int> tables(4 * 256, 0);
+        int* t0 = &tables[0];
+        int* t1 = &tables[256];
+        int* t2 = &tables[512];
+        int* t3 = &tables[768];
+
+        for (int r = range.start; r < range.end; r++) {
+            const uchar* p = brightness.ptr<uchar>(r) + area.x;
+            int c = 0;
+            for (; c <= area.width - 4; c += 4) {
+                t0[p[c]]++;
+                t1[p[c + 1]]++;
+                t2[p[c + 2]]++;
+                t3[p[c + 3]]++;
+            }
+            for (; c < area.width; c++) t0[p[c]]++;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int i = 0; i < 256; i++) stats.histogram[i] += t0[i] + t1[i] + t2[i] + t3[i];
+    });
+
+    const int satBin = std::min(256, std::max(0, static_cast<int>(std::ceil(saturationLevel))));
+    double sum = 0.0;
+    int over = 0;
+    stats.count = 0;
+    for (int i = 0; i < 256; i++) {
+        stats.count += stats.histogram[i];
+        sum += static_cast<double>(i) * stats.histogram[i];
+        if (i >= satBin) over += stats.histogram[i];
+    }
+    stats.overExposed = stats.count > 0 ? static_cast<float>(over) / stats.count : 0.0f;
+    stats.mean = stats.count > 0 ? static_cast<float>(sum / stats.count) : 0.0f;
+    return stats;
+}
+
+// Brightness at a fraction of the sorted ROI pixels
+static float percentileLevel(const BrightnessStats& stats, float fraction) {
+    const double rank = std::min(1.0f, std::max(0.0f, fraction)) * (stats.count - 1);
+    double seen = 0.0;
+    for (int i = 0; i < 256; i++) {
+        seen += stats.histogram[i];
+        if (seen > rank) return static_cast<float>(i);
+    }
+    return 255.0f;
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Controller
+// ═══════════════════════════════════════════════════════════════════════
+
+static double linearGain(float dB) {
+    return std::pow(10.0, dB / 20.0);
+}
+
+// exposure * led / 1023 * gain, the brightness scale of the model
+static double totalScale(const ExposureSettings& s) {
+    return s.exposure * (s.led / 1023.0) * linearGain(s.gain);
+}
+
+// Settings with the given total scale: exposure first, then gain, then LED
+static ExposureSettings settingsForScale(double total, const AutoExposureParams& params) {
+    ExposureSettings s;
+    const double ledFull = params.maxLed / 1023.0;
+    s.led = params.maxLed;
+    s.gain = 0.0f;
+    s.exposure = static_cast<float>(total / ledFull);
+
+    if (s.exposure > params.maxExposure) {
+        s.exposure = params.maxExposure;
+        double gain = total / (params.maxExposure * ledFull);
+        s.gain = static_cast<float>(std::min<double>(params.maxGain, 20.0 * std::log10(gain)));
+    } else if (s.exposure < params.minExposure) {
+        s.exposure = params.minExposure;
+        double led = total / params.minExposure * 1023.0;
+        s.led = std::max(params.minLed, std::min(params.maxLed, static_cast<int>(std::floor(led))));
+    }
+    return s;
+}
+
+ExposureSettings nextExposure(const BrightnessStats& stats, const ExposureSettings& current,
+                              const AutoExposureParams& params, bool& converged) {
+    // No pixels measured: nothing to scale from
+    converged = false;
+    if (stats.count <= 0) return current;
+
+    const float level = percentileLevel(stats, params.targetPercentile);
+    // Brightest level that may stay below saturation
+    const float ceilingLevel = percentileLevel(stats, 1.0f - params.maxOverExposed);
+    const bool overExposed = stats.overExposed > params.maxOverExposed;
+
+    double scale;
+    if (overExposed && level >= params.saturationLevel) {
+        // Clipped up to the target percentile: the true level is unknown
+        scale = stats.overExposed > 4.0f * params.maxOverExposed ? 0.25 : 0.5;
+    } else if (overExposed) {
+        // Only the tail is clipped. The saturation edge sits at quantile
+        // 1 - overExposed; extrapolate linearly from the target percentile
+        // to the quantile that must stay below saturation
+        const double edge = std::max(1e-3, 1.0 - stats.overExposed - params.targetPercentile);
+        const double ceiling = params.saturationLevel + (params.saturationLevel - level) *
+                               (stats.overExposed - params.maxOverExposed) / edge;
+        scale = std::min(static_cast<double>(params.targetLevel / level), 0.95 * params.saturationLevel / ceiling);
+        scale = std::max(0.125, std::min(0.8, scale));
+    } else if (level < 2.0f) {
+        scale = 16.0;
+    } else {
+        scale = params.targetLevel / level;
+        // 5 % headroom below saturation for the over-exposure constraint
+        if (ceilingLevel > 0.0f) scale = std::min(scale, 0.95 * params.saturationLevel / ceilingLevel);
+        scale = std::min(32.0, std::max(0.0625, scale));
+    }
+
+    converged = !overExposed && std::abs(scale - 1.0) <= params.tolerance;
+    if (converged) return current;
+
+    return settingsForScale(totalScale(current) * scale, params);
+}
+
+static bool sameSettings(const ExposureSettings& a, const ExposureSettings& b) {
+    return std::abs(a.exposure - b.exposure) < 1.0f && a.led == b.led && std::abs(a.gain - b.gain) < 0.01f;
+}
+
+int requireFringeBrightness(XEMA::XCamera* camera) {
+    int model = 0;
+    float exposure = 0.0f;
+    if (0 != camera->getParamGenerateBrightness(model, exposure)) {
+        std::cerr << "Get Param Generate Brightness Error!" << std::endl;
+        return -1;
+    }
+    // Models 2 and 3 expose the brightness image on its own, with its own
+    // exposure and gain
+    if (1 != model) {
+        std::cerr << "Generate Brightness Model Must Be 1 (Exposed With Fringes)!" << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+static int applySettings(XEMA::XCamera* camera, const ExposureSettings& s) {
+    if (0 != camera->setParamCameraExposure(s.exposure) ||
+        0 != camera->setParamLedCurrent(s.led) ||
+        0 != camera->setParamCameraGain(s.gain)) {
+        std::cerr << "Set Exposure Param Error!" << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+int autoExposure(XEMA::XCamera* camera, const ExposureSettings& start, const AutoExposureParams& params,
+                 AutoExposureResult& result) {
+    result = AutoExposureResult();
+    result.settings = start;
+
+    int width = 0, height = 0;
+    if (0 != camera->getCameraResolution(&width, &height) || width <= 0 || height <= 0) {
+        std::cerr << "Get Camera Resolution Error!" << std::endl;
+        return -1;
+    }
+    if (0 != requireFringeBrightness(camera)) return -1;
+    cv::Mat brightness(height, width, CV_8UC1);
+    if (0 != applySettings(camera, start)) return -1;
+
+    while (result.captures < params.maxCaptures) {
+        int ret;
+        if (params.fullCapture) {
+            char timestamp[30] = "";
+            ret = camera->captureData(1, timestamp);
+            if (0 == ret) ret = getGrayBrightnessData(camera, brightness.ptr<uchar>());
+        } else {
+            ret = camera->captureBrightnessData(brightness.ptr<uchar>(), XEMA::XemaColor::Gray);
+        }
+        if (0 != ret) {
+            std::cerr << "Capture Brightness Error!" << std::endl;
+            return -1;
+        }
+        result.captures++;
+
+        result.stats = brightnessStats(brightness, params.roi, params.saturationLevel);
+        if (result.stats.count <= 0) {
+            std::cerr << "Auto Exposure ROI Outside Frame!" << std::endl;
+            return -1;
+        }
+        ExposureSettings next = nextExposure(result.stats, result.settings, params, result.converged);
+        // Converged, or the limits leave nothing to change
+        if (result.converged || sameSettings(next, result.settings)) break;
+        // Settings that would not be measured again stay off the camera, so
+        // the stats always describe result.settings
+        if (result.captures >= params.maxCaptures) break;
+
+        if (0 != applySettings(camera, next)) return -1;
+        result.settings = next;
+    }
+    return 0;
+}
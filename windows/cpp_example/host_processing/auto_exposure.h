@@ -0,0 +1,82 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include "xcamera.h"
+
+// ═══════════════════════════════════════════════════════════════════════
+// Auto Exposure
+// ═══════════════════════════════════════════════════════════════════════
+//
+// Chooses camera exposure, LED current and gain from brightness
+// histograms. Brightness is taken as linear in
+//     exposure * led / 1023 * 10^(gain / 20)
+// so one capture gives the scale to the target directly; the next capture
+// only corrects the model error. Saturated pixels carry no level, so an
+// over-exposed capture is stepped down first and measured again.
+//
+// Goal: the targetPercentile brightness of the ROI at targetLevel, with at
+// most maxOverExposed of the ROI at or above saturationLevel (the GUI's
+// show_over_exposure marking). Exposure time is changed first, with the
+// LED kept at maxLed; gain is only added above maxExposure and the LED
+// is only dimmed below minExposure.
+//
+// Only setParamGenerateBrightness model 1 (brightness exposed with the
+// fringes) makes the brightness image follow these settings; models 2
+// and 3 use the brightness exposure and setParamBrightnessGain instead,
+// so the camera functions below refuse them.
+
+struct ExposureSettings {
+    float exposure = 10000.0f;      // setParamCameraExposure (camera_exposure_time)
+    int led = 1023;                 // setParamLedCurrent (led_current, 0-1023)
+    float gain = 0.0f;              // setParamCameraGain (camera_gain, dB)
+};
+
+struct AutoExposureParams {
+    cv::Rect roi;                   // measured region; empty = whole frame
+    float targetLevel = 180.0f;     // brightness for the target percentile
+    float targetPercentile = 0.95f; // fraction of ROI pixels at or below targetLevel
+    float saturationLevel = 250.0f; // over-exposure threshold
+    float maxOverExposed = 0.01f;   // allowed fraction of ROI pixels >= saturationLevel
+    float tolerance = 0.1f;         // relative level error accepted as converged
+    int maxCaptures = 3;
+    float minExposure = 1000.0f;
+    float maxExposure = 100000.0f;
+    int minLed = 100;
+    int maxLed = 1023;
+    float maxGain = 12.0f;          // dB
+    bool fullCapture = false;       // false: captureBrightnessData, true: captureData + getBrightnessData
+};
+
+struct BrightnessStats {
+    int histogram[256];
+    int count;                      // ROI pixels
+    float overExposed;              // fraction >= saturationLevel
+    float mean;
+};
+
+struct AutoExposureResult {
+    ExposureSettings settings;      // applied to the camera and measured last
+    BrightnessStats stats;          // of the last capture
+    int captures;
+    bool converged;
+};
+
+// Histogram of a CV_8UC1 image over an ROI; row blocks are counted in
+// parallel into 4 interleaved tables each, then merged
+BrightnessStats brightnessStats(const cv::Mat& brightness, const cv::Rect& roi, float saturationLevel);
+
+// Brightness-scale decision for one measurement: the settings for the next
+// capture, and whether `current` already meets the goal. An empty
+// histogram leaves `current` unchanged and not converged.
+ExposureSettings nextExposure(const BrightnessStats& stats, const ExposureSettings& current,
+                              const AutoExposureParams& params, bool& converged);
+
+// 0 when the brightness model is 1; -1 (with a message) for models 2 and
+// 3 or on an SDK error
+int requireFringeBrightness(XEMA::XCamera* camera);
+
+// Captures until converged or maxCaptures. The camera is left at the
+// settings of the last capture, which result.stats describe. Returns 0 on
+// success (also when not converged), -1 on any SDK error, when the
+// brightness model is not 1 or when the ROI lies outside the frame.
+int autoExposure(XEMA::XCamera* camera, const ExposureSettings& start, const AutoExposureParams& params,
+                 AutoExposureResult& result);
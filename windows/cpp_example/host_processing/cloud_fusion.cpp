@@ -0,0 +1,291 @@
+#include "cloud_fusion.h"
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <iostream>
+#include <opencv2/core/hal/intrin.hpp>
+#include "voxel_key.h"
+
+namespace {
+
+const int kStripes = 16;            // per camera
+const int kPartitionBits = 6;
+const int kPartitions = 1 << kPartitionBits;
+
+using voxel_key::voxelHash;
+using voxel_key::voxelIndex;
+using voxel_key::voxelKey;
+
+// Per voxel: the cameras that reached it and the most confident one
+struct VoxelOwner {
+    uint64_t key;
+    uint64_t cameras;
+    int used;
+    uchar bestConfidence;
+    uchar bestSource;
+};
+
+template <typename T> void growTo(std::vector<T>& v, size_t n) {
+    if (v.size() < n) v.resize(n);
+}
+
+void growTo(cv::Mat& m, int rows, int type) {
+    if (m.rows < rows || m.type() != type) m.create(rows, 1, type);
+}
+
+}  // namespace
+
+// ═══════════════════════════════════════════════════════════════════════
+// Fusion
+// ═══════════════════════════════════════════════════════════════════════
+
+void fuseClouds(const std::vector<FusionSource>& sources, FusedCloud& result, const FusionParams& params) {
+    CV_Assert(sources.size() <= 64 && params.voxelSize > 0.0f);
+    const int cameras = static_cast<int>(sources.size());
+    const int jobs = cameras * kStripes;
+    const float invVoxel = 1.0f / params.voxelSize;
+
+    std::vector<int> base(cameras + 1, 0);
+    for (int c = 0; c < cameras; c++) {
+        const FusionSource& s = sources[c];
+        CV_Assert(s.cloud.type() == CV_32FC3);
+        CV_Assert(s.frame.brightness.empty() ||
+                  (s.frame.brightness.type() == CV_8UC1 && s.frame.brightness.size() == s.cloud.size()));
+        CV_Assert(s.frame.confidence.empty() ||
+                  (s.frame.confidence.type() == CV_8UC1 && s.frame.confidence.size() == s.cloud.size()));
+        base[c + 1] = base[c] + s.cloud.rows * s.cloud.cols;
+    }
+    const int capacity = base[cameras];
+
+    FusedCloud::Buffers& buf = result.buffers;
+    growTo(buf.work, std::max(1, capacity), CV_32FC3);
+    growTo(buf.keys, capacity);
+    growTo(buf.workBrightness, capacity);
+    growTo(buf.workConfidence, capacity);
+    growTo(buf.workSource, capacity);
+    growTo(buf.partition, capacity);
+    growTo(buf.keep, capacity);
+    growTo(buf.order, capacity);
+
+    // 1. Transform, filter and compact each stripe at its own offset
+    std::vector<int> jobBase(jobs), jobCount(jobs, 0), partCount(static_cast<size_t>(jobs) * kPartitions, 0);
+
+    cv::parallel_for_(cv::Range(0, jobs), [&](const cv::Range& range) {
+        std::vector<float> moved;
+        std::vector<int> ix, iy, iz;
+
+        for (int job = range.start; job < range.end; job++) {
+            const int c = job / kStripes, s = job % kStripes;
+            const FusionSource& src = sources[c];
+            const int rows = src.cloud.rows, cols = src.cloud.cols;
+            const int y0 = rows * s / kStripes, y1 = rows * (s + 1) / kStripes;
+            const cv::Matx44f T = src.pose;
+            const bool hasBrightness = !src.frame.brightness.empty();
+            const bool hasConfidence = !src.frame.confidence.empty();
+            moved.resize(3 * cols + 12);
+            ix.resize(cols + 4);
+            iy.resize(cols + 4);
+            iz.resize(cols + 4);
+
+            const int start = base[c] + y0 * cols;
+            int* parts = &partCount[static_cast<size_t>(job) * kPartitions];
+            float* work = buf.work.ptr<float>(start);
+            int n = 0;
+
+            for (int y = y0; y < y1; y++) {
+                const float* p = src.cloud.ptr<float>(y);
+                const uchar* b = hasBrightness ? src.frame.brightness.ptr<uchar>(y) : nullptr;
+                const uchar* conf = hasConfidence ? src.frame.confidence.ptr<uchar>(y) : nullptr;
+
+                int x = 0;
+#if CV_SIMD128
+                const cv::v_float32x4 r00 = cv::v_setall_f32(T(0, 0)), r01 = cv::v_setall_f32(T(0, 1)),
+                                      r02 = cv::v_setall_f32(T(0, 2)), t0 = cv::v_setall_f32(T(0, 3));
+                const cv::v_float32x4 r10 = cv::v_setall_f32(T(1, 0)), r11 = cv::v_setall_f32(T(1, 1)),
+                                      r12 = cv::v_setall_f32(T(1, 2)), t1 = cv::v_setall_f32(T(1, 3));
+                const cv::v_float32x4 r20 = cv::v_setall_f32(T(2, 0)), r21 = cv::v_setall_f32(T(2, 1)),
+                                      r22 = cv::v_setall_f32(T(2, 2)), t2 = cv::v_setall_f32(T(2, 3));
+                const cv::v_float32x4 vinv = cv::v_setall_f32(invVoxel);
+                for (; x <= cols - 4; x += 4) {
+                    cv::v_float32x4 px, py, pz;
+                    cv::v_load_deinterleave(p + 3 * x, px, py, pz);
+                    const cv::v_float32x4 qx = r00 * px + r01 * py + r02 * pz + t0;
+                    const cv::v_float32x4 qy = r10 * px + r11 * py + r12 * pz + t1;
+                    const cv::v_float32x4 qz = r20 * px + r21 * py + r22 * pz + t2;
+                    cv::v_store_interleave(&moved[3 * x], qx, qy, qz);
+                    cv::v_store(&ix[x], cv::v_floor(qx * vinv));
+                    cv::v_store(&iy[x], cv::v_floor(qy * vinv));
+                    cv::v_store(&iz[x], cv::v_floor(qz * vinv));
+                }
+#endif
+                for (; x < cols; x++) {
+                    const float px = p[3 * x], py = p[3 * x + 1], pz = p[3 * x + 2];
+                    for (int k = 0; k < 3; k++) {
+                        moved[3 * x + k] = T(k, 0) * px + T(k, 1) * py + T(k, 2) * pz + T(k, 3);
+                    }
+                    ix[x] = voxelIndex(moved[3 * x] * invVoxel);
+                    iy[x] = voxelIndex(moved[3 * x + 1] * invVoxel);
+                    iz[x] = voxelIndex(moved[3 * x + 2] * invVoxel);
+                }
+
+                for (x = 0; x < cols; x++) {
+                    if (!(p[3 * x + 2] > 0.0f) || !std::isfinite(moved[3 * x]) || !std::isfinite(moved[3 * x + 1]) ||
+                        !std::isfinite(moved[3 * x + 2])) continue;
+                    const uchar confidence = conf ? conf[x] : 255;
+                    if (confidence < params.minConfidence) continue;
+
+                    const int i = start + n++;
+                    std::copy(&moved[3 * x], &moved[3 * x] + 3, work);
+                    work += 3;
+                    const uint64_t key = voxelKey(ix[x], iy[x], iz[x]);
+                    const int part = static_cast<int>(voxelHash(key) >> (64 - kPartitionBits));
+                    buf.keys[i] = key;
+                    buf.workBrightness[i] = b ? b[x] : 0;
+                    buf.workConfidence[i] = confidence;
+                    buf.workSource[i] = static_cast<uchar>(c);
+                    buf.partition[i] = static_cast<uchar>(part);
+                    parts[part]++;
+                }
+            }
+            jobBase[job] = start;
+            jobCount[job] = n;
+        }
+    });
+
+    // 2. Counting sort by partition, stripes in order within a partition
+    std::vector<int> partStart(kPartitions + 1, 0), cursor(static_cast<size_t>(jobs) * kPartitions);
+    for (int part = 0; part < kPartitions; part++) {
+        int pos = partStart[part];
+        for (int job = 0; job < jobs; job++) {
+            cursor[static_cast<size_t>(job) * kPartitions + part] = pos;
+            pos += partCount[static_cast<size_t>(job) * kPartitions + part];
+        }
+        partStart[part + 1] = pos;
+    }
+
+    cv::parallel_for_(cv::Range(0, jobs), [&](const cv::Range& range) {
+        for (int job = range.start; job < range.end; job++) {
+            int* next = &cursor[static_cast<size_t>(job) * kPartitions];
+            for (int i = jobBase[job]; i < jobBase[job] + jobCount[job]; i++) buf.order[next[buf.partition[i]]++] = i;
+        }
+    });
+
+    // 3. Voxel owners per partition
+    std::vector<int> overlap(kPartitions, 0), dropped(kPartitions, 0);
+
+    cv::parallel_for_(cv::Range(0, kPartitions), [&](const cv::Range& range) {
+        std::vector<VoxelOwner> table;
+        std::vector<int> slotOf;
+
+        for (int part = range.start; part < range.end; part++) {
+            const int first = partStart[part], n = partStart[part + 1] - first;
+            if (n == 0) continue;
+            size_t size = 64;
+            while (size < 2 * static_cast<size_t>(n)) size <<= 1;
+            table.assign(size, VoxelOwner{0, 0, 0, 0, 0});
+            slotOf.resize(n);
+            const size_t mask = size - 1;
+
+            for (int k = 0; k < n; k++) {
+                const int i = buf.order[first + k];
+                const uint64_t key = buf.keys[i];
+                size_t slot = (voxelHash(key) >> 20) & mask;
+                while (table[slot].used && table[slot].key != key) slot = (slot + 1) & mask;
+                VoxelOwner& owner = table[slot];
+                const uchar confidence = buf.workConfidence[i], source = buf.workSource[i];
+                if (!owner.used) {
+                    owner = VoxelOwner{key, 0, 1, confidence, source};
+                } else if (confidence > owner.bestConfidence) {
+                    owner.bestConfidence = confidence;
+                    owner.bestSource = source;
+                }
+                owner.cameras |= 1ull << source;
+                slotOf[k] = static_cast<int>(slot);
+            }
+
+            for (int k = 0; k < n; k++) {
+                const int i = buf.order[first + k];
+                const VoxelOwner& owner = table[slotOf[k]];
+                buf.keep[i] = owner.bestSource == buf.workSource[i];
+                dropped[part] += !buf.keep[i];
+            }
+            for (const VoxelOwner& owner : table) overlap[part] += owner.used && (owner.cameras & (owner.cameras - 1));
+        }
+    });
+
+    // 4. Kept points, stripes in order
+    std::vector<int> kept(jobs + 1, 0);
+    cv::parallel_for_(cv::Range(0, jobs), [&](const cv::Range& range) {
+        for (int job = range.start; job < range.end; job++) {
+            int n = 0;
+            for (int i = jobBase[job]; i < jobBase[job] + jobCount[job]; i++) n += buf.keep[i];
+            kept[job + 1] = n;
+        }
+    });
+    for (int job = 0; job < jobs; job++) kept[job + 1] += kept[job];
+    const int total = kept[jobs];
+
+    growTo(buf.points, std::max(1, capacity), CV_32FC3);
+    growTo(buf.brightness, std::max(1, capacity), CV_8UC1);
+    growTo(buf.confidence, std::max(1, capacity), CV_8UC1);
+    growTo(buf.source, std::max(1, capacity), CV_8UC1);
+
+    cv::parallel_for_(cv::Range(0, jobs), [&](const cv::Range& range) {
+        for (int job = range.start; job < range.end; job++) {
+            int row = kept[job];
+            for (int i = jobBase[job]; i < jobBase[job] + jobCount[job]; i++) {
+                if (!buf.keep[i]) continue;
+                std::copy(buf.work.ptr<float>(i), buf.work.ptr<float>(i) + 3, buf.points.ptr<float>(row));
+                buf.brightness.at<uchar>(row) = buf.workBrightness[i];
+                buf.confidence.at<uchar>(row) = buf.workConfidence[i];
+                buf.source.at<uchar>(row) = buf.workSource[i];
+                row++;
+            }
+        }
+    });
+
+    result.points = buf.points.rowRange(0, total);
+    result.brightness = buf.brightness.rowRange(0, total);
+    result.confidence = buf.confidence.rowRange(0, total);
+    result.source = buf.source.rowRange(0, total);
+    result.overlapVoxels = 0;
+    result.duplicates = 0;
+    for (int part = 0; part < kPartitions; part++) {
+        result.overlapVoxels += overlap[part];
+        result.duplicates += dropped[part];
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Capture
+// ═══════════════════════════════════════════════════════════════════════
+
+int captureFusionSet(std::vector<FusionSource>& sources, int exposureNum, const ConfidenceParams& confidenceParams) {
+    std::vector<std::future<int>> pending;
+    for (FusionSource& source : sources) {
+        FusionSource* s = &source;
+        pending.push_back(std::async(std::launch::async, [s, exposureNum, &confidenceParams]() {
+            if (0 != fetchDepthFrame(s->camera, exposureNum, s->frame)) return -1;
+            s->cloud.create(s->frame.depth.size(), CV_32FC3);
+            if (0 != s->camera->getPointcloudData(s->cloud.ptr<float>())) {
+                std::cerr << "Capture Data Error!" << std::endl;
+                return -1;
+            }
+            computeConfidence(s->frame.depth, s->frame.brightness, s->frame.confidence, confidenceParams);
+            return 0;
+        }));
+    }
+
+    int ret = 0;
+    for (std::future<int>& f : pending) {
+        if (0 != f.get()) ret = -1;
+    }
+    return ret;
+}
+
+int captureFusedCloud(std::vector<FusionSource>& sources, FusedCloud& result, int exposureNum,
+                      const FusionParams& params, const ConfidenceParams& confidenceParams) {
+    if (0 != captureFusionSet(sources, exposureNum, confidenceParams)) return -1;
+    fuseClouds(sources, result, params);
+    return 0;
+}
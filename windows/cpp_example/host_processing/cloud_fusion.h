@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <opencv2/core.hpp>
+#include "confidence.h"
+#include "xcamera.h"
+
+// ═══════════════════════════════════════════════════════════════════════
+// Multi-Camera Cloud Fusion
+// ═══════════════════════════════════════════════════════════════════════
+//
+// Merges the clouds of N cameras into one cloud in a common frame.
+//
+//   1. Every camera is split into fixed row stripes. Each stripe moves its
+//      points into the common frame with a 4x4 transform (4 points per
+//      SIMD step), drops invalid and low-confidence points, and writes the
+//      survivors compacted into the shared working buffer.
+//   2. Points are counting-sorted by the hash of their voxel into
+//      partitions. Each partition finds, per voxel, the camera with the
+//      most confident point; in voxels reached by several cameras only
+//      that camera's points are kept. Single-camera voxels keep all
+//      their points, so the resolution of each camera is preserved.
+//   3. The kept points are prefix-summed and written out.
+//
+// The buffers live in FusedCloud and grow to the total pixel count on
+// first use; later capture sets of the same rig do not allocate. Stripes
+// and partitions are fixed in number and merged in order, so the output is
+// identical for any thread count.
+
+struct FusionSource {
+    XEMA::XCamera* camera = nullptr;            // used by the capture functions only
+    cv::Matx44d pose = cv::Matx44d::eye();      // camera -> common frame (poseFromExtrinsic, icpAlign)
+    cv::Mat cloud;                              // CV_32FC3, getPointcloudData
+    DepthFrame frame;                           // brightness and confidence; empty = 0 / 255
+};
+
+struct FusionParams {
+    float voxelSize = 2.0f;     // mm; overlap is decided per voxel
+    int minConfidence = 32;     // points below are dropped before fusion
+};
+
+struct FusedCloud {
+    cv::Mat points;             // N x 1 CV_32FC3, common frame
+    cv::Mat brightness;         // N x 1 CV_8UC1
+    cv::Mat confidence;         // N x 1 CV_8UC1
+    cv::Mat source;             // N x 1 CV_8UC1, index into the sources
+    int overlapVoxels = 0;      // voxels reached by more than one camera
+    int duplicates = 0;         // points dropped in them
+
+    // Storage behind the outputs (which are row views of it) and the
+    // working arrays, reused across capture sets
+    struct Buffers {
+        cv::Mat points, brightness, confidence, source;
+        cv::Mat work;                       // transformed points, compacted per stripe
+        std::vector<uint64_t> keys;
+        std::vector<uchar> workBrightness, workConfidence, workSource, partition, keep;
+        std::vector<int> order;             // work indices sorted by partition
+    } buffers;
+};
+
+// sources: up to 64 cameras; clouds may differ in size.
+void fuseClouds(const std::vector<FusionSource>& sources, FusedCloud& result,
+                const FusionParams& params = FusionParams());
+
+// Triggers all cameras at once (one thread each) and fetches
+// getPointcloudData, getDepthData and getBrightnessData into every source,
+// with computeConfidence. Returns 0 on success, -1 on any SDK error.
+int captureFusionSet(std::vector<FusionSource>& sources, int exposureNum = 1,
+                     const ConfidenceParams& confidenceParams = ConfidenceParams());
+
+// captureFusionSet + fuseClouds: one fused cloud per capture set
+int captureFusedCloud(std::vector<FusionSource>& sources, FusedCloud& result, int exposureNum = 1,
+                      const FusionParams& params = FusionParams(),
+                      const ConfidenceParams& confidenceParams = ConfidenceParams());
@@ -0,0 +1,164 @@
+#include "confidence.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <opencv2/core/hal/intrin.hpp>
+
+// ═══════════════════════════════════════════════════════════════════════
+// Confidence
+// ═══════════════════════════════════════════════════════════════════════
+
+void computeConfidence(const cv::Mat& depth, const cv::Mat& brightness, cv::Mat& confidence,
+                       const ConfidenceParams& params) {
+    CV_Assert(depth.type() == CV_32FC1 && brightness.type() == CV_8UC1 && brightness.size() == depth.size());
+    const int rows = depth.rows, cols = depth.cols;
+    const float dark = params.darkLevel, saturation = params.saturationLevel;
+    const float signalScale = 1.0f / std::max(1.0f, params.goodLevel - params.darkLevel);
+    // noise(z)^2 = (noiseAt1000mm * z^2 / 1e6)^2, inverted per pixel
+    const float noiseScale = params.noiseAt1000mm * 1e-6f;
+
+    confidence.create(rows, cols, CV_8UC1);
+
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+        const std::vector<float> invalidRow(cols, 0.0f);
+
+        for (int y = range.start; y < range.end; y++) {
+            const float* zc = depth.ptr<float>(y);
+            const float* zu = y > 0 ? depth.ptr<float>(y - 1) : invalidRow.data();
+            const float* zd = y + 1 < rows ? depth.ptr<float>(y + 1) : invalidRow.data();
+            const uchar* b = brightness.ptr<uchar>(y);
+            uchar* out = confidence.ptr<uchar>(y);
+
+            auto confidencePixel = [&](int x) {
+                const float z = zc[x];
+                if (!(z > 0.0f) || b[x] >= saturation) {
+                    out[x] = 0;
+                    return;
+                }
+                float sum = 0.0f, count = 0.0f;
+                for (int dy = -1; dy <= 1; dy++) {
+                    const float* row = dy < 0 ? zu : (dy > 0 ? zd : zc);
+                    for (int dx = -1; dx <= 1; dx++) {
+                        int xn = x + dx;
+                        if ((dx == 0 && dy == 0) || xn < 0 || xn >= cols || !(row[xn] > 0.0f)) continue;
+                        sum += row[xn];
+                        count += 1.0f;
+                    }
+                }
+                if (count == 0.0f) {
+                    out[x] = 0;
+                    return;
+                }
+                float signal = std::min(1.0f, std::max(0.0f, (b[x] - dark) * signalScale));
+                float noise = noiseScale * z * z;
+                float res = (z - sum / count) / noise;
+                float value = 255.0f * signal * (count * 0.125f) / (1.0f + res * res);
+                out[x] = static_cast<uchar>(value + 0.5f);
+            };
+
+            int x = 0;
+#if CV_SIMD128
+            const cv::v_float32x4 zero = cv::v_setzero_f32(), one = cv::v_setall_f32(1.0f);
+            const cv::v_float32x4 vdark = cv::v_setall_f32(dark), vsat = cv::v_setall_f32(saturation);
+            const cv::v_float32x4 vsignal = cv::v_setall_f32(signalScale), vnoise = cv::v_setall_f32(noiseScale);
+            const cv::v_float32x4 eighth = cv::v_setall_f32(0.125f), v255 = cv::v_setall_f32(255.0f);
+
+            for (; x < std::min(1, cols); x++) confidencePixel(x);
+            for (; x <= cols - 5; x += 4) {
+                const cv::v_float32x4 z = cv::v_load(zc + x);
+                const cv::v_float32x4 vb = cv::v_cvt_f32(cv::v_reinterpret_as_s32(cv::v_load_expand_q(b + x)));
+
+                cv::v_float32x4 sum = zero, count = zero;
+                const float* neighbors[8] = {
+                    zu + x - 1, zu + x, zu + x + 1,
+                    zc + x - 1,         zc + x + 1,
+                    zd + x - 1, zd + x, zd + x + 1
+                };
+                for (int k = 0; k < 8; k++) {
+                    cv::v_float32x4 zn = cv::v_load(neighbors[k]);
+                    cv::v_float32x4 valid = zn > zero;
+                    sum += cv::v_select(valid, zn, zero);
+                    count += cv::v_select(valid, one, zero);
+                }
+
+                cv::v_float32x4 signal = cv::v_min(one, cv::v_max(zero, (vb - vdark) * vsignal));
+                cv::v_float32x4 res = (z - sum / cv::v_max(count, one)) / (vnoise * z * z);
+                cv::v_float32x4 value = v255 * signal * (count * eighth) / cv::v_muladd(res, res, one);
+                cv::v_float32x4 usable = (z > zero) & (vb < vsat) & (count > zero);
+                value = cv::v_select(usable, value, zero);
+
+                int values[4];
+                cv::v_store(values, cv::v_round(value));
+                for (int l = 0; l < 4; l++) out[x + l] = static_cast<uchar>(values[l]);
+            }
+#endif
+            for (; x < cols; x++) confidencePixel(x);
+        }
+    });
+}
+
+void confidenceMask(const cv::Mat& confidence, int minConfidence, cv::Mat& mask) {
+    CV_Assert(confidence.type() == CV_8UC1);
+    mask.create(confidence.size(), CV_8UC1);
+
+    cv::parallel_for_(cv::Range(0, confidence.rows), [&](const cv::Range& range) {
+        for (int r = range.start; r < range.end; r++) {
+            const uchar* c = confidence.ptr<uchar>(r);
+            uchar* m = mask.ptr<uchar>(r);
+            int x = 0;
+#if CV_SIMD128
+            const cv::v_uint8x16 threshold = cv::v_setall_u8(static_cast<uchar>(std::min(255, std::max(0, minConfidence))));
+            for (; x <= confidence.cols - 16; x += 16) {
+                cv::v_store(m + x, cv::v_load(c + x) >= threshold);
+            }
+#endif
+            for (; x < confidence.cols; x++) m[x] = c[x] >= minConfidence ? 255 : 0;
+        }
+    });
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Bundled Fetch
+// ═══════════════════════════════════════════════════════════════════════
+
+int getGrayBrightnessData(XEMA::XCamera* camera, uchar* brightness) {
+    int channels = 0;
+    if (0 != camera->getCameraChannels(&channels)) {
+        std::cerr << "Get Camera Channels Error!" << std::endl;
+        return -1;
+    }
+    // getBrightnessData writes one byte per channel; color cameras are
+    // converted to one gray byte per pixel by the SDK
+    if (1 == channels) return camera->getBrightnessData(brightness);
+    return camera->getColorBrightnessData(brightness, XEMA::XemaColor::Gray);
+}
+
+int fetchDepthFrame(XEMA::XCamera* camera, int exposureNum, DepthFrame& frame) {
+    int width = 0, height = 0;
+    if (0 != camera->getCameraResolution(&width, &height) || width <= 0 || height <= 0) {
+        std::cerr << "Get Camera Resolution Error!" << std::endl;
+        return -1;
+    }
+
+    char timestamp[30] = "";
+    frame.depth.create(height, width, CV_32FC1);
+    frame.brightness.create(height, width, CV_8UC1);
+    if (0 != camera->captureData(exposureNum, timestamp) ||
+        0 != camera->getDepthData(frame.depth.ptr<float>()) ||
+        0 != getGrayBrightnessData(camera, frame.brightness.ptr<uchar>())) {
+        std::cerr << "Capture Data Error!" << std::endl;
+        return -1;
+    }
+    // Results of an earlier capture into the same frame no longer apply
+    frame.confidence.release();
+    frame.modulation.release();
+    frame.exposure = 0.0f;
+    return 0;
+}
+
+int captureDepthFrame(XEMA::XCamera* camera, int exposureNum, DepthFrame& frame, const ConfidenceParams& params) {
+    if (0 != fetchDepthFrame(camera, exposureNum, frame)) return -1;
+    computeConfidence(frame.depth, frame.brightness, frame.confidence, params);
+    return 0;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include "xcamera.h"
+
+// ═══════════════════════════════════════════════════════════════════════
+// Per-Pixel Confidence
+// ═══════════════════════════════════════════════════════════════════════
+//
+// The SDK only exposes the hard cut-offs (setParamCameraConfidence,
+// fisher_confidence); the fringe modulation itself is not transferred and
+// XCamera is the ABI of the shipped library, so no getConfidenceData is
+// added there. This is the host-side estimate from data that is fetched
+// anyway, as a CV_8UC1 map (0 = unusable, 255 = best):
+//
+//   signal   brightness ramp from darkLevel to goodLevel, 0 when saturated
+//   noise    1 / (1 + (res / noise(z))^2), res = z - mean of valid 8-neighbors,
+//            noise(z) = noiseAt1000mm * (z / 1000)^2 (triangulation noise)
+//   support  valid 8-neighbors / 8
+//
+//   confidence = 255 * signal * noise * support
+
+struct ConfidenceParams {
+    float darkLevel = 10.0f;        // brightness with no usable fringe signal
+    float goodLevel = 60.0f;        // brightness from which the signal term is 1
+    float saturationLevel = 250.0f; // brightness from which fringes are clipped
+    float noiseAt1000mm = 0.5f;     // residual (mm) that halves confidence at z = 1000 mm
+};
+
+// depth: CV_32FC1 (z <= 0 invalid), brightness: CV_8UC1, confidence: CV_8UC1.
+// Rows are processed in parallel.
+void computeConfidence(const cv::Mat& depth, const cv::Mat& brightness, cv::Mat& confidence,
+                       const ConfidenceParams& params = ConfidenceParams());
+
+// 255 where confidence >= minConfidence (applyPointMask / radiusOutlierFilter layout)
+void confidenceMask(const cv::Mat& confidence, int minConfidence, cv::Mat& mask);
+
+struct DepthFrame {
+    cv::Mat depth;          // CV_32FC1, getDepthData
+    cv::Mat brightness;     // CV_8UC1, getBrightnessData
+    cv::Mat confidence;     // CV_8UC1, computeConfidence
+    cv::Mat modulation;     // CV_32FC1 fringe modulation (decodeFringes); empty when decoded on the camera
+    float exposure = 0.0f;  // setParamCameraExposure value of the capture, 0 = not set by the host
+};
+
+// Brightness of the last captureData as one gray byte per pixel:
+// getBrightnessData on mono cameras, getColorBrightnessData(Gray) on color
+// ones. Returns 0 on success, -1 on any SDK error.
+int getGrayBrightnessData(XEMA::XCamera* camera, uchar* brightness);
+
+// captureData + getDepthData + getGrayBrightnessData; confidence and modulation
+// are left empty and exposure at 0.
+// Returns 0 on success, -1 on any SDK error.
+int fetchDepthFrame(XEMA::XCamera* camera, int exposureNum, DepthFrame& frame);
+
+// fetchDepthFrame + computeConfidence
+int captureDepthFrame(XEMA::XCamera* camera, int exposureNum, DepthFrame& frame,
+                      const ConfidenceParams& params = ConfidenceParams());
@@ -0,0 +1,156 @@
+#include "depth_cloud.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <opencv2/core/hal/intrin.hpp>
+
+// ═══════════════════════════════════════════════════════════════════════
+// Rays
+// ═══════════════════════════════════════════════════════════════════════
+
+DepthRays makeDepthRays(const cv::Size& size, const float intrinsic[9], const float distortion[12]) {
+    const float fx = intrinsic[0], skew = intrinsic[1], cx = intrinsic[2];
+    const float fy = intrinsic[4], cy = intrinsic[5];
+    const float k1 = distortion ? distortion[0] : 0.0f, k2 = distortion ? distortion[1] : 0.0f;
+    const float p1 = distortion ? distortion[2] : 0.0f, p2 = distortion ? distortion[3] : 0.0f;
+    const float k3 = distortion ? distortion[4] : 0.0f;
+    const bool distorted = k1 != 0.0f || k2 != 0.0f || p1 != 0.0f || p2 != 0.0f || k3 != 0.0f;
+
+    DepthRays rays;
+    rays.x.create(size, CV_32FC1);
+    rays.y.create(size, CV_32FC1);
+
+    cv::parallel_for_(cv::Range(0, size.height), [&](const cv::Range& range) {
+        for (int v = range.start; v < range.end; v++) {
+            float* rx = rays.x.ptr<float>(v);
+            float* ry = rays.y.ptr<float>(v);
+            for (int u = 0; u < size.width; u++) {
+                const float yd = (v - cy) / fy;
+                const float xd = (u - cx - skew * yd) / fx;
+                float x = xd, y = yd;
+
+                // Same fixed-point inversion as cv::undistortPoints
+                for (int iter = 0; distorted && iter < 10; iter++) {
+                    float r2 = x * x + y * y;
+                    float icdist = 1.0f / (1.0f + ((k3 * r2 + k2) * r2 + k1) * r2);
+                    float deltaX = 2.0f * p1 * x * y + p2 * (r2 + 2.0f * x * x);
+                    float deltaY = p1 * (r2 + 2.0f * y * y) + 2.0f * p2 * x * y;
+                    x = (xd - deltaX) * icdist;
+                    y = (yd - deltaY) * icdist;
+                }
+                rx[u] = x;
+                ry[u] = y;
+            }
+        }
+    });
+    return rays;
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Conversion
+// ═══════════════════════════════════════════════════════════════════════
+
+void depthToPointCloud(const cv::Mat& depth, const DepthRays& rays, cv::Mat& cloud,
+                       const DiscontinuityParams& params, cv::Mat* removed) {
+    CV_Assert(depth.type() == CV_32FC1);
+    CV_Assert(rays.x.type() == CV_32FC1 && rays.x.size() == depth.size() && rays.y.size() == depth.size());
+    const int rows = depth.rows, cols = depth.cols;
+    const cv::Rect frame(0, 0, cols, rows);
+    const cv::Rect roi = params.roi.area() > 0 ? params.roi & frame : frame;
+    const int step = std::max(1, params.step);
+    const bool filter = params.thresholdAt1000mm > 0.0f;
+    const float scale = params.thresholdAt1000mm / 1000.0f;
+    const float offset = params.absoluteThreshold;
+    const int minDisagreeing = std::max(1, params.minDisagreeing);
+
+    cloud.create(rows, cols, CV_32FC3);
+    if (removed) removed->create(rows, cols, CV_8UC1);
+
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+        const std::vector<float> invalidRow(cols, 0.0f);
+
+        for (int y = range.start; y < range.end; y++) {
+            const float* zc = depth.ptr<float>(y);
+            const float* zu = y - step >= 0 ? depth.ptr<float>(y - step) : invalidRow.data();
+            const float* zd = y + step < rows ? depth.ptr<float>(y + step) : invalidRow.data();
+            const float* rx = rays.x.ptr<float>(y);
+            const float* ry = rays.y.ptr<float>(y);
+            float* out = cloud.ptr<float>(y);
+            uchar* flags = removed ? removed->ptr<uchar>(y) : nullptr;
+
+            const bool rowFiltered = filter && y >= roi.y && y < roi.y + roi.height;
+            const int fx0 = rowFiltered ? roi.x : cols, fx1 = rowFiltered ? roi.x + roi.width : cols;
+
+            // One pixel with bounds checks, for image borders and tails
+            auto convertPixel = [&](int x) {
+                float z = zc[x];
+                bool drop = false;
+                if (z > 0.0f && x >= fx0 && x < fx1) {
+                    const float threshold = z * scale + offset;
+                    int disagreeing = 0;
+                    for (int dy = -1; dy <= 1; dy++) {
+                        const float* row = dy < 0 ? zu : (dy > 0 ? zd : zc);
+                        for (int dx = -1; dx <= 1; dx++) {
+                            int xn = x + dx * step;
+                            if ((dx == 0 && dy == 0) || xn < 0 || xn >= cols) continue;
+                            float zn = row[xn];
+                            if (zn > 0.0f && std::abs(zn - z) > threshold) disagreeing++;
+                        }
+                    }
+                    drop = disagreeing >= minDisagreeing;
+                }
+                if (flags) flags[x] = drop ? 255 : 0;
+                if (drop || !(z > 0.0f)) z = 0.0f;
+                out[3 * x] = rx[x] * z;
+                out[3 * x + 1] = ry[x] * z;
+                out[3 * x + 2] = z;
+            };
+
+            int x = 0;
+#if CV_SIMD128
+            const cv::v_float32x4 zero = cv::v_setzero_f32(), one = cv::v_setall_f32(1.0f);
+            const cv::v_float32x4 vscale = cv::v_setall_f32(scale), voffset = cv::v_setall_f32(offset);
+            const cv::v_float32x4 vmin = cv::v_setall_f32(static_cast<float>(minDisagreeing));
+
+            // Columns whose whole neighborhood is inside the image
+            const int simdStart = std::min(cols, step), simdEnd = cols - step;
+            for (; x < simdStart; x++) convertPixel(x);
+            for (; x <= simdEnd - 4; x += 4) {
+                cv::v_float32x4 z = cv::v_load(zc + x);
+                cv::v_float32x4 valid = z > zero;
+
+                if (x + 4 > fx0 && x < fx1) {
+                    const cv::v_float32x4 threshold = cv::v_muladd(z, vscale, voffset);
+                    cv::v_float32x4 disagreeing = zero;
+                    const float* neighbors[8] = {
+                        zu + x - step, zu + x, zu + x + step,
+                        zc + x - step,         zc + x + step,
+                        zd + x - step, zd + x, zd + x + step
+                    };
+                    for (int k = 0; k < 8; k++) {
+                        cv::v_float32x4 zn = cv::v_load(neighbors[k]);
+                        cv::v_float32x4 far = (zn > zero) & (cv::v_abs(zn - z) > threshold);
+                        disagreeing += cv::v_select(far, one, zero);
+                    }
+
+                    // Lanes outside the ROI columns are never dropped
+                    float lanes[4];
+                    for (int l = 0; l < 4; l++) lanes[l] = (x + l >= fx0 && x + l < fx1) ? 1.0f : 0.0f;
+                    cv::v_float32x4 drop = (disagreeing >= vmin) & valid & (cv::v_load(lanes) > zero);
+                    if (flags) {
+                        int bits = cv::v_signmask(drop);
+                        for (int l = 0; l < 4; l++) flags[x + l] = (bits >> l) & 1 ? 255 : 0;
+                    }
+                    z = cv::v_select(drop, zero, z);
+                } else if (flags) {
+                    for (int l = 0; l < 4; l++) flags[x + l] = 0;
+                }
+
+                z = cv::v_select(valid, z, zero);
+                cv::v_store_interleave(out + 3 * x, cv::v_load(rx + x) * z, cv::v_load(ry + x) * z, z);
+            }
+#endif
+            for (; x < cols; x++) convertPixel(x);
+        }
+    });
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <opencv2/core.hpp>
+
+// ═══════════════════════════════════════════════════════════════════════
+// Depth to Point Cloud with Discontinuity Removal
+// ═══════════════════════════════════════════════════════════════════════
+//
+// Converts a getDepthData map (CV_32FC1, mm, z <= 0 invalid) into the
+// getPointcloudData layout (CV_32FC3) in one pass. Flying pixels, which
+// are smeared between a foreground edge and the background, are removed
+// in the same pass: a pixel is dropped when at least minDisagreeing of its
+// 8 neighbors (at `step` pixels) differ from it in depth by more than
+//
+//     thresholdAt1000mm * z / 1000 + absoluteThreshold
+//
+// The linear scaling follows the pixel footprint, which grows with z.
+// Invalid neighbors are ignored.
+
+// Per-pixel viewing rays: a pixel at depth z is (x * z, y * z, z)
+struct DepthRays {
+    cv::Mat x;      // CV_32FC1, undistorted normalized x
+    cv::Mat y;      // CV_32FC1, undistorted normalized y
+};
+
+// From CalibrationParam::intrinsic (3x3 row-major) and ::distortion
+// (k1, k2, p1, p2, k3 used; nullptr = no distortion)
+DepthRays makeDepthRays(const cv::Size& size, const float intrinsic[9], const float distortion[12] = nullptr);
+
+struct DiscontinuityParams {
+    cv::Rect roi;                       // filtered region; empty = whole frame, outside is converted only
+    float thresholdAt1000mm = 3.0f;     // mm of depth disagreement at z = 1000 mm; <= 0 disables removal
+    float absoluteThreshold = 0.0f;     // mm added to the scaled threshold
+    int minDisagreeing = 1;             // 1 also trims the foreground edge; 3-4 keeps true step edges
+    int step = 1;                       // neighbor distance (pixels); 2 catches two-pixel-wide smears
+};
+
+// cloud: CV_32FC3, removed and invalid pixels are (0, 0, 0).
+// removed (optional): CV_8UC1, 255 where a valid pixel was dropped.
+// Rows are processed in parallel.
+void depthToPointCloud(const cv::Mat& depth, const DepthRays& rays, cv::Mat& cloud,
+                       const DiscontinuityParams& params = DiscontinuityParams(), cv::Mat* removed = nullptr);
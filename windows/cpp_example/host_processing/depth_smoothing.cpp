@@ -0,0 +1,427 @@
+#include "depth_smoothing.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <utility>
+#include <vector>
+#include <opencv2/core/hal/intrin.hpp>
+
+// ═══════════════════════════════════════════════════════════════════════
+// Helpers
+// ═══════════════════════════════════════════════════════════════════════
+
+static cv::Rect filterRoi(const cv::Rect& roi, const cv::Size& size) {
+    const cv::Rect frame(0, 0, size.width, size.height);
+    return roi.area() > 0 ? roi & frame : frame;
+}
+
+// Depth copied into a frame of `pad` invalid (zero) pixels, so window
+// loads need no bounds checks
+static cv::Mat padDepth(const cv::Mat& depth, int pad) {
+    cv::Mat padded = cv::Mat::zeros(depth.rows + 2 * pad, depth.cols + 2 * pad, CV_32FC1);
+    cv::Mat inner = padded(cv::Rect(pad, pad, depth.cols, depth.rows));
+    depth.copyTo(inner);
+    return padded;
+}
+
+// Copies the input to dst unless dst already is the input, so only the ROI
+// has to be written afterwards
+static void prepareOutput(const cv::Mat& depth, cv::Mat& dst) {
+    if (dst.data == depth.data && dst.size() == depth.size() && dst.type() == depth.type()) return;
+    depth.copyTo(dst);
+}
+
+#if CV_SIMD128
+// exp(x) for x <= 0: 2^i * 2^f with a degree-5 polynomial for 2^f, f in [0, 1)
+static inline cv::v_float32x4 v_exp_neg(const cv::v_float32x4& x) {
+    const cv::v_float32x4 t = cv::v_max(x * cv::v_setall_f32(1.44269504f), cv::v_setall_f32(-126.0f));
+    const cv::v_int32x4 i = cv::v_floor(t);
+    const cv::v_float32x4 f = t - cv::v_cvt_f32(i);
+    cv::v_float32x4 p = cv::v_setall_f32(1.33335581e-3f);
+    p = cv::v_muladd(p, f, cv::v_setall_f32(9.61812911e-3f));
+    p = cv::v_muladd(p, f, cv::v_setall_f32(5.55041087e-2f));
+    p = cv::v_muladd(p, f, cv::v_setall_f32(2.40226507e-1f));
+    p = cv::v_muladd(p, f, cv::v_setall_f32(6.93147181e-1f));
+    p = cv::v_muladd(p, f, cv::v_setall_f32(1.0f));
+    const cv::v_float32x4 scale = cv::v_reinterpret_as_f32((i + cv::v_setall_s32(127)) << 23);
+    return p * scale;
+}
+#endif
+
+// ═══════════════════════════════════════════════════════════════════════
+// Bilateral
+// ═══════════════════════════════════════════════════════════════════════
+
+struct KernelTap {
+    int dx, dy;
+    float weight;
+};
+
+void bilateralDepthFilter(const cv::Mat& depth, cv::Mat& dst, const BilateralDepthParams& params) {
+    CV_Assert(depth.type() == CV_32FC1);
+    const cv::Rect roi = filterRoi(params.roi, depth.size());
+    const int r = std::max(1, params.radius);
+    const cv::Mat padded = padDepth(depth, r);
+    prepareOutput(depth, dst);
+
+    // Spatial weights of the disc, center excluded (it always has weight 1)
+    std::vector<KernelTap> taps;
+    const float spatialScale = -0.5f / (params.sigmaSpatial * params.sigmaSpatial);
+    for (int dy = -r; dy <= r; dy++) {
+        for (int dx = -r; dx <= r; dx++) {
+            if ((dx == 0 && dy == 0) || dx * dx + dy * dy > r * r) continue;
+            KernelTap t = { dx, dy, std::exp(spatialScale * (dx * dx + dy * dy)) };
+            taps.push_back(t);
+        }
+    }
+    const float rangeScale = -0.5f / (params.sigmaDepth * params.sigmaDepth);
+    const float cutoff = 3.0f * params.sigmaDepth;
+
+    cv::parallel_for_(cv::Range(roi.y, roi.y + roi.height), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; y++) {
+            const float* center = padded.ptr<float>(y + r) + r;
+            float* out = dst.ptr<float>(y);
+
+            int x = roi.x;
+#if CV_SIMD128
+            const cv::v_float32x4 zero = cv::v_setzero_f32(), one = cv::v_setall_f32(1.0f);
+            const cv::v_float32x4 vRangeScale = cv::v_setall_f32(rangeScale), vCutoff = cv::v_setall_f32(cutoff);
+            for (; x <= roi.x + roi.width - 4; x += 4) {
+                const cv::v_float32x4 zc = cv::v_load(center + x);
+                cv::v_float32x4 sumW = one, sumWZ = zc;
+                for (const KernelTap& t : taps) {
+                    cv::v_float32x4 z = cv::v_load(center + t.dy * padded.cols + x + t.dx);
+                    cv::v_float32x4 d = z - zc;
+                    cv::v_float32x4 w = cv::v_setall_f32(t.weight) * v_exp_neg(d * d * vRangeScale);
+                    w = cv::v_select((z > zero) & (cv::v_abs(d) < vCutoff), w, zero);
+                    sumW += w;
+                    sumWZ = cv::v_muladd(w, z, sumWZ);
+                }
+                cv::v_store(out + x, cv::v_select(zc > zero, sumWZ / sumW, zero));
+            }
+#endif
+            for (; x < roi.x + roi.width; x++) {
+                const float zc = center[x];
+                if (!(zc > 0.0f)) {
+                    out[x] = 0.0f;
+                    continue;
+                }
+                float sumW = 1.0f, sumWZ = zc;
+                for (const KernelTap& t : taps) {
+                    float z = center[t.dy * padded.cols + x + t.dx];
+                    float d = z - zc;
+                    if (!(z > 0.0f) || std::abs(d) >= cutoff) continue;
+                    float w = t.weight * std::exp(d * d * rangeScale);
+                    sumW += w;
+                    sumWZ += w * z;
+                }
+                out[x] = sumWZ / sumW;
+            }
+        }
+    });
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Guided
+// ═══════════════════════════════════════════════════════════════════════
+
+// Window sums of a CV_32FC1 plane, pixels outside the image count as 0.
+// Horizontal running sums (double) per row, then a direct vertical sum
+// over 4 columns at a time, so no error accumulates down the image.
+static void boxSum(const cv::Mat& src, cv::Mat& dst, int r) {
+    const int rows = src.rows, cols = src.cols;
+    cv::Mat horizontal(rows, cols, CV_32FC1);
+
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; y++) {
+            const float* s = src.ptr<float>(y);
+            float* h = horizontal.ptr<float>(y);
+            double acc = 0.0;
+            for (int x = 0; x < std::min(r, cols); x++) acc += s[x];
+            for (int x = 0; x < cols; x++) {
+                if (x + r < cols) acc += s[x + r];
+                if (x - r - 1 >= 0) acc -= s[x - r - 1];
+                h[x] = static_cast<float>(acc);
+            }
+        }
+    });
+
+    dst.create(rows, cols, CV_32FC1);
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; y++) {
+            const int y0 = std::max(0, y - r), y1 = std::min(rows - 1, y + r);
+            float* d = dst.ptr<float>(y);
+            int x = 0;
+#if CV_SIMD128
+            for (; x <= cols - 4; x += 4) {
+                cv::v_float32x4 acc = cv::v_setzero_f32();
+                for (int yy = y0; yy <= y1; yy++) acc += cv::v_load(horizontal.ptr<float>(yy) + x);
+                cv::v_store(d + x, acc);
+            }
+#endif
+            for (; x < cols; x++) {
+                float acc = 0.0f;
+                for (int yy = y0; yy <= y1; yy++) acc += horizontal.ptr<float>(yy)[x];
+                d[x] = acc;
+            }
+        }
+    });
+}
+
+void guidedDepthFilter(const cv::Mat& depth, const cv::Mat& brightness, cv::Mat& dst, const GuidedDepthParams& params) {
+    CV_Assert(depth.type() == CV_32FC1 && brightness.type() == CV_8UC1 && brightness.size() == depth.size());
+    const cv::Rect roi = filterRoi(params.roi, depth.size());
+    const int r = std::max(1, params.radius);
+
+    // Both box passes read r pixels around the ROI
+    const cv::Rect crop = cv::Rect(roi.x - 2 * r, roi.y - 2 * r, roi.width + 4 * r, roi.height + 4 * r)
+                          & cv::Rect(0, 0, depth.cols, depth.rows);
+    const cv::Mat p = depth(crop).clone();
+    const cv::Mat guide = brightness(crop);
+    const int rows = crop.height, cols = crop.width;
+
+    // Depth relative to a reference keeps the float moments small
+    double refSum = 0.0;
+    int refCount = 0;
+    for (int y = 0; y < rows; y += 8) {
+        const float* row = p.ptr<float>(y);
+        for (int x = 0; x < cols; x += 8) {
+            if (row[x] > 0.0f) {
+                refSum += row[x];
+                refCount++;
+            }
+        }
+    }
+    const float ref = refCount > 0 ? static_cast<float>(refSum / refCount) : 0.0f;
+
+    // 1. Masked moments: v, v*I, v*p, v*I*I, v*I*p
+    enum { V, VI, VP, VII, VIP, NUM_MOMENTS };
+    cv::Mat moments[NUM_MOMENTS], sums[NUM_MOMENTS];
+    for (int k = 0; k < NUM_MOMENTS; k++) moments[k].create(rows, cols, CV_32FC1);
+    cv::Mat guideF(rows, cols, CV_32FC1);
+
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; y++) {
+            const float* pr = p.ptr<float>(y);
+            const uchar* gr = guide.ptr<uchar>(y);
+            float* ir = guideF.ptr<float>(y);
+            float* m[NUM_MOMENTS];
+            for (int k = 0; k < NUM_MOMENTS; k++) m[k] = moments[k].ptr<float>(y);
+
+            int x = 0;
+#if CV_SIMD128
+            const cv::v_float32x4 zero = cv::v_setzero_f32(), one = cv::v_setall_f32(1.0f);
+            const cv::v_float32x4 vref = cv::v_setall_f32(ref), inv255 = cv::v_setall_f32(1.0f / 255.0f);
+            for (; x <= cols - 4; x += 4) {
+                cv::v_float32x4 z = cv::v_load(pr + x);
+                cv::v_float32x4 i = cv::v_cvt_f32(cv::v_reinterpret_as_s32(cv::v_load_expand_q(gr + x))) * inv255;
+                cv::v_float32x4 v = cv::v_select(z > zero, one, zero);
+                cv::v_float32x4 vi = v * i, vp = v * (z - vref);
+                cv::v_store(ir + x, i);
+                cv::v_store(m[V] + x, v);
+                cv::v_store(m[VI] + x, vi);
+                cv::v_store(m[VP] + x, vp);
+                cv::v_store(m[VII] + x, vi * i);
+                cv::v_store(m[VIP] + x, vp * i);
+            }
+#endif
+            for (; x < cols; x++) {
+                float i = gr[x] / 255.0f;
+                float v = pr[x] > 0.0f ? 1.0f : 0.0f;
+                float vp = v * (pr[x] - ref);
+                ir[x] = i;
+                m[V][x] = v;
+                m[VI][x] = v * i;
+                m[VP][x] = vp;
+                m[VII][x] = v * i * i;
+                m[VIP][x] = vp * i;
+            }
+        }
+    });
+    for (int k = 0; k < NUM_MOMENTS; k++) boxSum(moments[k], sums[k], r);
+
+    // 2. Per-window linear model depth = a * I + b, weighted by validity
+    cv::Mat va(rows, cols, CV_32FC1), vb(rows, cols, CV_32FC1);
+    const float eps = params.eps;
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; y++) {
+            const float* n = sums[V].ptr<float>(y);
+            const float* si = sums[VI].ptr<float>(y);
+            const float* sp = sums[VP].ptr<float>(y);
+            const float* sii = sums[VII].ptr<float>(y);
+            const float* sip = sums[VIP].ptr<float>(y);
+            const float* v = moments[V].ptr<float>(y);
+            float* ar = va.ptr<float>(y);
+            float* br = vb.ptr<float>(y);
+
+            int x = 0;
+#if CV_SIMD128
+            const cv::v_float32x4 zero = cv::v_setzero_f32(), half = cv::v_setall_f32(0.5f);
+            const cv::v_float32x4 veps = cv::v_setall_f32(eps);
+            for (; x <= cols - 4; x += 4) {
+                cv::v_float32x4 vn = cv::v_load(n + x);
+                cv::v_float32x4 has = vn > half;
+                cv::v_float32x4 inv = cv::v_select(has, cv::v_setall_f32(1.0f) / cv::v_max(vn, half), zero);
+                cv::v_float32x4 mi = cv::v_load(si + x) * inv, mp = cv::v_load(sp + x) * inv;
+                cv::v_float32x4 var = cv::v_load(sii + x) * inv - mi * mi;
+                cv::v_float32x4 cov = cv::v_load(sip + x) * inv - mi * mp;
+                cv::v_float32x4 a = cov / (cv::v_max(var, zero) + veps);
+                cv::v_float32x4 b = mp - a * mi;
+                cv::v_float32x4 w = cv::v_load(v + x);
+                cv::v_store(ar + x, cv::v_select(has, a * w, zero));
+                cv::v_store(br + x, cv::v_select(has, b * w, zero));
+            }
+#endif
+            for (; x < cols; x++) {
+                if (!(n[x] > 0.5f)) {
+                    ar[x] = br[x] = 0.0f;
+                    continue;
+                }
+                float inv = 1.0f / n[x];
+                float mi = si[x] * inv, mp = sp[x] * inv;
+                float var = std::max(0.0f, sii[x] * inv - mi * mi);
+                float a = (sip[x] * inv - mi * mp) / (var + eps);
+                ar[x] = a * v[x];
+                br[x] = (mp - a * mi) * v[x];
+            }
+        }
+    });
+    cv::Mat sa, sb;
+    boxSum(va, sa, r);
+    boxSum(vb, sb, r);
+
+    // 3. Averaged model applied to the guide, inside the ROI only
+    prepareOutput(depth, dst);
+    const float maxJump = params.maxDepthJump;
+    cv::parallel_for_(cv::Range(roi.y, roi.y + roi.height), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; y++) {
+            const int cy = y - crop.y, cx0 = roi.x - crop.x;
+            const float* n = sums[V].ptr<float>(cy) + cx0;
+            const float* a = sa.ptr<float>(cy) + cx0;
+            const float* b = sb.ptr<float>(cy) + cx0;
+            const float* i = guideF.ptr<float>(cy) + cx0;
+            const float* z = p.ptr<float>(cy) + cx0;
+            float* out = dst.ptr<float>(y) + roi.x;
+
+            int x = 0;
+#if CV_SIMD128
+            const cv::v_float32x4 zero = cv::v_setzero_f32(), half = cv::v_setall_f32(0.5f);
+            const cv::v_float32x4 vref = cv::v_setall_f32(ref), vjump = cv::v_setall_f32(maxJump);
+            for (; x <= roi.width - 4; x += 4) {
+                cv::v_float32x4 vz = cv::v_load(z + x);
+                cv::v_float32x4 vn = cv::v_max(cv::v_load(n + x), half);
+                cv::v_float32x4 q = (cv::v_load(a + x) * cv::v_load(i + x) + cv::v_load(b + x)) / vn + vref;
+                cv::v_float32x4 keep = cv::v_abs(q - vz) <= vjump;
+                cv::v_store(out + x, cv::v_select(vz > zero, cv::v_select(keep, q, vz), zero));
+            }
+#endif
+            for (; x < roi.width; x++) {
+                if (!(z[x] > 0.0f)) {
+                    out[x] = 0.0f;
+                    continue;
+                }
+                float q = (a[x] * i[x] + b[x]) / std::max(n[x], 0.5f) + ref;
+                out[x] = std::abs(q - z[x]) <= maxJump ? q : z[x];
+            }
+        }
+    });
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Median
+// ═══════════════════════════════════════════════════════════════════════
+
+// Batcher odd-even merge sort for n values. Slots >= n are padded with
+// +FLT_MAX; a comparator touching a padded slot never moves it, so those
+// comparators are dropped.
+static std::vector<std::pair<int, int>> sortingNetwork(int n) {
+    int size = 1;
+    while (size < n) size <<= 1;
+
+    std::vector<std::pair<int, int>> network;
+    for (int p = 1; p < size; p <<= 1) {
+        for (int k = p; k > 0; k >>= 1) {
+            for (int j = k % p; j + k < size; j += 2 * k) {
+                for (int i = 0; i < k && i + j + k < size; i++) {
+                    int a = i + j, b = i + j + k;
+                    if (a / (2 * p) == b / (2 * p) && b < n) network.push_back(std::make_pair(a, b));
+                }
+            }
+        }
+    }
+    return network;
+}
+
+void medianDepthFilter(const cv::Mat& depth, cv::Mat& dst, const MedianDepthParams& params) {
+    CV_Assert(depth.type() == CV_32FC1);
+    const cv::Rect roi = filterRoi(params.roi, depth.size());
+    const int r = std::min(3, std::max(1, params.radius));
+    const int side = 2 * r + 1, n = side * side;
+    const cv::Mat padded = padDepth(depth, r);
+    prepareOutput(depth, dst);
+
+    const std::vector<std::pair<int, int>> network = sortingNetwork(n);
+
+    cv::parallel_for_(cv::Range(roi.y, roi.y + roi.height), [&](const cv::Range& range) {
+        std::vector<float> window(n);
+#if CV_SIMD128
+        std::vector<cv::v_float32x4> lanes(n);
+        float sorted[4];
+#endif
+        for (int y = range.start; y < range.end; y++) {
+            const float* top = padded.ptr<float>(y);
+            const float* center = padded.ptr<float>(y + r) + r;
+            float* out = dst.ptr<float>(y);
+
+            int x = roi.x;
+#if CV_SIMD128
+            const cv::v_float32x4 zero = cv::v_setzero_f32(), one = cv::v_setall_f32(1.0f);
+            const cv::v_float32x4 invalid = cv::v_setall_f32(FLT_MAX);
+            for (; x <= roi.x + roi.width - 4; x += 4) {
+                cv::v_float32x4 count = zero;
+                for (int dy = 0, k = 0; dy < side; dy++) {
+                    const float* row = top + dy * padded.cols + x;
+                    for (int dx = 0; dx < side; dx++, k++) {
+                        cv::v_float32x4 z = cv::v_load(row + dx);
+                        cv::v_float32x4 valid = z > zero;
+                        lanes[k] = cv::v_select(valid, z, invalid);
+                        count += cv::v_select(valid, one, zero);
+                    }
+                }
+                for (const auto& c : network) {
+                    cv::v_float32x4 lo = cv::v_min(lanes[c.first], lanes[c.second]);
+                    lanes[c.second] = cv::v_max(lanes[c.first], lanes[c.second]);
+                    lanes[c.first] = lo;
+                }
+
+                // Median rank differs per lane with its number of valid pixels
+                float counts[4];
+                cv::v_store(counts, count);
+                for (int l = 0; l < 4; l++) {
+                    if (!(center[x + l] > 0.0f)) {
+                        out[x + l] = 0.0f;
+                        continue;
+                    }
+                    cv::v_store(sorted, lanes[(static_cast<int>(counts[l]) - 1) / 2]);
+                    out[x + l] = sorted[l];
+                }
+            }
+#endif
+            for (; x < roi.x + roi.width; x++) {
+                if (!(center[x] > 0.0f)) {
+                    out[x] = 0.0f;
+                    continue;
+                }
+                int count = 0;
+                for (int dy = 0; dy < side; dy++) {
+                    const float* row = top + dy * padded.cols + x;
+                    for (int dx = 0; dx < side; dx++) {
+                        if (row[dx] > 0.0f) window[count++] = row[dx];
+                    }
+                }
+                std::nth_element(window.begin(), window.begin() + (count - 1) / 2, window.begin() + count);
+                out[x] = window[(count - 1) / 2];
+            }
+        }
+    });
+}
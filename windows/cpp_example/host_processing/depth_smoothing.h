@@ -0,0 +1,46 @@
+#pragma once
+#include <opencv2/core.hpp>
+
+// ═══════════════════════════════════════════════════════════════════════
+// Depth Smoothing
+// ═══════════════════════════════════════════════════════════════════════
+//
+// Host-side alternatives to setParamSmoothing / use_bilateral_filter for
+// getDepthData maps (CV_32FC1, mm, z <= 0 invalid). Invalid pixels never
+// contribute to a neighbor and stay invalid; holes are not filled.
+//
+// Each filter only changes its ROI (empty = whole frame) and reads the
+// pixels around it, so raw depth can be fetched once and smoothed with a
+// different filter per region. dst may be the same Mat as depth.
+
+struct BilateralDepthParams {
+    cv::Rect roi;                   // filtered region; empty = whole frame
+    int radius = 3;                 // pixel half-window (bilateral_filter_param_d = 2 * radius + 1)
+    float sigmaSpatial = 3.0f;      // pixels
+    float sigmaDepth = 0.5f;        // mm; neighbors beyond 3 sigmaDepth get zero weight
+};
+
+struct GuidedDepthParams {
+    cv::Rect roi;                   // filtered region; empty = whole frame
+    int radius = 4;                 // box half-window (pixels)
+    float eps = 1e-3f;              // regularization on the brightness variance (guide in [0, 1])
+    float maxDepthJump = 2.0f;      // mm; pixels moved further than this keep their raw depth
+};
+
+struct MedianDepthParams {
+    cv::Rect roi;                   // filtered region; empty = whole frame
+    int radius = 1;                 // 1 = 3x3, 2 = 5x5, 3 = 7x7
+};
+
+// Gaussian bilateral over the (2 * radius + 1)^2 disc
+void bilateralDepthFilter(const cv::Mat& depth, cv::Mat& dst,
+                          const BilateralDepthParams& params = BilateralDepthParams());
+
+// Guided filter (He et al.) with the brightness image (CV_8UC1) as guide:
+// depth follows brightness edges and is flattened where brightness is flat
+void guidedDepthFilter(const cv::Mat& depth, const cv::Mat& brightness, cv::Mat& dst,
+                       const GuidedDepthParams& params = GuidedDepthParams());
+
+// Median of the valid pixels in the window (sorting network, 4 pixels per SIMD lane set)
+void medianDepthFilter(const cv::Mat& depth, cv::Mat& dst,
+                       const MedianDepthParams& params = MedianDepthParams());
@@ -0,0 +1,566 @@
+#include "golden_compare.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <opencv2/core/hal/intrin.hpp>
+
+namespace {
+
+const int kScoreBands = 16;
+const char kGoldenMagic[4] = {'X', 'G', 'H', 'M'};
+
+double elapsedMs(int64 start) {
+    return (cv::getTickCount() - start) * 1000.0 / cv::getTickFrequency();
+}
+
+// 2x2 mean of the valid pixels; NaN where all four are invalid
+void downsampleHeights(const cv::Mat& src, cv::Mat& dst) {
+    dst.create(src.rows / 2, src.cols / 2, CV_32FC1);
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    cv::parallel_for_(cv::Range(0, dst.rows), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; y++) {
+            const float* a = src.ptr<float>(2 * y);
+            const float* b = src.ptr<float>(2 * y + 1);
+            float* out = dst.ptr<float>(y);
+            for (int x = 0; x < dst.cols; x++) {
+                const float v[4] = {a[2 * x], a[2 * x + 1], b[2 * x], b[2 * x + 1]};
+                float sum = 0.0f;
+                int n = 0;
+                for (float h : v) {
+                    if (h == h) {
+                        sum += h;
+                        n++;
+                    }
+                }
+                out[x] = n ? sum / n : nan;
+            }
+        }
+    });
+}
+
+void buildPyramid(const cv::Mat& heightMap, int levels, std::vector<cv::Mat>& pyramid) {
+    pyramid.assign(1, heightMap);
+    while (static_cast<int>(pyramid.size()) < levels && pyramid.back().rows >= 16 && pyramid.back().cols >= 16) {
+        cv::Mat next;
+        downsampleHeights(pyramid.back(), next);
+        pyramid.push_back(next);
+    }
+}
+
+cv::Rect levelRoi(const cv::Rect& roi, int level, const cv::Size& size) {
+    const cv::Rect r(roi.x >> level, roi.y >> level, roi.width >> level, roi.height >> level);
+    return r & cv::Rect(0, 0, size.width, size.height);
+}
+
+int countValid(const cv::Mat& heights, const cv::Rect& roi) {
+    int n = 0;
+    for (int y = roi.y; y < roi.y + roi.height; y++) {
+        const float* h = heights.ptr<float>(y);
+        for (int x = roi.x; x < roi.x + roi.width; x++) n += h[x] == h[x];
+    }
+    return n;
+}
+
+struct DiffSums {
+    double n = 0, s = 0, ss = 0;
+};
+
+// Sums of d = live - ref over pixels where both are valid (d is NaN otherwise)
+void diffRow(const float* ref, const float* live, int len, DiffSums& sums) {
+    float n = 0, s = 0, ss = 0;
+    int x = 0;
+#if CV_SIMD128
+    const cv::v_float32x4 zero = cv::v_setzero_f32(), one = cv::v_setall_f32(1.0f);
+    cv::v_float32x4 vn = zero, vs = zero, vss = zero;
+    for (; x <= len - 4; x += 4) {
+        const cv::v_float32x4 d = cv::v_load(live + x) - cv::v_load(ref + x);
+        const cv::v_float32x4 ok = d == d;
+        const cv::v_float32x4 dz = cv::v_select(ok, d, zero);
+        vn += cv::v_select(ok, one, zero);
+        vs += dz;
+        vss += dz * dz;
+    }
+    n = cv::v_reduce_sum(vn);
+    s = cv::v_reduce_sum(vs);
+    ss = cv::v_reduce_sum(vss);
+#endif
+    for (; x < len; x++) {
+        const float d = live[x] - ref[x];
+        if (!(d == d)) continue;
+        n += 1.0f;
+        s += d;
+        ss += d * d;
+    }
+    sums.n += n;
+    sums.s += s;
+    sums.ss += ss;
+}
+
+// Overlap sums of every shift; tasks are shift x row band, reduced per
+// shift in band order.
+void scoreShifts(const cv::Mat& ref, const cv::Mat& live, const cv::Rect& roi,
+                 const std::vector<cv::Point>& shifts, std::vector<DiffSums>& sums) {
+    const int bands = std::max(1, std::min(kScoreBands, roi.height));
+    std::vector<DiffSums> partial(shifts.size() * bands);
+    cv::parallel_for_(cv::Range(0, static_cast<int>(partial.size())), [&](const cv::Range& range) {
+        for (int t = range.start; t < range.end; t++) {
+            const cv::Point& shift = shifts[t / bands];
+            const int band = t % bands;
+            const int y0 = roi.y + roi.height * band / bands;
+            const int y1 = roi.y + roi.height * (band + 1) / bands;
+            const int x0 = std::max(roi.x, -shift.x);
+            const int x1 = std::min(roi.x + roi.width, live.cols - shift.x);
+            if (x1 <= x0) continue;
+            for (int y = y0; y < y1; y++) {
+                const int ly = y + shift.y;
+                if (ly < 0 || ly >= live.rows) continue;
+                diffRow(ref.ptr<float>(y) + x0, live.ptr<float>(ly) + x0 + shift.x, x1 - x0, partial[t]);
+            }
+        }
+    });
+
+    sums.assign(shifts.size(), DiffSums());
+    for (size_t i = 0; i < shifts.size(); i++) {
+        for (int b = 0; b < bands; b++) {
+            const DiffSums& p = partial[i * bands + b];
+            sums[i].n += p.n;
+            sums[i].s += p.s;
+            sums[i].ss += p.ss;
+        }
+    }
+}
+
+double shiftScore(const DiffSums& d, double minOverlap, bool removeOffset) {
+    if (d.n < std::max(minOverlap, 1.0)) return DBL_MAX;
+    const double mean = removeOffset ? d.s / d.n : 0.0;
+    return d.ss / d.n - mean * mean;
+}
+
+// Hill climb over the 8-neighborhood; leaves the 3x3 scores around the
+// result in scores (row-major, center at 4). At the iteration cap the
+// climb stops at the last scored center, so the scores stay consistent.
+cv::Point climb(const cv::Mat& ref, const cv::Mat& live, const cv::Rect& roi, cv::Point start,
+                double minOverlap, bool removeOffset, double scores[9]) {
+    const int maxIterations = 16;
+    cv::Point cur = start;
+    std::vector<cv::Point> shifts(9);
+    std::vector<DiffSums> sums;
+    for (int iteration = 0; iteration < maxIterations; iteration++) {
+        for (int i = 0; i < 9; i++) shifts[i] = cur + cv::Point(i % 3 - 1, i / 3 - 1);
+        scoreShifts(ref, live, roi, shifts, sums);
+        int best = 4;
+        for (int i = 0; i < 9; i++) {
+            scores[i] = shiftScore(sums[i], minOverlap, removeOffset);
+            if (scores[i] < scores[best]) best = i;
+        }
+        if (best == 4 || iteration == maxIterations - 1) break;
+        cur = shifts[best];
+    }
+    return cur;
+}
+
+// Vertex of the parabola through (-1, a), (0, b), (1, c), within +-0.5
+float parabolaPeak(double a, double b, double c) {
+    if (a == DBL_MAX || c == DBL_MAX) return 0.0f;
+    const double curvature = a - 2.0 * b + c;
+    if (curvature <= 0.0) return 0.0f;
+    return static_cast<float>(std::min(std::max(0.5 * (a - c) / curvature, -0.5), 0.5));
+}
+
+// Gauss-Newton on the bilinear interpolant of the live map: minimizes
+// sum (live(p + shift) - ref(p) - offset)^2 over shift (and offset).
+cv::Point2f refineShift(const cv::Mat& ref, const cv::Mat& live, const cv::Rect& roi, cv::Point2f shift,
+                        bool removeOffset) {
+    for (int iteration = 0; iteration < 5; iteration++) {
+        const int ix = static_cast<int>(std::floor(shift.x)), iy = static_cast<int>(std::floor(shift.y));
+        const float ax = shift.x - ix, ay = shift.y - iy;
+        const int x0 = std::max(roi.x, -ix), x1 = std::min(roi.x + roi.width, live.cols - 1 - ix);
+        if (x1 <= x0) break;
+
+        // Per row: n, gx, gy, gx^2, gx*gy, gy^2, e, gx*e, gy*e
+        std::vector<cv::Vec<double, 9>> rowSums(roi.height, cv::Vec<double, 9>::all(0.0));
+        cv::parallel_for_(cv::Range(0, roi.height), [&](const cv::Range& range) {
+            for (int r = range.start; r < range.end; r++) {
+                const int y = roi.y + r, ly = y + iy;
+                if (ly < 0 || ly + 1 >= live.rows) continue;
+                const float* a = live.ptr<float>(ly) + ix;
+                const float* b = live.ptr<float>(ly + 1) + ix;
+                const float* h = ref.ptr<float>(y);
+                float acc[9] = {0};
+                int x = x0;
+#if CV_SIMD128
+                const cv::v_float32x4 zero = cv::v_setzero_f32(), one = cv::v_setall_f32(1.0f);
+                const cv::v_float32x4 vax = cv::v_setall_f32(ax), vay = cv::v_setall_f32(ay);
+                const cv::v_float32x4 vby = cv::v_setall_f32(1 - ay);
+                cv::v_float32x4 v[9] = {zero, zero, zero, zero, zero, zero, zero, zero, zero};
+                for (; x <= x1 - 4; x += 4) {
+                    const cv::v_float32x4 a0 = cv::v_load(a + x), a1 = cv::v_load(a + x + 1);
+                    const cv::v_float32x4 b0 = cv::v_load(b + x), b1 = cv::v_load(b + x + 1);
+                    const cv::v_float32x4 top = a0 + vax * (a1 - a0), bottom = b0 + vax * (b1 - b0);
+                    const cv::v_float32x4 e = top + vay * (bottom - top) - cv::v_load(h + x);
+                    const cv::v_float32x4 ok = e == e;
+                    const cv::v_float32x4 gx = cv::v_select(ok, vby * (a1 - a0) + vay * (b1 - b0), zero);
+                    const cv::v_float32x4 gy = cv::v_select(ok, bottom - top, zero);
+                    const cv::v_float32x4 ez = cv::v_select(ok, e, zero);
+                    v[0] += cv::v_select(ok, one, zero);
+                    v[1] += gx;
+                    v[2] += gy;
+                    v[3] += gx * gx;
+                    v[4] += gx * gy;
+                    v[5] += gy * gy;
+                    v[6] += ez;
+                    v[7] += gx * ez;
+                    v[8] += gy * ez;
+                }
+                for (int k = 0; k < 9; k++) acc[k] = cv::v_reduce_sum(v[k]);
+#endif
+                for (; x < x1; x++) {
+                    const float top = a[x] + ax * (a[x + 1] - a[x]), bottom = b[x] + ax * (b[x + 1] - b[x]);
+                    const float e = top + ay * (bottom - top) - h[x];
+                    if (!(e == e)) continue;
+                    const float gx = (1 - ay) * (a[x + 1] - a[x]) + ay * (b[x + 1] - b[x]);
+                    const float gy = bottom - top;
+                    const float g[9] = {1.0f, gx, gy, gx * gx, gx * gy, gy * gy, e, gx * e, gy * e};
+                    for (int k = 0; k < 9; k++) acc[k] += g[k];
+                }
+                for (int k = 0; k < 9; k++) rowSums[r][k] = acc[k];
+            }
+        });
+
+        cv::Vec<double, 9> S = cv::Vec<double, 9>::all(0.0);
+        for (const cv::Vec<double, 9>& row : rowSums) S += row;
+        if (S[0] < 3) break;
+
+        // Residual model e + gx*dx + gy*dy - offset
+        cv::Vec2d step;
+        if (removeOffset) {
+            const cv::Matx33d A(S[3], S[4], -S[1], S[4], S[5], -S[2], -S[1], -S[2], S[0]);
+            if (cv::determinant(A) <= 1e-12 * S[0] * S[0] * S[0]) break;
+            const cv::Vec3d theta = A.solve(cv::Vec3d(-S[7], -S[8], S[6]), cv::DECOMP_CHOLESKY);
+            step = cv::Vec2d(theta[0], theta[1]);
+        } else {
+            const double det = S[3] * S[5] - S[4] * S[4];
+            if (det <= 1e-12 * S[0] * S[0]) break;
+            step = cv::Vec2d((-S[7] * S[5] + S[8] * S[4]) / det, (-S[8] * S[3] + S[7] * S[4]) / det);
+        }
+        // A cell boundary is as far as the linearization holds
+        step[0] = std::min(std::max(step[0], -1.0), 1.0);
+        step[1] = std::min(std::max(step[1], -1.0), 1.0);
+        shift += cv::Point2f(static_cast<float>(step[0]), static_cast<float>(step[1]));
+        if (std::fabs(step[0]) < 1e-3 && std::fabs(step[1]) < 1e-3) break;
+    }
+    return shift;
+}
+
+struct Run {
+    int x0, x1;     // columns [x0, x1)
+    int sign;
+};
+
+int findRoot(std::vector<int>& parent, int i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+} // namespace
+
+void buildGoldenReference(const cv::Mat& heightMap, GoldenReference& reference, int levels) {
+    CV_Assert(heightMap.type() == CV_32FC1);
+    buildPyramid(heightMap.clone(), std::max(levels, 1), reference.pyramid);
+}
+
+int saveGoldenReference(const GoldenReference& reference, const std::string& path) {
+    CV_Assert(!reference.pyramid.empty());
+    const cv::Mat& h = reference.pyramid[0];
+    std::ofstream file(path, std::ios::out | std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Cannot open: " << path << std::endl;
+        return -1;
+    }
+    const int32_t size[2] = {h.rows, h.cols};
+    file.write(kGoldenMagic, sizeof(kGoldenMagic));
+    file.write(reinterpret_cast<const char*>(size), sizeof(size));
+    for (int y = 0; y < h.rows; y++) file.write(reinterpret_cast<const char*>(h.ptr<float>(y)), h.cols * sizeof(float));
+    if (!file) {
+        std::cerr << "Write Error: " << path << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+int loadGoldenReference(const std::string& path, GoldenReference& reference, int levels) {
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Cannot open: " << path << std::endl;
+        return -1;
+    }
+    char magic[4] = {0};
+    int32_t size[2] = {0, 0};
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(size), sizeof(size));
+    if (!file || std::memcmp(magic, kGoldenMagic, sizeof(magic)) != 0 || size[0] <= 0 || size[1] <= 0) {
+        std::cerr << "Not a golden reference: " << path << std::endl;
+        return -1;
+    }
+    cv::Mat h(size[0], size[1], CV_32FC1);
+    file.read(reinterpret_cast<char*>(h.ptr<float>()), h.total() * sizeof(float));
+    if (!file) {
+        std::cerr << "Read Error: " << path << std::endl;
+        return -1;
+    }
+    buildPyramid(h, std::max(levels, 1), reference.pyramid);
+    return 0;
+}
+
+int compareToGolden(const GoldenReference& reference, const cv::Mat& heightMap, GoldenComparison& result,
+                    const GoldenCompareParams& params) {
+    CV_Assert(!reference.pyramid.empty() && heightMap.type() == CV_32FC1 &&
+              heightMap.size() == reference.pyramid[0].size());
+    const cv::Mat& ref0 = reference.pyramid[0];
+    result.alignMs = result.deviationMs = result.defectMs = 0.0;
+    const cv::Rect roi = params.roi.area() > 0 ? params.roi & cv::Rect(0, 0, ref0.cols, ref0.rows)
+                                               : cv::Rect(0, 0, ref0.cols, ref0.rows);
+
+    // ── 1. Alignment ──
+    int64 start = cv::getTickCount();
+    std::vector<cv::Mat> live;
+    buildPyramid(heightMap, static_cast<int>(reference.pyramid.size()), live);
+    const int top = static_cast<int>(std::min(live.size(), reference.pyramid.size())) - 1;
+
+    const cv::Rect roiTop = levelRoi(roi, top, reference.pyramid[top].size());
+    const int radius = (params.searchRadius + (1 << top) - 1) >> top;
+    std::vector<cv::Point> shifts;
+    for (int dy = -radius; dy <= radius; dy++) {
+        for (int dx = -radius; dx <= radius; dx++) shifts.push_back(cv::Point(dx, dy));
+    }
+    std::vector<DiffSums> sums;
+    scoreShifts(reference.pyramid[top], live[top], roiTop, shifts, sums);
+    const double minTop = params.minOverlap * countValid(reference.pyramid[top], roiTop);
+    size_t best = 0;
+    for (size_t i = 1; i < shifts.size(); i++) {
+        if (shiftScore(sums[i], minTop, params.removeOffset) < shiftScore(sums[best], minTop, params.removeOffset)) {
+            best = i;
+        }
+    }
+
+    cv::Point shift = shifts[best];
+    double scores[9];
+    for (int level = top; level >= 0; level--) {
+        const cv::Mat& ref = reference.pyramid[level];
+        const cv::Rect r = levelRoi(roi, level, ref.size());
+        const double minOverlap = params.minOverlap * countValid(ref, r);
+        if (level < top) shift *= 2;
+        shift = climb(ref, live[level], r, shift, minOverlap, params.removeOffset, scores);
+    }
+    if (scores[4] == DBL_MAX) {
+        std::cerr << "Golden alignment failed: overlap below " << params.minOverlap * 100.0f << "%" << std::endl;
+        return -1;
+    }
+    const cv::Point2f coarse(shift.x + parabolaPeak(scores[3], scores[4], scores[5]),
+                              shift.y + parabolaPeak(scores[1], scores[4], scores[7]));
+    const cv::Point2f subShift = refineShift(ref0, heightMap, roi, coarse, params.removeOffset);
+    result.alignMs = elapsedMs(start);
+
+    // ── 2. Deviation (bilinear, one weight set for the whole map) ──
+    start = cv::getTickCount();
+    const int ix = static_cast<int>(std::floor(subShift.x)), iy = static_cast<int>(std::floor(subShift.y));
+    const float ax = subShift.x - ix, ay = subShift.y - iy;
+    const float w00 = (1 - ax) * (1 - ay), w01 = ax * (1 - ay), w10 = (1 - ax) * ay, w11 = ax * ay;
+    // Taps of weight 0 (integer shift on an axis) point back at the used
+    // pixel: 0 * NaN would mark a valid pixel next to a hole as not compared
+    const int tx = ax > 0.0f ? 1 : 0, ty = ay > 0.0f ? 1 : 0;
+    const cv::Mat& lm = heightMap;
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+
+    result.deviation.create(ref0.size(), CV_32FC1);
+    result.deviation.setTo(cv::Scalar::all(nan));
+    std::vector<DiffSums> rowSums(roi.height);
+    const int x0 = std::max(roi.x, -ix), x1 = std::min(roi.x + roi.width, lm.cols - tx - ix);
+    cv::parallel_for_(cv::Range(0, roi.height), [&](const cv::Range& range) {
+        for (int r = range.start; r < range.end; r++) {
+            const int y = roi.y + r, ly = y + iy;
+            if (ly < 0 || ly + ty >= lm.rows || x1 <= x0) continue;
+            const float* a = lm.ptr<float>(ly) + ix;
+            const float* b = lm.ptr<float>(ly + ty) + ix;
+            const float* ref = ref0.ptr<float>(y);
+            float* out = result.deviation.ptr<float>(y);
+            float n = 0, sd = 0, sdd = 0;
+            int x = x0;
+#if CV_SIMD128
+            const cv::v_float32x4 v00 = cv::v_setall_f32(w00), v01 = cv::v_setall_f32(w01),
+                                  v10 = cv::v_setall_f32(w10), v11 = cv::v_setall_f32(w11);
+            const cv::v_float32x4 zero = cv::v_setzero_f32(), one = cv::v_setall_f32(1.0f);
+            cv::v_float32x4 vn = zero, vs = zero, vss = zero;
+            for (; x <= x1 - 4; x += 4) {
+                const cv::v_float32x4 l = v00 * cv::v_load(a + x) + v01 * cv::v_load(a + x + tx) +
+                                          v10 * cv::v_load(b + x) + v11 * cv::v_load(b + x + tx);
+                const cv::v_float32x4 d = l - cv::v_load(ref + x);
+                cv::v_store(out + x, d);
+                const cv::v_float32x4 ok = d == d;
+                const cv::v_float32x4 dz = cv::v_select(ok, d, zero);
+                vn += cv::v_select(ok, one, zero);
+                vs += dz;
+                vss += dz * dz;
+            }
+            n = cv::v_reduce_sum(vn);
+            sd = cv::v_reduce_sum(vs);
+            sdd = cv::v_reduce_sum(vss);
+#endif
+            for (; x < x1; x++) {
+                const float d = w00 * a[x] + w01 * a[x + tx] + w10 * b[x] + w11 * b[x + tx] - ref[x];
+                out[x] = d;
+                if (!(d == d)) continue;
+                n += 1.0f;
+                sd += d;
+                sdd += d * d;
+            }
+            rowSums[r].n = n;
+            rowSums[r].s = sd;
+            rowSums[r].ss = sdd;
+        }
+    });
+
+    DiffSums total;
+    for (const DiffSums& s : rowSums) {
+        total.n += s.n;
+        total.s += s.s;
+        total.ss += s.ss;
+    }
+    HeightAlignment& alignment = result.alignment;
+    alignment.shift = subShift;
+    alignment.overlap = static_cast<int>(total.n);
+    alignment.offset = params.removeOffset && total.n > 0 ? static_cast<float>(total.s / total.n) : 0.0f;
+    alignment.rms = total.n > 0 ? static_cast<float>(std::sqrt(std::max(
+                                      total.ss / total.n - double(alignment.offset) * alignment.offset, 0.0)))
+                                : 0.0f;
+    result.deviationMs = elapsedMs(start);
+
+    // ── 3. Defect regions ──
+    start = cv::getTickCount();
+    const float offset = alignment.offset, tolerance = params.tolerance;
+    std::vector<std::vector<Run>> rowRuns(roi.height);
+    cv::parallel_for_(cv::Range(0, roi.height), [&](const cv::Range& range) {
+        for (int r = range.start; r < range.end; r++) {
+            float* d = result.deviation.ptr<float>(roi.y + r);
+            std::vector<Run>& runs = rowRuns[r];
+            for (int x = roi.x; x < roi.x + roi.width; x++) {
+                d[x] -= offset;
+                const int sign = d[x] > tolerance ? 1 : (d[x] < -tolerance ? -1 : 0);
+                if (!sign) continue;
+                if (!runs.empty() && runs.back().x1 == x && runs.back().sign == sign) runs.back().x1 = x + 1;
+                else runs.push_back({x, x + 1, sign});
+            }
+        }
+    });
+
+    std::vector<int> firstRun(roi.height + 1, 0);
+    for (int r = 0; r < roi.height; r++) firstRun[r + 1] = firstRun[r] + static_cast<int>(rowRuns[r].size());
+    const int runCount = firstRun[roi.height];
+    std::vector<int> parent(runCount);
+    for (int i = 0; i < runCount; i++) parent[i] = i;
+
+    // Runs of consecutive rows touching with the same sign (4-connected)
+    for (int r = 1; r < roi.height; r++) {
+        const std::vector<Run>& above = rowRuns[r - 1];
+        const std::vector<Run>& cur = rowRuns[r];
+        size_t i = 0, j = 0;
+        while (i < above.size() && j < cur.size()) {
+            if (above[i].x0 < cur[j].x1 && cur[j].x0 < above[i].x1 && above[i].sign == cur[j].sign) {
+                const int a = findRoot(parent, firstRun[r - 1] + static_cast<int>(i));
+                const int b = findRoot(parent, firstRun[r] + static_cast<int>(j));
+                if (a != b) parent[std::max(a, b)] = std::min(a, b);
+            }
+            if (above[i].x1 < cur[j].x1) i++;
+            else j++;
+        }
+    }
+
+    // Region statistics, roots in first-run order
+    struct Region {
+        int root, area, sign;
+        double volume, sx, sy;
+        float peak;
+        int left, top, right, bottom;
+    };
+    std::vector<Region> regions;
+    std::vector<int> regionOf(runCount, -1);    // by root run
+    std::vector<int> runRegion(runCount);
+    for (int r = 0; r < roi.height; r++) {
+        const int y = roi.y + r;
+        const float* d = result.deviation.ptr<float>(y);
+        for (size_t k = 0; k < rowRuns[r].size(); k++) {
+            const Run& run = rowRuns[r][k];
+            const int root = findRoot(parent, firstRun[r] + static_cast<int>(k));
+            if (regionOf[root] < 0) {
+                regionOf[root] = static_cast<int>(regions.size());
+                regions.push_back({root, 0, run.sign, 0.0, 0.0, 0.0, 0.0f, run.x0, y, run.x1 - 1, y});
+            }
+            runRegion[firstRun[r] + k] = regionOf[root];
+            Region& g = regions[regionOf[root]];
+            for (int x = run.x0; x < run.x1; x++) {
+                g.volume += std::fabs(d[x]);
+                g.sx += x;
+                if (std::fabs(d[x]) > std::fabs(g.peak)) g.peak = d[x];
+            }
+            const int n = run.x1 - run.x0;
+            g.area += n;
+            g.sy += static_cast<double>(y) * n;
+            g.left = std::min(g.left, run.x0);
+            g.right = std::max(g.right, run.x1 - 1);
+            g.bottom = y;
+        }
+    }
+
+    std::vector<int> order;
+    for (size_t i = 0; i < regions.size(); i++) {
+        if (regions[i].area >= params.minDefectArea) order.push_back(static_cast<int>(i));
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return regions[a].area > regions[b].area; });
+
+    std::vector<int> labelOf(regions.size(), 0);
+    result.defects.clear();
+    for (size_t i = 0; i < order.size(); i++) {
+        const Region& g = regions[order[i]];
+        labelOf[order[i]] = static_cast<int>(i) + 1;
+        HeightDefect defect;
+        defect.label = static_cast<int>(i) + 1;
+        defect.sign = g.sign;
+        defect.area = g.area;
+        defect.volume = g.volume * params.pixelArea;
+        defect.peak = g.peak;
+        defect.bbox = cv::Rect(g.left, g.top, g.right - g.left + 1, g.bottom - g.top + 1);
+        defect.centroid = cv::Point2f(static_cast<float>(g.sx / g.area), static_cast<float>(g.sy / g.area));
+        result.defects.push_back(defect);
+    }
+
+    result.labels.create(ref0.size(), CV_32SC1);
+    result.labels.setTo(cv::Scalar::all(0));
+    cv::parallel_for_(cv::Range(0, roi.height), [&](const cv::Range& range) {
+        for (int r = range.start; r < range.end; r++) {
+            int* out = result.labels.ptr<int>(roi.y + r);
+            for (size_t k = 0; k < rowRuns[r].size(); k++) {
+                const Run& run = rowRuns[r][k];
+                const int label = labelOf[runRegion[firstRun[r] + k]];
+                if (label) std::fill(out + run.x0, out + run.x1, label);
+            }
+        }
+    });
+    result.defectMs = elapsedMs(start);
+    return 0;
+}
+
+int captureAndCompareToGolden(XEMA::XCamera* camera, const StandardPlaneExternal& plane,
+                              const GoldenReference& reference, GoldenComparison& result,
+                              const GoldenCompareParams& params) {
+    cv::Mat heightMap;
+    if (0 != captureHeightMap(camera, params.exposureNum, heightMap, &plane)) return -1;
+    return compareToGolden(reference, heightMap, result, params);
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include "xcamera.h"
+#include "height_metrology.h"
+#include "standard_plane.h"
+
+// ═══════════════════════════════════════════════════════════════════════
+// Golden-Reference Height-Map Comparison
+// ═══════════════════════════════════════════════════════════════════════
+//
+// Compares a part's height map against a stored reference of a good part:
+//
+//   1. Alignment: a translation (the part shifting in its fixture) found
+//      on 2x2-mean pyramids. The coarsest level is searched exhaustively
+//      within searchRadius; each finer level hill-climbs from twice the
+//      coarser shift. The score of a shift is the variance of
+//      live - reference over the overlap (the mean difference is the
+//      height offset, so a raised part still aligns), 4 pixels per SIMD
+//      step. A parabola through the full-resolution scores starts the
+//      sub-pixel shift, which Gauss-Newton on the bilinear interpolant of
+//      the live map refines (shift and offset together).
+//   2. Deviation: live(x + dx, y + dy) - reference(x, y) - offset,
+//      bilinear in the live map, NaN where either map has no height.
+//   3. Defects: pixels with |deviation| > tolerance form 4-connected
+//      regions of one sign (live above or below the reference), labeled
+//      by row runs. Regions smaller than minDefectArea are dropped.
+//
+// Shift scores and defect runs are reduced in a fixed order, so results do
+// not depend on the thread count.
+
+struct GoldenReference {
+    std::vector<cv::Mat> pyramid;       // CV_32FC1 (NaN = invalid), level 0 = full resolution
+};
+
+struct GoldenCompareParams {
+    cv::Rect roi;                       // compared region of the reference; empty = whole map
+    int searchRadius = 32;              // px at full resolution
+    bool removeOffset = true;           // subtract the mean height difference
+    float minOverlap = 0.5f;            // share of valid reference pixels that must overlap
+    float tolerance = 0.1f;             // mm; larger |deviation| is a defect pixel
+    int minDefectArea = 20;             // px
+    float pixelArea = 1.0f;             // mm^2 footprint of one pixel
+    int exposureNum = 1;                // captureData exposure count (captureAndCompareToGolden)
+};
+
+struct HeightAlignment {
+    cv::Point2f shift;                  // live position of reference pixel (0, 0)
+    float offset = 0.0f;                // mm, live - reference (0 without removeOffset)
+    float rms = 0.0f;                   // mm, rms deviation after alignment
+    int overlap = 0;                    // pixels compared
+};
+
+struct HeightDefect {
+    int label;                          // value in the label map
+    int sign;                           // +1 live above reference, -1 below
+    int area;                           // px
+    double volume;                      // mm^3, |deviation| summed
+    float peak;                         // mm, signed deviation of largest magnitude
+    cv::Rect bbox;
+    cv::Point2f centroid;               // px, reference frame
+};
+
+struct GoldenComparison {
+    HeightAlignment alignment;
+    cv::Mat deviation;                  // CV_32FC1 in the reference frame, NaN = not compared
+    cv::Mat labels;                     // CV_32SC1, 0 = no defect, 1..N by area (largest first)
+    std::vector<HeightDefect> defects;
+    double alignMs = 0.0;
+    double deviationMs = 0.0;
+    double defectMs = 0.0;
+};
+
+// heightMap: CV_32FC1, NaN = invalid (see captureHeightMap). levels
+// includes full resolution.
+void buildGoldenReference(const cv::Mat& heightMap, GoldenReference& reference, int levels = 4);
+
+int saveGoldenReference(const GoldenReference& reference, const std::string& path);
+int loadGoldenReference(const std::string& path, GoldenReference& reference, int levels = 4);
+
+// heightMap must have the reference's size. Returns -1 if the overlap at
+// the best shift is below minOverlap.
+int compareToGolden(const GoldenReference& reference, const cv::Mat& heightMap, GoldenComparison& result,
+                    const GoldenCompareParams& params = GoldenCompareParams());
+
+// captureHeightMap with the given standard plane, then compareToGolden.
+// Returns 0 on success, -1 on any SDK or alignment error.
+int captureAndCompareToGolden(XEMA::XCamera* camera, const StandardPlaneExternal& plane,
+                              const GoldenReference& reference, GoldenComparison& result,
+                              const GoldenCompareParams& params = GoldenCompareParams());
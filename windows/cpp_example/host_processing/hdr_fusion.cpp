@@ -0,0 +1,177 @@
+#include "hdr_fusion.h"
+#include <algorithm>
+#include <future>
+#include <iostream>
+#include <opencv2/core/hal/intrin.hpp>
+
+// ═══════════════════════════════════════════════════════════════════════
+// Fusion
+// ═══════════════════════════════════════════════════════════════════════
+
+// Weights of one exposure over one block of a row
+static void exposureWeights(const DepthFrame& frame, int y, int x0, int width, const HdrFusionParams& params,
+                            float* weights) {
+    const float* z = frame.depth.ptr<float>(y) + x0;
+    const uchar* b = frame.brightness.ptr<uchar>(y) + x0;
+    const uchar* conf = frame.confidence.ptr<uchar>(y) + x0;
+    const float* mod = frame.modulation.empty() ? nullptr : frame.modulation.ptr<float>(y) + x0;
+    const float invGoodMod = 1.0f / std::max(1e-3f, params.goodModulation);
+
+    int x = 0;
+#if CV_SIMD128
+    const cv::v_float32x4 zero = cv::v_setzero_f32(), one = cv::v_setall_f32(1.0f);
+    const cv::v_float32x4 inv255 = cv::v_setall_f32(1.0f / 255.0f), vsat = cv::v_setall_f32(params.saturationLevel);
+    const cv::v_float32x4 vinvMod = cv::v_setall_f32(invGoodMod);
+    for (; x <= width - 4; x += 4) {
+        cv::v_float32x4 vb = cv::v_cvt_f32(cv::v_reinterpret_as_s32(cv::v_load_expand_q(b + x)));
+        cv::v_float32x4 w = cv::v_cvt_f32(cv::v_reinterpret_as_s32(cv::v_load_expand_q(conf + x))) * inv255;
+        if (mod) w = w * cv::v_min(one, cv::v_load(mod + x) * vinvMod);
+        cv::v_float32x4 usable = (cv::v_load(z + x) > zero) & (vb < vsat);
+        cv::v_store(weights + x, cv::v_select(usable, w, zero));
+    }
+#endif
+    for (; x < width; x++) {
+        float w = conf[x] / 255.0f;
+        if (mod) w *= std::min(1.0f, mod[x] * invGoodMod);
+        weights[x] = (z[x] > 0.0f && b[x] < params.saturationLevel) ? w : 0.0f;
+    }
+}
+
+void fuseHdrDepth(const std::vector<const DepthFrame*>& frames, HdrFusionResult& result, const HdrFusionParams& params) {
+    const int n = static_cast<int>(frames.size());
+    CV_Assert(n >= 1 && n < 255);
+    const cv::Size size = frames[0]->depth.size();
+    for (const DepthFrame* f : frames) {
+        CV_Assert(f->depth.type() == CV_32FC1 && f->depth.size() == size);
+        CV_Assert(f->brightness.type() == CV_8UC1 && f->brightness.size() == size);
+        CV_Assert(f->confidence.type() == CV_8UC1 && f->confidence.size() == size);
+        CV_Assert(f->modulation.empty() || (f->modulation.type() == CV_32FC1 && f->modulation.size() == size));
+    }
+
+    result.depth.create(size, CV_32FC1);
+    result.confidence.create(size, CV_8UC1);
+    result.exposureIndex.create(size, CV_8UC1);
+    const int blockWidth = std::max(4, params.blockWidth / 4 * 4);
+
+    cv::parallel_for_(cv::Range(0, size.height), [&](const cv::Range& range) {
+        // Weights of every exposure for one block stay in L1 across the two passes
+        std::vector<float> weights(n * blockWidth);
+        float bestW[4], index[4];
+
+        for (int y = range.start; y < range.end; y++) {
+            float* outZ = result.depth.ptr<float>(y);
+            uchar* outConf = result.confidence.ptr<uchar>(y);
+            uchar* outIndex = result.exposureIndex.ptr<uchar>(y);
+
+            for (int x0 = 0; x0 < size.width; x0 += blockWidth) {
+                const int width = std::min(blockWidth, size.width - x0);
+                for (int i = 0; i < n; i++) exposureWeights(*frames[i], y, x0, width, params, &weights[i * blockWidth]);
+
+                int x = 0;
+#if CV_SIMD128
+                const cv::v_float32x4 zero = cv::v_setzero_f32(), v255 = cv::v_setall_f32(255.0f);
+                const cv::v_float32x4 spread = cv::v_setall_f32(params.maxDepthSpread);
+                const cv::v_float32x4 minWeight = cv::v_setall_f32(params.minWeight);
+                for (; x <= width - 4; x += 4) {
+                    // 1. Reference exposure
+                    cv::v_float32x4 wBest = zero, zBest = zero, iBest = cv::v_setall_f32(255.0f);
+                    for (int i = 0; i < n; i++) {
+                        cv::v_float32x4 w = cv::v_load(&weights[i * blockWidth + x]);
+                        cv::v_float32x4 better = w > wBest;
+                        wBest = cv::v_select(better, w, wBest);
+                        zBest = cv::v_select(better, cv::v_load(frames[i]->depth.ptr<float>(y) + x0 + x), zBest);
+                        iBest = cv::v_select(better, cv::v_setall_f32(static_cast<float>(i)), iBest);
+                    }
+
+                    // 2. Weighted mean of the exposures that agree with it
+                    cv::v_float32x4 sumW = zero, sumWZ = zero;
+                    for (int i = 0; i < n; i++) {
+                        cv::v_float32x4 w = cv::v_load(&weights[i * blockWidth + x]);
+                        cv::v_float32x4 z = cv::v_load(frames[i]->depth.ptr<float>(y) + x0 + x);
+                        w = cv::v_select(cv::v_abs(z - zBest) <= spread, w, zero);
+                        sumW += w;
+                        sumWZ = cv::v_muladd(w, z, sumWZ);
+                    }
+
+                    cv::v_float32x4 valid = (wBest >= minWeight) & (sumW > zero);
+                    cv::v_store(outZ + x0 + x, cv::v_select(valid, sumWZ / cv::v_max(sumW, minWeight), zero));
+                    cv::v_store(bestW, cv::v_select(valid, wBest * v255, zero));
+                    cv::v_store(index, cv::v_select(valid, iBest, v255));
+                    for (int l = 0; l < 4; l++) {
+                        outConf[x0 + x + l] = cv::saturate_cast<uchar>(bestW[l]);
+                        outIndex[x0 + x + l] = static_cast<uchar>(index[l]);
+                    }
+                }
+#endif
+                for (; x < width; x++) {
+                    float wRef = 0.0f, zRef = 0.0f;
+                    int iRef = 255;
+                    for (int i = 0; i < n; i++) {
+                        float w = weights[i * blockWidth + x];
+                        if (w > wRef) {
+                            wRef = w;
+                            zRef = frames[i]->depth.ptr<float>(y)[x0 + x];
+                            iRef = i;
+                        }
+                    }
+                    float sumW = 0.0f, sumWZ = 0.0f;
+                    for (int i = 0; i < n; i++) {
+                        float w = weights[i * blockWidth + x];
+                        float z = frames[i]->depth.ptr<float>(y)[x0 + x];
+                        if (w > 0.0f && std::abs(z - zRef) <= params.maxDepthSpread) {
+                            sumW += w;
+                            sumWZ += w * z;
+                        }
+                    }
+                    bool valid = wRef >= params.minWeight && sumW > 0.0f;
+                    outZ[x0 + x] = valid ? sumWZ / sumW : 0.0f;
+                    outConf[x0 + x] = valid ? cv::saturate_cast<uchar>(wRef * 255.0f) : 0;
+                    outIndex[x0 + x] = valid ? static_cast<uchar>(iRef) : 255;
+                }
+            }
+        }
+    });
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Exposure Set Capture
+// ═══════════════════════════════════════════════════════════════════════
+
+int captureExposureSet(XEMA::XCamera* camera, const std::vector<float>& exposures,
+                       std::vector<DepthFrame>& frames, const ConfidenceParams& params) {
+    float original = 0.0f;
+    if (0 != camera->getParamCameraExposure(original)) {
+        std::cerr << "Get Camera Exposure Error!" << std::endl;
+        return -1;
+    }
+
+    frames.resize(exposures.size());
+    std::future<void> pending;
+    int ret = 0;
+
+    for (size_t i = 0; i < exposures.size(); i++) {
+        if (0 != camera->setParamCameraExposure(exposures[i])) {
+            std::cerr << "Set Camera Exposure Error!" << std::endl;
+            ret = -1;
+            break;
+        }
+        ret = fetchDepthFrame(camera, 1, frames[i]);
+        if (pending.valid()) pending.wait();
+        if (0 != ret) break;
+        frames[i].exposure = exposures[i];
+
+        // Host work on this frame overlaps the next capture
+        DepthFrame* frame = &frames[i];
+        pending = std::async(std::launch::async, [frame, &params]() {
+            computeConfidence(frame->depth, frame->brightness, frame->confidence, params);
+        });
+    }
+    if (pending.valid()) pending.wait();
+
+    // Leave the camera as it was found, also after a failed capture
+    if (0 != camera->setParamCameraExposure(original)) {
+        std::cerr << "Restore Camera Exposure Error!" << std::endl;
+        ret = -1;
+    }
+    return ret;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <vector>
+#include <opencv2/core.hpp>
+#include "xcamera.h"
+#include "confidence.h"
+
+// ═══════════════════════════════════════════════════════════════════════
+// HDR Depth Fusion
+// ═══════════════════════════════════════════════════════════════════════
+//
+// Host-side replacement for setParamMixedHdr (at most 6 exposures, fixed
+// merge): any number of single-exposure DepthFrames are merged per pixel.
+//
+//   weight_i = confidence_i / 255
+//            * (brightness_i < saturationLevel)
+//            * min(1, modulation_i / goodModulation)     (if modulation is given)
+//
+// The exposure with the highest weight is the reference; the result is the
+// weighted mean of the exposures within maxDepthSpread of it, so a depth
+// from a different surface (multipath, blooming) is never averaged in.
+//
+// Frames are passed by pointer: one captured exposure set can be reused
+// by several recipes, each fusing its own subset.
+
+struct HdrFusionParams {
+    float saturationLevel = 250.0f; // brightness from which an exposure is ignored
+    float goodModulation = 30.0f;   // modulation with full weight (only when frames carry modulation)
+    float minWeight = 0.05f;        // pixels whose best weight is lower are invalid
+    float maxDepthSpread = 1.0f;    // mm from the reference exposure
+    int blockWidth = 256;           // columns per cache block
+};
+
+struct HdrFusionResult {
+    cv::Mat depth;                  // CV_32FC1, 0 = invalid
+    cv::Mat confidence;             // CV_8UC1, 255 * weight of the reference exposure
+    cv::Mat exposureIndex;          // CV_8UC1, index of the reference exposure, 255 = invalid
+};
+
+// All frames must have the same size; confidence is required
+// (computeConfidence), modulation is optional.
+void fuseHdrDepth(const std::vector<const DepthFrame*>& frames, HdrFusionResult& result,
+                  const HdrFusionParams& params = HdrFusionParams());
+
+// Captures one single-exposure frame per entry of `exposures`
+// (setParamCameraExposure + captureDepthFrame). The confidence of frame i
+// is computed on the host while frame i + 1 is captured and transferred.
+// The camera's exposure is restored afterwards. Returns 0 on success, -1 on
+// any SDK error.
+int captureExposureSet(XEMA::XCamera* camera, const std::vector<float>& exposures,
+                       std::vector<DepthFrame>& frames, const ConfidenceParams& params = ConfidenceParams());
@@ -0,0 +1,289 @@
+#include "hdr_planner.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include "confidence.h"
+
+// Radiance histogram: log2(r) in 1/16 stop bins over [-24, 8)
+static const int kBinsPerStop = 16;
+static const int kMinStop = -24;
+static const int kBins = 32 * kBinsPerStop;
+
+static double totalScale(const ExposureSettings& s) {
+    return s.exposure * (s.led / 1023.0) * std::pow(10.0, s.gain / 20.0);
+}
+
+static int radianceBin(double radiance) {
+    // log2 of 0 is -inf; the int conversion below needs a finite value
+    if (!(radiance > 0.0) || !std::isfinite(radiance)) return radiance > 0.0 ? kBins - 1 : 0;
+    int bin = static_cast<int>(std::floor((std::log2(radiance) - kMinStop) * kBinsPerStop));
+    return std::min(kBins - 1, std::max(0, bin));
+}
+
+static double binRadiance(int bin) {
+    return std::exp2(static_cast<double>(bin) / kBinsPerStop + kMinStop);
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Planning
+// ═══════════════════════════════════════════════════════════════════════
+
+// Total scale -> mixed-HDR pair: exposure at maxLed first, the LED only
+// dimmed below minExposure. Returns false when clamped at maxExposure.
+static bool hdrPair(double total, const HdrPlanParams& params, int& exposure, int& led) {
+    const double ledFull = params.maxLed / 1023.0;
+    double e = total / ledFull;
+    led = params.maxLed;
+    if (e > params.maxExposure) {
+        exposure = static_cast<int>(params.maxExposure);
+        return false;
+    }
+    if (e < params.minExposure) {
+        e = params.minExposure;
+        led = std::max(params.minLed, std::min(params.maxLed, static_cast<int>(std::floor(total / e * 1023.0))));
+    }
+    // Rounded down: the brightest radiance of the range must not clip
+    exposure = static_cast<int>(e);
+    return true;
+}
+
+HdrPlan planHdrExposures(const std::vector<BrightnessProbe>& probes, const HdrPlanParams& params) {
+    CV_Assert(!probes.empty());
+    CV_Assert(params.darkLevel > 0.0f && params.darkLevel < params.saturationLevel);
+    CV_Assert(params.goodLow > 0.0f && params.goodLow < params.goodHigh);
+    CV_Assert(params.minExposure > 0.0f && params.minExposure <= params.maxExposure && params.maxLed > 0);
+    const cv::Size size = probes[0].brightness.size();
+    for (const BrightnessProbe& p : probes) {
+        CV_Assert(p.brightness.type() == CV_8UC1 && p.brightness.size() == size && totalScale(p.settings) > 0.0);
+    }
+
+    // Longest probe first; per probe a brightness -> bin table, -1 = no radiance
+    std::vector<const BrightnessProbe*> order;
+    for (const BrightnessProbe& p : probes) order.push_back(&p);
+    std::sort(order.begin(), order.end(), [](const BrightnessProbe* a, const BrightnessProbe* b) {
+        return totalScale(a->settings) > totalScale(b->settings);
+    });
+    const int n = static_cast<int>(order.size());
+    std::vector<int> lut(n * 256);
+    for (int i = 0; i < n; i++) {
+        const double scale = totalScale(order[i]->settings);
+        for (int v = 0; v < 256; v++) {
+            bool usable = v >= params.darkLevel && v < params.saturationLevel;
+            lut[i * 256 + v] = usable ? radianceBin(v / scale) : -1;
+        }
+    }
+    // Dark in every probe: at most the dark level of the longest one;
+    // clipped in every probe: at least the saturation level of the shortest
+    const int darkBin = radianceBin(params.darkLevel / totalScale(order[0]->settings));
+    const int clippedBin = radianceBin(params.saturationLevel / totalScale(order[n - 1]->settings));
+
+    const cv::Rect frame(0, 0, size.width, size.height);
+    const cv::Rect area = params.roi.area() > 0 ? params.roi & frame : frame;
+    std::vector<int> histogram(kBins, 0);
+    std::mutex mutex;
+
+    cv::parallel_for_(cv::Range(area.y, area.y + area.height), [&](const cv::Range& range) {
+        std::vector<int> local(kBins, 0);
+        std::vector<const uchar*> rows(n);
+        for (int y = range.start; y < range.end; y++) {
+            for (int i = 0; i < n; i++) rows[i] = order[i]->brightness.ptr<uchar>(y) + area.x;
+            for (int x = 0; x < area.width; x++) {
+                int bin = -1;
+                for (int i = 0; i < n && bin < 0; i++) bin = lut[i * 256 + rows[i][x]];
+                if (bin < 0) bin = rows[n - 1][x] >= params.saturationLevel ? clippedBin : darkBin;
+                local[bin]++;
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int b = 0; b < kBins; b++) histogram[b] += local[b];
+    });
+
+    // Trim maxUncovered / 2 from both ends
+    const long long count = static_cast<long long>(area.width) * area.height;
+    const long long trim = static_cast<long long>(params.maxUncovered * 0.5 * count);
+    int lo = 0, hi = kBins - 1;
+    for (long long seen = histogram[lo]; lo < kBins - 1 && seen <= trim; seen += histogram[++lo]) {}
+    for (long long seen = histogram[hi]; hi > lo && seen <= trim; seen += histogram[--hi]) {}
+
+    // Greedy cover from the brightest radiance down; the next exposure
+    // starts where the previous one stops, not at a bin edge
+    HdrPlan plan;
+    std::vector<double> coverLo, coverHi;
+    const int maxExposures = std::min(6, std::max(1, params.maxExposures));
+    double rTop = binRadiance(hi + 1);
+    for (int top = hi; top >= lo && plan.num < maxExposures;) {
+        int exposure, led;
+        const bool inRange = hdrPair(params.goodHigh / rTop, params, exposure, led);
+        const double applied = exposure * (led / 1023.0);
+        plan.exposure[plan.num] = exposure;
+        plan.led[plan.num] = led;
+        plan.num++;
+        // Radiance range of the rounded / clamped pair
+        const double rBottom = params.goodLow / applied;
+        coverLo.push_back(rBottom);
+        coverHi.push_back(params.goodHigh / applied);
+        if (!inRange) break;
+
+        top = radianceBin(rBottom);
+        if (binRadiance(top) >= rBottom) top--;
+        while (top >= lo && histogram[top] == 0) top--;
+        rTop = std::min(rBottom, binRadiance(top + 1));
+    }
+
+    // A bin counts as covered when its centre is
+    long long covered = 0;
+    for (int b = 0; b < kBins; b++) {
+        const double r = binRadiance(b) * std::exp2(0.5 / kBinsPerStop);
+        for (size_t i = 0; i < coverLo.size(); i++) {
+            if (r >= coverLo[i] && r <= coverHi[i]) {
+                covered += histogram[b];
+                break;
+            }
+        }
+    }
+    plan.coverage = count > 0 ? static_cast<float>(covered) / count : 0.0f;
+
+    // Ascending exposure
+    std::vector<std::pair<int, int>> pairs;
+    for (int i = 0; i < plan.num; i++) pairs.emplace_back(plan.exposure[i], plan.led[i]);
+    std::sort(pairs.begin(), pairs.end(), [](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+        return a.first * static_cast<double>(a.second) < b.first * static_cast<double>(b.second);
+    });
+    for (int i = 0; i < plan.num; i++) {
+        plan.exposure[i] = pairs[i].first;
+        plan.led[i] = pairs[i].second;
+    }
+    return plan;
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Capture
+// ═══════════════════════════════════════════════════════════════════════
+
+static int captureProbe(XEMA::XCamera* camera, const ExposureSettings& s, bool fullCapture, int width, int height,
+                        BrightnessProbe& probe) {
+    if (0 != camera->setParamCameraExposure(s.exposure) ||
+        0 != camera->setParamLedCurrent(s.led) ||
+        0 != camera->setParamCameraGain(s.gain)) {
+        std::cerr << "Set Exposure Param Error!" << std::endl;
+        return -1;
+    }
+    probe.settings = s;
+    probe.brightness.create(height, width, CV_8UC1);
+    int ret;
+    if (fullCapture) {
+        char timestamp[30] = "";
+        ret = camera->captureData(1, timestamp);
+        if (0 == ret) ret = getGrayBrightnessData(camera, probe.brightness.ptr<uchar>());
+    } else {
+        ret = camera->captureBrightnessData(probe.brightness.ptr<uchar>(), XEMA::XemaColor::Gray);
+    }
+    if (0 != ret) {
+        std::cerr << "Capture Brightness Error!" << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+int captureBrightnessProbes(XEMA::XCamera* camera, const HdrPlanParams& params, std::vector<BrightnessProbe>& probes) {
+    int width = 0, height = 0;
+    if (0 != camera->getCameraResolution(&width, &height) || width <= 0 || height <= 0) {
+        std::cerr << "Get Camera Resolution Error!" << std::endl;
+        return -1;
+    }
+    if (!(params.darkLevel > 0.0f) || !(params.probeExposure > 0.0f) || params.probeLed <= 0 ||
+        !(params.probeStep > 1.0f)) {
+        std::cerr << "Invalid Hdr Probe Params!" << std::endl;
+        return -1;
+    }
+    // Probes must see the exposure / LED pairs setParamMixedHdr will use
+    if (0 != requireFringeBrightness(camera)) return -1;
+    ExposureSettings first;
+    first.exposure = params.probeExposure;
+    first.led = params.probeLed;
+    first.gain = 0.0f;
+    probes.assign(1, BrightnessProbe());
+    if (0 != captureProbe(camera, first, params.fullCapture, width, height, probes[0])) return -1;
+
+    const BrightnessStats stats = brightnessStats(probes[0].brightness, params.roi, params.saturationLevel);
+    int dark = 0;
+    for (int v = 0; v < 256 && v < params.darkLevel; v++) dark += stats.histogram[v];
+    const float darkFraction = stats.count > 0 ? static_cast<float>(dark) / stats.count : 0.0f;
+    const float limit = 0.5f * params.maxUncovered;
+
+    // A shorter probe for the clipped end, a longer one for the dark end
+    const float scales[2] = {stats.overExposed > limit ? 1.0f / params.probeStep : 0.0f,
+                             darkFraction > limit ? params.probeStep : 0.0f};
+    for (float scale : scales) {
+        if (scale <= 0.0f) continue;
+        ExposureSettings s = first;
+        s.exposure = std::min(params.maxExposure, std::max(params.minExposure, s.exposure * scale));
+        if (std::abs(s.exposure - first.exposure) < 1.0f) continue;
+        probes.emplace_back();
+        if (0 != captureProbe(camera, s, params.fullCapture, width, height, probes.back())) return -1;
+    }
+    return 0;
+}
+
+int planHdrForRecipe(XEMA::XCamera* camera, const std::string& recipe, HdrPlanCache& cache,
+                     const HdrPlanParams& params, HdrPlan& plan, bool replan) {
+    HdrPlanCache::const_iterator it = cache.find(recipe);
+    if (it != cache.end() && !replan) {
+        plan = it->second;
+    } else {
+        std::vector<BrightnessProbe> probes;
+        if (0 != captureBrightnessProbes(camera, params, probes)) return -1;
+        plan = planHdrExposures(probes, params);
+        cache[recipe] = plan;
+    }
+
+    if (0 != camera->setParamMixedHdr(plan.num, plan.exposure, plan.led)) {
+        std::cerr << "Set Mixed Hdr Error!" << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Cache File
+// ═══════════════════════════════════════════════════════════════════════
+
+int loadHdrPlanCache(const std::string& filename, HdrPlanCache& cache) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Cannot open: " << filename << std::endl;
+        return -1;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream iss(line);
+        std::string recipe;
+        HdrPlan plan;
+        bool ok = static_cast<bool>(iss >> recipe >> plan.num) && plan.num >= 1 && plan.num <= 6;
+        for (int i = 0; i < plan.num && ok; i++) ok = static_cast<bool>(iss >> plan.exposure[i] >> plan.led[i]);
+        if (ok) ok = static_cast<bool>(iss >> plan.coverage);
+        if (ok) cache[recipe] = plan;
+    }
+    return 0;
+}
+
+int saveHdrPlanCache(const std::string& filename, const HdrPlanCache& cache) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Cannot open: " << filename << std::endl;
+        return -1;
+    }
+
+    file << "# recipe num exposure led ... coverage" << std::endl;
+    for (const auto& kv : cache) {
+        file << kv.first << " " << kv.second.num;
+        for (int i = 0; i < kv.second.num; i++) file << " " << kv.second.exposure[i] << " " << kv.second.led[i];
+        file << " " << kv.second.coverage << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include "xcamera.h"
+#include "auto_exposure.h"
+
+// ═══════════════════════════════════════════════════════════════════════
+// HDR Exposure Planner
+// ═══════════════════════════════════════════════════════════════════════
+//
+// Picks the smallest setParamMixedHdr set (at most 6 exposure / LED pairs)
+// that covers the dynamic range of the scene, instead of a fixed
+// worst-case set.
+//
+// Each probe pixel gives a scene radiance
+//     r = brightness / (exposure * led / 1023 * 10^(gain / 20))
+// taken from the longest probe in which it is neither dark nor saturated.
+// A mixed-HDR exposure with the same total scale t covers the radiances
+// [goodLow / t, goodHigh / t]. Starting from the brightest radiance, each
+// exposure is placed so goodHigh falls on the brightest radiance not yet
+// covered (greedy interval cover, optimal for one dimension); empty
+// radiance ranges are skipped, so a bimodal scene needs no exposures
+// between its two modes.
+//
+// Plans are cached per recipe (part / fixture name), so the probes only
+// run the first time a recipe is seen or when a re-plan is requested.
+
+struct HdrPlanParams {
+    cv::Rect roi;                   // measured region; empty = whole frame
+    float darkLevel = 10.0f;        // probe brightness below which a pixel carries no radiance
+    float saturationLevel = 250.0f; // probe brightness from which a pixel is clipped
+    float goodLow = 40.0f;          // lowest brightness an exposure is planned to cover
+    float goodHigh = 230.0f;        // highest brightness an exposure is planned to cover
+    float maxUncovered = 0.01f;     // fraction of ROI pixels that may stay uncovered (split over both ends)
+    int maxExposures = 6;           // setParamMixedHdr limit
+    float minExposure = 1000.0f;
+    float maxExposure = 100000.0f;
+    int minLed = 100;
+    int maxLed = 1023;
+    float probeExposure = 10000.0f; // first probe
+    int probeLed = 1023;
+    float probeStep = 16.0f;        // exposure ratio of the extra probes
+    bool fullCapture = false;       // false: captureBrightnessData, true: captureData + getBrightnessData
+};
+
+struct BrightnessProbe {
+    cv::Mat brightness;             // CV_8UC1
+    ExposureSettings settings;      // of the capture
+};
+
+struct HdrPlan {
+    int num = 0;                    // exposures used
+    int exposure[6] = {0, 0, 0, 0, 0, 0};
+    int led[6] = {0, 0, 0, 0, 0, 0};
+    float coverage = 0.0f;          // fraction of ROI pixels inside the good range of one exposure
+};
+
+// Recipe name -> plan; recipe names must not contain whitespace
+typedef std::map<std::string, HdrPlan> HdrPlanCache;
+
+// Plan from one or more probes of the same scene (any order, same size).
+// Exposures are returned in ascending order. Requires
+// 0 < darkLevel < saturationLevel, 0 < goodLow < goodHigh and
+// 0 < minExposure <= maxExposure.
+HdrPlan planHdrExposures(const std::vector<BrightnessProbe>& probes, const HdrPlanParams& params = HdrPlanParams());
+
+// One probe at probeExposure / probeLed, plus one probeStep shorter when
+// more than maxUncovered / 2 of the ROI is clipped and one probeStep
+// longer when as much is dark (usually at most one of the two). Probes
+// run at 0 dB gain: setParamMixedHdr takes no gain, so the plan is made
+// for the camera gain the probes leave set. The camera is left at the
+// settings of the last probe. The brightness model must be 1 (see
+// requireFringeBrightness); otherwise the probes would measure the
+// brightness exposure instead of the planned pairs.
+// Returns 0 on success, -1 on any SDK error or another brightness model.
+int captureBrightnessProbes(XEMA::XCamera* camera, const HdrPlanParams& params, std::vector<BrightnessProbe>& probes);
+
+// Cached plan of the recipe, or probe + plan + cache when missing (or
+// `replan`); the plan is applied with setParamMixedHdr. Returns 0 on
+// success, -1 on any SDK error.
+int planHdrForRecipe(XEMA::XCamera* camera, const std::string& recipe, HdrPlanCache& cache,
+                     const HdrPlanParams& params, HdrPlan& plan, bool replan = false);
+
+// Text file, one recipe per line: name num exposure led ... coverage
+// Return 0 on success, -1 when the file cannot be opened.
+int loadHdrPlanCache(const std::string& filename, HdrPlanCache& cache);
+int saveHdrPlanCache(const std::string& filename, const HdrPlanCache& cache);
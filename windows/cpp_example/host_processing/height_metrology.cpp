@@ -0,0 +1,386 @@
+#include "height_metrology.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <opencv2/core/hal/intrin.hpp>
+
+namespace {
+
+// Sums of one ROI chunk; x is the absolute column, y the row
+struct Moments {
+    double n = 0, h = 0, hh = 0, vol = 0;
+    double x = 0, y = 0, xx = 0, xy = 0, yy = 0, xh = 0, yh = 0;
+    float lo = FLT_MAX, hi = -FLT_MAX;
+    int pixels = 0;
+
+    void add(const Moments& m) {
+        n += m.n; h += m.h; hh += m.hh; vol += m.vol;
+        x += m.x; y += m.y; xx += m.xx; xy += m.xy; yy += m.yy; xh += m.xh; yh += m.yh;
+        lo = std::min(lo, m.lo);
+        hi = std::max(hi, m.hi);
+        pixels += m.pixels;
+    }
+};
+
+// Reduces row y, columns [x0, x1). Lane sums are kept in float relative to
+// x0 and to the span's first valid height (so h^2 does not cancel on a
+// flat part far from the reference plane), and moved to absolute values in
+// double per span.
+void reduceSpan(const float* row, int y, int x0, int x1, float base, Moments& m,
+                std::vector<float>* values) {
+    const float* h = row + x0;
+    const int len = x1 - x0;
+    int first = 0;
+    while (first < len && !(h[first] == h[first])) first++;
+    m.pixels += len;
+    if (first == len) return;
+    const float shift = h[first];
+
+    float n = 0, sh = 0, shh = 0, sxh = 0, sx = 0, sxx = 0, vol = 0;
+    float lo = FLT_MAX, hi = -FLT_MAX;
+    int i = 0;
+#if CV_SIMD128
+    const cv::v_float32x4 zero = cv::v_setzero_f32(), one = cv::v_setall_f32(1.0f),
+                          four = cv::v_setall_f32(4.0f), vbase = cv::v_setall_f32(base),
+                          vmax = cv::v_setall_f32(FLT_MAX), vmin = cv::v_setall_f32(-FLT_MAX),
+                          vshift = cv::v_setall_f32(shift);
+    cv::v_float32x4 vn = zero, vh = zero, vhh = zero, vxh = zero, vx = zero, vxx = zero, vv = zero;
+    cv::v_float32x4 vlo = vmax, vhi = vmin;
+    cv::v_float32x4 xr(0.0f, 1.0f, 2.0f, 3.0f);
+    for (; i <= len - 4; i += 4) {
+        const cv::v_float32x4 v = cv::v_load(h + i);
+        const cv::v_float32x4 ok = v == v;
+        const cv::v_float32x4 hz = cv::v_select(ok, v - vshift, zero);
+        const cv::v_float32x4 xz = cv::v_select(ok, xr, zero);
+        vn += cv::v_select(ok, one, zero);
+        vh += hz;
+        vhh += hz * hz;
+        vxh += xr * hz;
+        vx += xz;
+        vxx += xz * xr;
+        vv += cv::v_select(ok, cv::v_max(v - vbase, zero), zero);
+        vlo = cv::v_min(vlo, cv::v_select(ok, v, vmax));
+        vhi = cv::v_max(vhi, cv::v_select(ok, v, vmin));
+        xr += four;
+    }
+    n = cv::v_reduce_sum(vn);
+    sh = cv::v_reduce_sum(vh);
+    shh = cv::v_reduce_sum(vhh);
+    sxh = cv::v_reduce_sum(vxh);
+    sx = cv::v_reduce_sum(vx);
+    sxx = cv::v_reduce_sum(vxx);
+    vol = cv::v_reduce_sum(vv);
+    lo = cv::v_reduce_min(vlo);
+    hi = cv::v_reduce_max(vhi);
+#endif
+    for (; i < len; i++) {
+        const float v = h[i];
+        if (!(v == v)) continue;
+        const float xr = static_cast<float>(i);
+        const float hz = v - shift;
+        n += 1.0f;
+        sh += hz;
+        shh += hz * hz;
+        sxh += xr * hz;
+        sx += xr;
+        sxx += xr * xr;
+        vol += std::max(v - base, 0.0f);
+        lo = std::min(lo, v);
+        hi = std::max(hi, v);
+    }
+
+    const double dx = x0, dy = y, s = shift;
+    const double h1 = sh + s * n;               // sum of h
+    const double x1r = sx + dx * n;             // sum of x
+    m.n += n;
+    m.h += h1;
+    m.hh += shh + 2.0 * s * sh + s * s * n;
+    m.vol += vol;
+    m.x += x1r;
+    m.xx += sxx + 2.0 * dx * sx + dx * dx * n;
+    m.xh += sxh + s * sx + dx * h1;
+    m.y += dy * n;
+    m.xy += dy * x1r;
+    m.yy += dy * dy * n;
+    m.yh += dy * h1;
+    m.lo = std::min(m.lo, lo);
+    m.hi = std::max(m.hi, hi);
+
+    if (values) {
+        for (int k = 0; k < len; k++) {
+            if (h[k] == h[k]) values->push_back(h[k]);
+        }
+    }
+}
+
+// Column spans [first, second) of a polygon on row y (pixel centers)
+void polygonSpans(const std::vector<cv::Point2f>& poly, int y, int cols, std::vector<float>& crossings,
+                  std::vector<cv::Vec2i>& spans) {
+    crossings.clear();
+    spans.clear();
+    const float fy = static_cast<float>(y);
+    const size_t n = poly.size();
+    for (size_t i = 0, j = n - 1; i < n; j = i++) {
+        const cv::Point2f& a = poly[j];
+        const cv::Point2f& b = poly[i];
+        if ((a.y <= fy) != (b.y <= fy)) {
+            crossings.push_back(a.x + (fy - a.y) * (b.x - a.x) / (b.y - a.y));
+        }
+    }
+    std::sort(crossings.begin(), crossings.end());
+    for (size_t k = 0; k + 1 < crossings.size(); k += 2) {
+        const int x0 = std::max(0, static_cast<int>(std::ceil(crossings[k])));
+        const int x1 = std::min(cols, static_cast<int>(std::ceil(crossings[k + 1])));
+        if (x1 > x0) spans.push_back(cv::Vec2i(x0, x1));
+    }
+}
+
+// Row range of a ROI inside the image
+cv::Range roiRows(const MetrologyRoi& roi, const cv::Size& size) {
+    if (roi.polygon.empty()) {
+        const cv::Rect r = roi.rect & cv::Rect(0, 0, size.width, size.height);
+        return r.area() > 0 ? cv::Range(r.y, r.y + r.height) : cv::Range(0, 0);
+    }
+    float top = FLT_MAX, bottom = -FLT_MAX;
+    for (const cv::Point2f& p : roi.polygon) {
+        top = std::min(top, p.y);
+        bottom = std::max(bottom, p.y);
+    }
+    const int y0 = std::max(0, static_cast<int>(std::ceil(top)));
+    const int y1 = std::min(size.height, static_cast<int>(std::floor(bottom)) + 1);
+    return y1 > y0 ? cv::Range(y0, y1) : cv::Range(0, 0);
+}
+
+// Interpolated percentiles of values (reordered in place)
+void selectPercentiles(std::vector<float>& values, const std::vector<float>& percentiles,
+                       std::vector<float>& out) {
+    out.assign(percentiles.size(), 0.0f);
+    if (values.empty()) return;
+
+    std::vector<int> order(percentiles.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = static_cast<int>(i);
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return percentiles[a] < percentiles[b]; });
+
+    // Ascending ranks: each selection only needs the part right of the last one
+    const size_t last = values.size() - 1;
+    size_t begin = 0;
+    for (int i : order) {
+        const double pos = std::min(std::max(percentiles[i], 0.0f), 100.0f) / 100.0 * last;
+        const size_t k = std::max(static_cast<size_t>(pos), begin);
+        std::nth_element(values.begin() + begin, values.begin() + k, values.end());
+        const float lower = values[k];
+        const double frac = pos - static_cast<double>(k);
+        float upper = lower;
+        if (frac > 0 && k < last) upper = *std::min_element(values.begin() + k + 1, values.end());
+        out[i] = static_cast<float>(lower + frac * (upper - lower));
+        begin = k;
+    }
+}
+
+void finishStats(const Moments& m, float pixelArea, RoiStats& s) {
+    s = RoiStats();
+    s.pixels = m.pixels;
+    s.valid = static_cast<int>(m.n);
+    s.coverage = m.pixels > 0 ? static_cast<float>(m.n / m.pixels) : 0.0f;
+    if (m.n == 0) return;
+
+    const double mean = m.h / m.n;
+    s.mean = static_cast<float>(mean);
+    s.stddev = static_cast<float>(std::sqrt(std::max(m.hh / m.n - mean * mean, 0.0)));
+    s.min = m.lo;
+    s.max = m.hi;
+    s.volume = m.vol * pixelArea;
+
+    // Least-squares plane on centered moments; degenerate layouts (a line
+    // of pixels) fall back to the spread around the mean.
+    const double mx = m.x / m.n, my = m.y / m.n;
+    const double sxx = m.xx - m.n * mx * mx, sxy = m.xy - m.n * mx * my, syy = m.yy - m.n * my * my;
+    const double sxh = m.xh - m.n * mx * mean, syh = m.yh - m.n * my * mean;
+    const double shh = m.hh - m.n * mean * mean;
+    const double det = sxx * syy - sxy * sxy;
+    double residual = shh;
+    if (det > 1e-9 * std::max(sxx * syy, 1.0)) {
+        const double a = (sxh * syy - syh * sxy) / det;
+        const double b = (syh * sxx - sxh * sxy) / det;
+        residual = shh - a * sxh - b * syh;
+    }
+    s.planeRms = static_cast<float>(std::sqrt(std::max(residual, 0.0) / m.n));
+}
+
+} // namespace
+
+void measureRois(const cv::Mat& heightMap, const std::vector<MetrologyRoi>& rois,
+                 std::vector<RoiStats>& stats, const MetrologyParams& params) {
+    CV_Assert(heightMap.type() == CV_32FC1);
+    stats.assign(rois.size(), RoiStats());
+    if (rois.empty()) return;
+
+    struct Task {
+        int roi;
+        int y0, y1;
+    };
+    const int step = std::max(1, params.rowsPerTask);
+    std::vector<Task> tasks;
+    std::vector<int> firstTask(rois.size() + 1);
+    for (size_t r = 0; r < rois.size(); r++) {
+        firstTask[r] = static_cast<int>(tasks.size());
+        const cv::Range rows = roiRows(rois[r], heightMap.size());
+        for (int y = rows.start; y < rows.end; y += step) {
+            tasks.push_back({static_cast<int>(r), y, std::min(y + step, rows.end)});
+        }
+    }
+    firstTask[rois.size()] = static_cast<int>(tasks.size());
+
+    const bool wantValues = !params.percentiles.empty();
+    std::vector<Moments> partial(tasks.size());
+    std::vector<std::vector<float>> values(wantValues ? tasks.size() : 0);
+
+    cv::parallel_for_(cv::Range(0, static_cast<int>(tasks.size())), [&](const cv::Range& range) {
+        std::vector<float> crossings;
+        std::vector<cv::Vec2i> spans;
+        for (int t = range.start; t < range.end; t++) {
+            const Task& task = tasks[t];
+            const MetrologyRoi& roi = rois[task.roi];
+            Moments& m = partial[t];
+            std::vector<float>* out = wantValues ? &values[t] : nullptr;
+            for (int y = task.y0; y < task.y1; y++) {
+                const float* row = heightMap.ptr<float>(y);
+                if (roi.polygon.empty()) {
+                    const int x0 = std::max(roi.rect.x, 0);
+                    const int x1 = std::min(roi.rect.x + roi.rect.width, heightMap.cols);
+                    reduceSpan(row, y, x0, x1, params.volumeBase, m, out);
+                } else {
+                    polygonSpans(roi.polygon, y, heightMap.cols, crossings, spans);
+                    for (const cv::Vec2i& s : spans) reduceSpan(row, y, s[0], s[1], params.volumeBase, m, out);
+                }
+            }
+        }
+    });
+
+    cv::parallel_for_(cv::Range(0, static_cast<int>(rois.size())), [&](const cv::Range& range) {
+        std::vector<float> gathered;
+        for (int r = range.start; r < range.end; r++) {
+            Moments m;
+            for (int t = firstTask[r]; t < firstTask[r + 1]; t++) m.add(partial[t]);
+            finishStats(m, params.pixelArea, stats[r]);
+            if (!wantValues) continue;
+            gathered.clear();
+            for (int t = firstTask[r]; t < firstTask[r + 1]; t++) {
+                gathered.insert(gathered.end(), values[t].begin(), values[t].end());
+            }
+            selectPercentiles(gathered, params.percentiles, stats[r].percentiles);
+        }
+    });
+}
+
+void buildHeightIntegral(const cv::Mat& heightMap, HeightIntegral& integral, float volumeBase) {
+    CV_Assert(heightMap.type() == CV_32FC1);
+    const int rows = heightMap.rows, cols = heightMap.cols;
+    integral.volumeBase = volumeBase;
+    integral.sums.create(rows + 1, cols + 1, CV_64FC4);
+    integral.sums.row(0).setTo(cv::Scalar::all(0));
+
+    // Row prefix sums in parallel, then column accumulation in parallel
+    // over column blocks.
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; y++) {
+            const float* h = heightMap.ptr<float>(y);
+            cv::Vec4d* out = integral.sums.ptr<cv::Vec4d>(y + 1);
+            cv::Vec4d run(0, 0, 0, 0);
+            out[0] = run;
+            for (int x = 0; x < cols; x++) {
+                const float v = h[x];
+                if (v == v) {
+                    run[0] += 1.0;
+                    run[1] += v;
+                    run[2] += static_cast<double>(v) * v;
+                    run[3] += std::max(v - volumeBase, 0.0f);
+                }
+                out[x + 1] = run;
+            }
+        }
+    });
+
+    const int blockCols = 64;
+    const int blocks = (cols + 1 + blockCols - 1) / blockCols;
+    cv::parallel_for_(cv::Range(0, blocks), [&](const cv::Range& range) {
+        for (int b = range.start; b < range.end; b++) {
+            const int x0 = b * blockCols, x1 = std::min(x0 + blockCols, cols + 1);
+            for (int y = 2; y <= rows; y++) {
+                const double* above = integral.sums.ptr<double>(y - 1) + 4 * x0;
+                double* cur = integral.sums.ptr<double>(y) + 4 * x0;
+                for (int i = 0; i < 4 * (x1 - x0); i++) cur[i] += above[i];
+            }
+        }
+    });
+}
+
+RoiStats queryHeightIntegral(const HeightIntegral& integral, const cv::Rect& rect, float pixelArea) {
+    RoiStats s;
+    const cv::Rect r = rect & cv::Rect(0, 0, integral.sums.cols - 1, integral.sums.rows - 1);
+    if (r.area() <= 0) return s;
+
+    const cv::Vec4d& a = integral.sums.at<cv::Vec4d>(r.y, r.x);
+    const cv::Vec4d& b = integral.sums.at<cv::Vec4d>(r.y, r.x + r.width);
+    const cv::Vec4d& c = integral.sums.at<cv::Vec4d>(r.y + r.height, r.x);
+    const cv::Vec4d& d = integral.sums.at<cv::Vec4d>(r.y + r.height, r.x + r.width);
+    const cv::Vec4d sum = d - b - c + a;
+
+    s.pixels = r.area();
+    s.valid = static_cast<int>(std::lround(sum[0]));
+    s.coverage = static_cast<float>(s.valid) / s.pixels;
+    if (s.valid == 0) return s;
+    const double mean = sum[1] / s.valid;
+    s.mean = static_cast<float>(mean);
+    s.stddev = static_cast<float>(std::sqrt(std::max(sum[2] / s.valid - mean * mean, 0.0)));
+    s.volume = sum[3] * pixelArea;
+    return s;
+}
+
+void invalidateHeights(cv::Mat& heightMap, const cv::Mat& mask) {
+    CV_Assert(heightMap.type() == CV_32FC1 && mask.type() == CV_8UC1 && mask.size() == heightMap.size());
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    cv::parallel_for_(cv::Range(0, heightMap.rows), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; y++) {
+            float* h = heightMap.ptr<float>(y);
+            const uchar* m = mask.ptr<uchar>(y);
+            for (int x = 0; x < heightMap.cols; x++) {
+                if (!m[x]) h[x] = nan;
+            }
+        }
+    });
+}
+
+int captureHeightMap(XEMA::XCamera* camera, int exposureNum, cv::Mat& heightMap,
+                     const StandardPlaneExternal* plane) {
+    int width = 0, height = 0;
+    if (0 != camera->getCameraResolution(&width, &height) || width <= 0 || height <= 0) {
+        std::cerr << "Get Camera Resolution Error!" << std::endl;
+        return -1;
+    }
+
+    char timestamp[30] = "";
+    heightMap.create(height, width, CV_32FC1);
+    cv::Mat depth(height, width, CV_32FC1);
+    StandardPlaneExternal external = plane ? *plane : StandardPlaneExternal();
+    if (0 != camera->captureData(exposureNum, timestamp) ||
+        0 != (plane ? camera->getHeightMapDataBaseParam(external.R, external.T, heightMap.ptr<float>())
+                    : camera->getHeightMapData(heightMap.ptr<float>())) ||
+        0 != camera->getDepthData(depth.ptr<float>())) {
+        std::cerr << "Capture Data Error!" << std::endl;
+        return -1;
+    }
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    cv::parallel_for_(cv::Range(0, height), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; y++) {
+            float* h = heightMap.ptr<float>(y);
+            const float* z = depth.ptr<float>(y);
+            for (int x = 0; x < width; x++) {
+                if (!(z[x] > 0)) h[x] = nan;
+            }
+        }
+    });
+    return 0;
+}
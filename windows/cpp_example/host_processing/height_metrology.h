@@ -0,0 +1,77 @@
+#pragma once
+#include <vector>
+#include <opencv2/core.hpp>
+#include "xcamera.h"
+#include "standard_plane.h"
+
+// ═══════════════════════════════════════════════════════════════════════
+// Height-Map Metrology
+// ═══════════════════════════════════════════════════════════════════════
+//
+// Per-ROI statistics on getHeightMapData output: coverage, mean, peak
+// heights, volume, flatness and percentiles. Invalid pixels are NaN
+// (captureHeightMap and invalidateHeights produce that).
+//
+// measureRois evaluates all ROIs of a part in one call:
+//   1. Every ROI is cut into row chunks; the chunks of all ROIs run in
+//      parallel. A rectangle gives one span per row, a polygon the spans
+//      between its edge crossings (even-odd rule, pixel centers).
+//   2. Each span is reduced 4 pixels per SIMD step into count, sums of
+//      h, h^2, x*h, x, x^2, the volume above volumeBase and min/max.
+//   3. Chunks are merged per ROI in row order, so results do not depend on
+//      the thread count. Flatness is the rms residual of the least-squares
+//      plane h = a*x + b*y + c, solved from the same sums.
+//   4. Percentiles (if requested) use selection on the ROI's valid heights.
+//
+// For many rectangle queries on the same map, buildHeightIntegral makes
+// count, mean, stddev and volume O(1) per rectangle. Min/max, flatness and
+// percentiles are not decomposable and need measureRois.
+
+struct MetrologyRoi {
+    cv::Rect rect;                      // used when polygon is empty
+    std::vector<cv::Point2f> polygon;   // pixel coordinates; pixel (x, y) is inside when its center is
+};
+
+struct MetrologyParams {
+    float volumeBase = 0.0f;            // mm; volume counts height above it
+    float pixelArea = 1.0f;             // mm^2 footprint of one pixel at the reference plane
+    std::vector<float> percentiles;     // 0..100, e.g. {1, 50, 99}; empty = none
+    int rowsPerTask = 64;               // ROI rows per parallel task
+};
+
+struct RoiStats {
+    int pixels = 0;                     // pixels inside the ROI (and the image)
+    int valid = 0;                      // ... with a height
+    float coverage = 0.0f;              // valid / pixels
+    float mean = 0.0f;                  // mm
+    float stddev = 0.0f;
+    float min = 0.0f;
+    float max = 0.0f;
+    double volume = 0.0;                // mm^3 above volumeBase
+    float planeRms = 0.0f;              // rms deviation from the best-fit plane (mm)
+    std::vector<float> percentiles;     // matches MetrologyParams::percentiles (linear interpolation)
+};
+
+// heightMap: CV_32FC1, NaN = invalid. stats: one entry per ROI.
+void measureRois(const cv::Mat& heightMap, const std::vector<MetrologyRoi>& rois,
+                 std::vector<RoiStats>& stats, const MetrologyParams& params = MetrologyParams());
+
+struct HeightIntegral {
+    cv::Mat sums;               // (rows + 1) x (cols + 1) CV_64FC4: count, h, h^2, volume
+    float volumeBase = 0.0f;
+};
+
+void buildHeightIntegral(const cv::Mat& heightMap, HeightIntegral& integral, float volumeBase = 0.0f);
+
+// Fills pixels, valid, coverage, mean, stddev and volume of the rectangle
+// (clipped to the map); min, max, planeRms and percentiles stay 0.
+RoiStats queryHeightIntegral(const HeightIntegral& integral, const cv::Rect& rect, float pixelArea = 1.0f);
+
+// Sets heights to NaN where mask == 0 (mask: CV_8UC1, e.g. depth > 0)
+void invalidateHeights(cv::Mat& heightMap, const cv::Mat& mask);
+
+// captureData + getHeightMapData (getHeightMapDataBaseParam with a plane)
+// + getDepthData; pixels without depth become NaN. Returns 0 on success,
+// -1 on any SDK error.
+int captureHeightMap(XEMA::XCamera* camera, int exposureNum, cv::Mat& heightMap,
+                     const StandardPlaneExternal* plane = nullptr);
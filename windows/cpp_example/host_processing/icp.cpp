@@ -0,0 +1,241 @@
+#include "icp.h"
+#include <algorithm>
+#include <cmath>
+
+static const int kStripes = 32;
+// 21 upper-triangle entries of J^T J, 6 of J^T r, r^2, count
+static const int kSums = 29;
+
+// ═══════════════════════════════════════════════════════════════════════
+// Pose Helpers
+// ═══════════════════════════════════════════════════════════════════════
+
+cv::Matx44d poseFromExtrinsic(const float extrinsic[16]) {
+    cv::Matx44d pose = cv::Matx44d::eye();
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 4; c++) pose(r, c) = extrinsic[4 * r + c];
+    }
+    return pose;
+}
+
+// Rotation by the rotation vector w
+static cv::Matx33d rotationFromVector(const cv::Vec3d& w) {
+    const double theta = std::sqrt(w.dot(w));
+    if (theta < 1e-12) return cv::Matx33d::eye();
+    const cv::Vec3d k = w * (1.0 / theta);
+    const cv::Matx33d K(0, -k[2], k[1], k[2], 0, -k[0], -k[1], k[0], 0);
+    return cv::Matx33d::eye() + std::sin(theta) * K + (1.0 - std::cos(theta)) * (K * K);
+}
+
+static cv::Matx44d makePose(const cv::Matx33d& R, const cv::Vec3d& t) {
+    cv::Matx44d pose = cv::Matx44d::eye();
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) pose(r, c) = R(r, c);
+        pose(r, 3) = t[r];
+    }
+    return pose;
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Pyramid
+// ═══════════════════════════════════════════════════════════════════════
+
+// 2x2 blocks: the nearest valid point and those within 1 % of its depth
+// are averaged; normals likewise, renormalized
+static void downsampleLevel(const IcpLevel& fine, IcpLevel& coarse) {
+    const int rows = fine.cloud.rows / 2, cols = fine.cloud.cols / 2;
+    coarse.cloud.create(rows, cols, CV_32FC3);
+    coarse.normals.nx.create(rows, cols, CV_32FC1);
+    coarse.normals.ny.create(rows, cols, CV_32FC1);
+    coarse.normals.nz.create(rows, cols, CV_32FC1);
+    coarse.normals.curvature.create(rows, cols, CV_32FC1);
+    coarse.K = fine.K;
+    coarse.K(0, 0) *= 0.5;
+    coarse.K(1, 1) *= 0.5;
+    coarse.K(0, 2) = (fine.K(0, 2) + 0.5) * 0.5 - 0.5;
+    coarse.K(1, 2) = (fine.K(1, 2) + 0.5) * 0.5 - 0.5;
+
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; y++) {
+            float* out = coarse.cloud.ptr<float>(y);
+            for (int x = 0; x < cols; x++) {
+                float zmin = 0.0f;
+                for (int k = 0; k < 4; k++) {
+                    const float z = fine.cloud.ptr<float>(2 * y + k / 2)[3 * (2 * x + k % 2) + 2];
+                    if (z > 0.0f && (zmin == 0.0f || z < zmin)) zmin = z;
+                }
+                float p[3] = {0.0f, 0.0f, 0.0f}, n[3] = {0.0f, 0.0f, 0.0f}, curv = 0.0f;
+                int count = 0;
+                for (int k = 0; k < 4 && zmin > 0.0f; k++) {
+                    const int fy = 2 * y + k / 2, fx = 2 * x + k % 2;
+                    const float* q = fine.cloud.ptr<float>(fy) + 3 * fx;
+                    if (!(q[2] > 0.0f) || q[2] > zmin * 1.01f) continue;
+                    for (int c = 0; c < 3; c++) p[c] += q[c];
+                    n[0] += fine.normals.nx.ptr<float>(fy)[fx];
+                    n[1] += fine.normals.ny.ptr<float>(fy)[fx];
+                    n[2] += fine.normals.nz.ptr<float>(fy)[fx];
+                    curv += fine.normals.curvature.ptr<float>(fy)[fx];
+                    count++;
+                }
+                const float norm = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                for (int c = 0; c < 3; c++) out[3 * x + c] = count ? p[c] / count : 0.0f;
+                const float inv = norm > 1e-6f ? 1.0f / norm : 0.0f;
+                coarse.normals.nx.ptr<float>(y)[x] = n[0] * inv;
+                coarse.normals.ny.ptr<float>(y)[x] = n[1] * inv;
+                coarse.normals.nz.ptr<float>(y)[x] = n[2] * inv;
+                coarse.normals.curvature.ptr<float>(y)[x] = count ? curv / count : 0.0f;
+            }
+        }
+    });
+}
+
+IcpFrame makeIcpFrame(const cv::Mat& cloud, const float intrinsic[9], int levels, const NormalParams& normalParams) {
+    CV_Assert(cloud.type() == CV_32FC3);
+    IcpFrame frame;
+    frame.levels.resize(std::max(1, levels));
+    IcpLevel& finest = frame.levels[0];
+    finest.cloud = cloud;
+    for (int i = 0; i < 9; i++) finest.K.val[i] = intrinsic[i];
+    estimateNormals(cloud, finest.normals, normalParams);
+    for (size_t l = 1; l < frame.levels.size(); l++) downsampleLevel(frame.levels[l - 1], frame.levels[l]);
+    return frame;
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Alignment
+// ═══════════════════════════════════════════════════════════════════════
+
+// Normal equations of one iteration, summed per stripe and reduced in order
+static void accumulateSystem(const IcpLevel& src, const IcpLevel& tgt, const cv::Matx44d& pose, int step,
+                             float maxDistance, float minCos, IcpMetric metric, double sums[kSums]) {
+    const cv::Matx33d R = pose.get_minor<3, 3>(0, 0);
+    const cv::Vec3d t(pose(0, 3), pose(1, 3), pose(2, 3));
+    const double fx = tgt.K(0, 0), fy = tgt.K(1, 1), cx = tgt.K(0, 2), cy = tgt.K(1, 2);
+    const int rows = src.cloud.rows, cols = src.cloud.cols;
+    const int tRows = tgt.cloud.rows, tCols = tgt.cloud.cols;
+    const double maxD2 = static_cast<double>(maxDistance) * maxDistance;
+    std::vector<double> partial(kStripes * kSums, 0.0);
+
+    cv::parallel_for_(cv::Range(0, kStripes), [&](const cv::Range& range) {
+        for (int s = range.start; s < range.end; s++) {
+            double* acc = &partial[s * kSums];
+            const int y0 = rows * s / kStripes, y1 = rows * (s + 1) / kStripes;
+            for (int y = y0 + (step - y0 % step) % step; y < y1; y += step) {
+                const float* ps = src.cloud.ptr<float>(y);
+                const float* nsx = src.normals.nx.ptr<float>(y);
+                const float* nsy = src.normals.ny.ptr<float>(y);
+                const float* nsz = src.normals.nz.ptr<float>(y);
+                for (int x = 0; x < cols; x += step) {
+                    if (!(ps[3 * x + 2] > 0.0f) || (nsx[x] == 0.0f && nsy[x] == 0.0f && nsz[x] == 0.0f)) continue;
+                    const cv::Vec3d p = R * cv::Vec3d(ps[3 * x], ps[3 * x + 1], ps[3 * x + 2]) + t;
+                    if (!(p[2] > 0.0)) continue;
+                    const int u = static_cast<int>(std::lround(fx * p[0] / p[2] + cx));
+                    const int v = static_cast<int>(std::lround(fy * p[1] / p[2] + cy));
+                    if (u < 0 || v < 0 || u >= tCols || v >= tRows) continue;
+
+                    const float* qp = tgt.cloud.ptr<float>(v) + 3 * u;
+                    if (!(qp[2] > 0.0f)) continue;
+                    const cv::Vec3d q(qp[0], qp[1], qp[2]);
+                    const cv::Vec3d nq(tgt.normals.nx.ptr<float>(v)[u], tgt.normals.ny.ptr<float>(v)[u],
+                                       tgt.normals.nz.ptr<float>(v)[u]);
+                    if (nq[0] == 0.0 && nq[1] == 0.0 && nq[2] == 0.0) continue;
+                    const cv::Vec3d d = p - q;
+                    if (d.dot(d) > maxD2) continue;
+                    const cv::Vec3d np = R * cv::Vec3d(nsx[x], nsy[x], nsz[x]);
+                    if (np.dot(nq) < minCos) continue;
+
+                    cv::Vec3d n = nq, arm = p;
+                    if (metric == IcpMetric::Symmetric) {
+                        n = np + nq;
+                        n *= 1.0 / std::sqrt(n.dot(n));
+                        arm = p + q;
+                    }
+                    const cv::Vec3d c = arm.cross(n);
+                    const double J[6] = {c[0], c[1], c[2], n[0], n[1], n[2]};
+                    const double r = d.dot(n);
+
+                    int k = 0;
+                    for (int i = 0; i < 6; i++) {
+                        for (int j = i; j < 6; j++) acc[k++] += J[i] * J[j];
+                    }
+                    for (int i = 0; i < 6; i++) acc[21 + i] += J[i] * r;
+                    acc[27] += r * r;
+                    acc[28] += 1.0;
+                }
+            }
+        }
+    });
+
+    std::fill(sums, sums + kSums, 0.0);
+    for (int s = 0; s < kStripes; s++) {
+        for (int k = 0; k < kSums; k++) sums[k] += partial[s * kSums + k];
+    }
+}
+
+bool icpAlign(const IcpFrame& source, const IcpFrame& target, const cv::Matx44d& initial, IcpResult& result,
+              const IcpParams& params) {
+    const int levels = static_cast<int>(std::min(std::min(source.levels.size(), target.levels.size()),
+                                                 params.iterations.size()));
+    CV_Assert(levels >= 1);
+    const float minCos = static_cast<float>(std::cos(params.maxAngleDeg * CV_PI / 180.0));
+
+    result = IcpResult();
+    result.pose = initial;
+
+    for (int level = levels - 1; level >= 0; level--) {
+        const int step = level == 0 ? std::max(1, params.fineStep) : 1;
+        const float maxDistance = params.maxDistance * static_cast<float>(1 << level);
+        result.converged = false;
+
+        for (int it = 0; it < params.iterations[level]; it++) {
+            double sums[kSums];
+            accumulateSystem(source.levels[level], target.levels[level], result.pose, step, maxDistance, minCos,
+                             params.metric, sums);
+            result.pairs = static_cast<int>(sums[28]);
+            if (result.pairs < std::max(6, params.minPairs)) return false;
+            result.rms = static_cast<float>(std::sqrt(sums[27] / sums[28]));
+            result.iterations++;
+
+            cv::Matx66d A;
+            cv::Vec6d b;
+            int k = 0;
+            for (int i = 0; i < 6; i++) {
+                for (int j = i; j < 6; j++) A(i, j) = A(j, i) = sums[k++];
+                b[i] = -sums[21 + i];
+            }
+            // Pairs that do not constrain all six degrees of freedom (one
+            // plane, a cylinder) leave A singular; its solution is noise.
+            // Conditioning is judged on A scaled to a unit diagonal, since
+            // rotation (rad) and translation (mm) columns differ in scale.
+            cv::Matx66d scaled;
+            for (int i = 0; i < 6; i++) {
+                if (!(A(i, i) > 0.0)) return false;
+                for (int j = 0; j < 6; j++) scaled(i, j) = A(i, j) / std::sqrt(A(i, i) * A(j, j));
+            }
+            cv::Vec6d eigenvalues;
+            cv::eigen(scaled, eigenvalues);
+            if (!(eigenvalues[5] > params.minConditioning * eigenvalues[0])) return false;
+            cv::Vec6d x;
+            if (!cv::solve(A, b, x, cv::DECOMP_CHOLESKY)) return false;
+            const cv::Vec3d w(x[0], x[1], x[2]), tau(x[3], x[4], x[5]);
+
+            cv::Matx44d delta;
+            double rotation = std::sqrt(w.dot(w));
+            if (params.metric == IcpMetric::Symmetric) {
+                // Half rotation on both sides of the translation
+                const cv::Matx33d Rh = rotationFromVector(w);
+                delta = makePose(Rh * Rh, Rh * tau);
+                rotation *= 2.0;
+            } else {
+                delta = makePose(rotationFromVector(w), tau);
+            }
+            result.pose = delta * result.pose;
+
+            if (rotation < params.minRotation && std::sqrt(tau.dot(tau)) < params.minTranslation) {
+                result.converged = true;
+                break;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <vector>
+#include <opencv2/core.hpp>
+#include "normals.h"
+
+// ═══════════════════════════════════════════════════════════════════════
+// Projective ICP
+// ═══════════════════════════════════════════════════════════════════════
+//
+// Refines the pose between two cameras from their organized clouds.
+// Correspondences come from projective data association: a source point,
+// moved by the current pose into the target camera, is projected with the
+// target intrinsics and paired with the target point at that pixel. No
+// nearest-neighbor search is needed.
+//
+//   PointToPlane  r = n_q . (T p - q)
+//   Symmetric     r = (n_p + n_q) . (T p - q), solved for a half rotation
+//                 applied on both sides (symmetric ICP); converges in
+//                 fewer iterations on curved parts
+//
+// Pairs are rejected beyond maxDistance (scaled by 2^level) or when the
+// normals differ by more than maxAngleDeg. The 6x6 normal equations are
+// summed over fixed row stripes in parallel and reduced in stripe order,
+// so the result does not depend on the thread count. Levels run coarse to
+// fine on a 2x2 pyramid.
+
+enum class IcpMetric {
+    PointToPlane = 0,
+    Symmetric = 1,
+};
+
+struct IcpParams {
+    IcpMetric metric = IcpMetric::PointToPlane;
+    std::vector<int> iterations = {3, 5, 10};   // per level, finest first; the size sets the level count
+    float maxDistance = 5.0f;                   // mm at the finest level
+    float maxAngleDeg = 30.0f;                  // normal compatibility
+    int fineStep = 2;                           // source sampling step on the finest level
+    double minRotation = 1e-5;                  // rad; smaller updates end a level
+    double minTranslation = 1e-3;               // mm
+    int minPairs = 100;                         // fewer pairs abort the solve
+    double minConditioning = 1e-4;              // smallest / largest eigenvalue of the unit-diagonal
+                                                // normal matrix; below it the pose is underdetermined
+};
+
+// One level of a camera's pyramid
+struct IcpLevel {
+    cv::Mat cloud;                  // CV_32FC3, z <= 0 invalid
+    NormalMap normals;
+    cv::Matx33d K;                  // intrinsics of this level
+};
+
+struct IcpFrame {
+    std::vector<IcpLevel> levels;   // finest first
+};
+
+struct IcpResult {
+    cv::Matx44d pose;               // source camera -> target camera
+    int iterations = 0;
+    int pairs = 0;                  // of the last iteration
+    float rms = 0.0f;               // point-to-plane rms (mm) of the last iteration
+    bool converged = false;
+};
+
+// 4x4 row-major extrinsic (CalibrationParam::extrinsic, or a camera
+// extrinsic from the multi-camera calibration) as a pose
+cv::Matx44d poseFromExtrinsic(const float extrinsic[16]);
+
+// Pyramid of `levels` levels from a getPointcloudData buffer and
+// CalibrationParam::intrinsic; normals of the finest level come from
+// estimateNormals and are averaged for the coarser ones. A frame can be
+// reused for any number of alignments.
+IcpFrame makeIcpFrame(const cv::Mat& cloud, const float intrinsic[9], int levels = 3,
+                      const NormalParams& normalParams = NormalParams());
+
+// Aligns source to target starting from `initial` (source -> target).
+// Returns false when too few pairs were found at some level, or when the
+// pairs leave the pose underdetermined (e.g. a single plane); result.pose
+// then holds the last good estimate.
+bool icpAlign(const IcpFrame& source, const IcpFrame& target, const cv::Matx44d& initial, IcpResult& result,
+              const IcpParams& params = IcpParams());
@@ -0,0 +1,190 @@
+#include "normals.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <opencv2/core/hal/intrin.hpp>
+
+// x, y, z, xx, xy, xz, yy, yz, zz, count
+static const int kChannels = 10;
+
+// ═══════════════════════════════════════════════════════════════════════
+// Eigen Decomposition
+// ═══════════════════════════════════════════════════════════════════════
+
+// Smallest eigenpair of a symmetric 3x3 matrix (closed-form eigenvalues,
+// eigenvector from the best-conditioned row cross product)
+static bool smallestEigen(const double c[6], double n[3], double& lambdaMin, double& trace) {
+    const double a00 = c[0], a01 = c[1], a02 = c[2], a11 = c[3], a12 = c[4], a22 = c[5];
+    trace = a00 + a11 + a22;
+    const double q = trace / 3.0;
+    const double b00 = a00 - q, b11 = a11 - q, b22 = a22 - q;
+    const double p2 = (b00 * b00 + b11 * b11 + b22 * b22 + 2.0 * (a01 * a01 + a02 * a02 + a12 * a12)) / 6.0;
+    if (p2 <= 0.0) return false;
+    const double p = std::sqrt(p2);
+    const double det = b00 * (b11 * b22 - a12 * a12) - a01 * (a01 * b22 - a12 * a02) + a02 * (a01 * a12 - b11 * a02);
+    const double r = std::max(-1.0, std::min(1.0, det / (2.0 * p2 * p)));
+    lambdaMin = q + 2.0 * p * std::cos(std::acos(r) / 3.0 + 2.0 * CV_PI / 3.0);
+
+    const double r0[3] = {a00 - lambdaMin, a01, a02};
+    const double r1[3] = {a01, a11 - lambdaMin, a12};
+    const double r2[3] = {a02, a12, a22 - lambdaMin};
+    const double c01[3] = {r0[1] * r1[2] - r0[2] * r1[1], r0[2] * r1[0] - r0[0] * r1[2], r0[0] * r1[1] - r0[1] * r1[0]};
+    const double c02[3] = {r0[1] * r2[2] - r0[2] * r2[1], r0[2] * r2[0] - r0[0] * r2[2], r0[0] * r2[1] - r0[1] * r2[0]};
+    const double c12[3] = {r1[1] * r2[2] - r1[2] * r2[1], r1[2] * r2[0] - r1[0] * r2[2], r1[0] * r2[1] - r1[1] * r2[0]};
+    const double d01 = c01[0] * c01[0] + c01[1] * c01[1] + c01[2] * c01[2];
+    const double d02 = c02[0] * c02[0] + c02[1] * c02[1] + c02[2] * c02[2];
+    const double d12 = c12[0] * c12[0] + c12[1] * c12[1] + c12[2] * c12[2];
+    const double* best = c01;
+    double dBest = d01;
+    if (d02 > dBest) { best = c02; dBest = d02; }
+    if (d12 > dBest) { best = c12; dBest = d12; }
+    if (dBest <= 0.0) return false;
+    const double inv = 1.0 / std::sqrt(dBest);
+    n[0] = best[0] * inv;
+    n[1] = best[1] * inv;
+    n[2] = best[2] * inv;
+    return true;
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Estimation
+// ═══════════════════════════════════════════════════════════════════════
+
+void estimateNormals(const cv::Mat& cloud, NormalMap& normals, const NormalParams& params) {
+    CV_Assert(cloud.type() == CV_32FC3);
+    const int rows = cloud.rows, cols = cloud.cols;
+    const int minR = std::max(1, params.minRadius), maxR = std::max(minR, params.maxRadius);
+    const int bandRows = std::max(1, params.bandRows);
+    const int bands = (rows + bandRows - 1) / bandRows;
+    const double radiusScale = params.radiusAt1000mm * 1e-3;
+    const float changeScale = params.maxDepthChangeAt1000mm * 1e-3f;
+
+    normals.nx.create(rows, cols, CV_32FC1);
+    normals.ny.create(rows, cols, CV_32FC1);
+    normals.nz.create(rows, cols, CV_32FC1);
+    normals.curvature.create(rows, cols, CV_32FC1);
+
+    cv::parallel_for_(cv::Range(0, bands), [&](const cv::Range& range) {
+        const int stride = (cols + 1) * kChannels;
+        std::vector<double> integral;
+
+        for (int band = range.start; band < range.end; band++) {
+            const int y0 = band * bandRows, y1 = std::min(rows, y0 + bandRows);
+            // Rows [ys, ye) cover every window of the band; integral row i
+            // holds the sums of rows [ys, ys + i)
+            const int ys = std::max(0, y0 - maxR), ye = std::min(rows, y1 + maxR);
+            integral.assign(static_cast<size_t>(ye - ys + 1) * stride, 0.0);
+
+            for (int y = ys; y < ye; y++) {
+                const float* p = cloud.ptr<float>(y);
+                const double* above = &integral[static_cast<size_t>(y - ys) * stride];
+                double* out = &integral[static_cast<size_t>(y - ys + 1) * stride];
+                double acc[kChannels] = {0};
+                for (int x = 0; x < cols; x++) {
+                    const double px = p[3 * x], py = p[3 * x + 1], pz = p[3 * x + 2];
+                    double v[kChannels] = {0};
+                    if (pz > 0.0) {
+                        v[0] = px; v[1] = py; v[2] = pz;
+                        v[3] = px * px; v[4] = px * py; v[5] = px * pz;
+                        v[6] = py * py; v[7] = py * pz; v[8] = pz * pz;
+                        v[9] = 1.0;
+                    }
+                    const double* a = above + (x + 1) * kChannels;
+                    double* o = out + (x + 1) * kChannels;
+#if CV_SIMD128_64F
+                    for (int k = 0; k < kChannels; k += 2) {
+                        cv::v_float64x2 s = cv::v_load(acc + k) + cv::v_load(v + k);
+                        cv::v_store(acc + k, s);
+                        cv::v_store(o + k, cv::v_load(a + k) + s);
+                    }
+#else
+                    for (int k = 0; k < kChannels; k++) {
+                        acc[k] += v[k];
+                        o[k] = a[k] + acc[k];
+                    }
+#endif
+                }
+            }
+
+            for (int y = y0; y < y1; y++) {
+                const float* p = cloud.ptr<float>(y);
+                float* nx = normals.nx.ptr<float>(y);
+                float* ny = normals.ny.ptr<float>(y);
+                float* nz = normals.nz.ptr<float>(y);
+                float* curv = normals.curvature.ptr<float>(y);
+
+                for (int x = 0; x < cols; x++) {
+                    nx[x] = ny[x] = nz[x] = curv[x] = 0.0f;
+                    const float z = p[3 * x + 2];
+                    if (!(z > 0.0f)) continue;
+
+                    // Depth-adaptive radius, halved while the window crosses a
+                    // depth step: at an edge or corner sample, or in its mean
+                    int r = std::max(minR, std::min(maxR, static_cast<int>(std::lround(radiusScale * z))));
+                    const float maxChange = changeScale * z;
+                    auto stepAt = [&](int xx, int yy) {
+                        xx = std::max(0, std::min(cols - 1, xx));
+                        yy = std::max(0, std::min(rows - 1, yy));
+                        const float zn = cloud.ptr<float>(yy)[3 * xx + 2];
+                        return zn > 0.0f && std::abs(zn - z) > maxChange;
+                    };
+                    double s[kChannels];
+                    int wx0, wx1, wy0, wy1;
+                    bool ok = false;
+                    while (true) {
+                        bool step = false;
+                        for (int dy = -r; dy <= r && !step; dy += r) {
+                            for (int dx = -r; dx <= r && !step; dx += r) step = (dx || dy) && stepAt(x + dx, y + dy);
+                        }
+                        if (!step) {
+                            wx0 = std::max(0, x - r);
+                            wx1 = std::min(cols, x + r + 1);
+                            wy0 = std::max(ys, y - r);
+                            wy1 = std::min(ye, y + r + 1);
+                            const double* i00 = &integral[static_cast<size_t>(wy0 - ys) * stride + wx0 * kChannels];
+                            const double* i01 = &integral[static_cast<size_t>(wy0 - ys) * stride + wx1 * kChannels];
+                            const double* i10 = &integral[static_cast<size_t>(wy1 - ys) * stride + wx0 * kChannels];
+                            const double* i11 = &integral[static_cast<size_t>(wy1 - ys) * stride + wx1 * kChannels];
+#if CV_SIMD128_64F
+                            for (int k = 0; k < kChannels; k += 2) {
+                                cv::v_store(s + k, cv::v_load(i11 + k) - cv::v_load(i01 + k) - cv::v_load(i10 + k) +
+                                                   cv::v_load(i00 + k));
+                            }
+#else
+                            for (int k = 0; k < kChannels; k++) s[k] = i11[k] - i01[k] - i10[k] + i00[k];
+#endif
+                            ok = s[9] > 0.0 && std::abs(s[2] / s[9] - z) <= 0.5 * maxChange;
+                        }
+                        if (ok || r == minR) break;
+                        r = std::max(minR, r / 2);
+                    }
+                    if (!ok) continue;
+
+                    const double count = s[9];
+                    const double area = static_cast<double>(wx1 - wx0) * (wy1 - wy0);
+                    if (count < 3.0 || count < params.minValidFraction * area) continue;
+
+                    const double inv = 1.0 / count;
+                    const double mx = s[0] * inv, my = s[1] * inv, mz = s[2] * inv;
+                    const double cov[6] = {
+                        s[3] * inv - mx * mx, s[4] * inv - mx * my, s[5] * inv - mx * mz,
+                        s[6] * inv - my * my, s[7] * inv - my * mz, s[8] * inv - mz * mz
+                    };
+                    double n[3], lambdaMin, trace;
+                    if (!smallestEigen(cov, n, lambdaMin, trace)) continue;
+
+                    // Toward the camera at the origin
+                    if (n[0] * p[3 * x] + n[1] * p[3 * x + 1] + n[2] * z > 0.0) {
+                        n[0] = -n[0];
+                        n[1] = -n[1];
+                        n[2] = -n[2];
+                    }
+                    nx[x] = static_cast<float>(n[0]);
+                    ny[x] = static_cast<float>(n[1]);
+                    nz[x] = static_cast<float>(n[2]);
+                    curv[x] = trace > 0.0 ? static_cast<float>(std::max(0.0, lambdaMin) / trace) : 0.0f;
+                }
+            }
+        }
+    });
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <opencv2/core.hpp>
+
+// ═══════════════════════════════════════════════════════════════════════
+// Integral-Image Normal Estimation
+// ═══════════════════════════════════════════════════════════════════════
+//
+// Normals of an organized getPointcloudData buffer (CV_32FC3, z <= 0
+// invalid) from the covariance of a square pixel window, as in the
+// covariance-matrix method of organized point clouds: the sums
+//     x, y, z, xx, xy, xz, yy, yz, zz, count
+// are integral images, so any window costs four lookups. The normal is
+// the eigenvector of the smallest covariance eigenvalue, oriented toward
+// the camera; curvature is lambda_min / (lambda_0 + lambda_1 + lambda_2).
+//
+// Window radius grows with depth, which keeps the noise of the estimate
+// roughly constant (depth noise grows faster than the pixel footprint):
+//     radius = clamp(round(radiusAt1000mm * z / 1000), minRadius, maxRadius)
+// A window whose edge midpoints step in depth by more than
+// maxDepthChangeAt1000mm * z / 1000 is halved until it does not (object
+// borders); at minRadius the pixel gets no normal.
+//
+// Integrals are double precision and built per band of rows, so memory
+// stays at one band per thread instead of ten full-frame double planes.
+
+struct NormalParams {
+    float radiusAt1000mm = 4.0f;            // window radius (pixels) at z = 1000 mm
+    int minRadius = 1;
+    int maxRadius = 12;
+    float maxDepthChangeAt1000mm = 10.0f;   // mm at z = 1000 mm
+    float minValidFraction = 0.5f;          // valid pixels the window needs
+    int bandRows = 32;                      // rows per integral band
+};
+
+// One plane per component (SoA), all CV_32FC1. Invalid = (0, 0, 0).
+struct NormalMap {
+    cv::Mat nx, ny, nz;
+    cv::Mat curvature;
+};
+
+// Bands are processed in parallel; rows inside a band are SIMD over the
+// integral channels.
+void estimateNormals(const cv::Mat& cloud, NormalMap& normals, const NormalParams& params = NormalParams());
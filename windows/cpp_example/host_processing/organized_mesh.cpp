@@ -0,0 +1,86 @@
+#include "organized_mesh.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+void meshOrganizedCloud(const cv::Mat& cloud, cv::Mat& faces, const OrganizedMeshParams& params) {
+    CV_Assert(cloud.type() == CV_32FC3);
+    const cv::Rect frame(0, 0, cloud.cols, cloud.rows);
+    const cv::Rect area = params.roi.area() > 0 ? params.roi & frame : frame;
+    const int step = std::max(1, params.step);
+    const int cells = area.height > step ? (area.height - 1) / step : 0;     // cell rows
+    const int bandCells = std::max(1, params.bandRows / step);
+    const int bands = (cells + bandCells - 1) / bandCells;
+    const float scale = params.maxEdgeAt1000mm * 1e-3f;
+
+    std::vector<std::vector<cv::Vec3i>> bandFaces(bands);
+
+    cv::parallel_for_(cv::Range(0, bands), [&](const cv::Range& range) {
+        for (int band = range.start; band < range.end; band++) {
+            std::vector<cv::Vec3i>& out = bandFaces[band];
+            const int c0 = band * bandCells, c1 = std::min(cells, c0 + bandCells);
+            out.clear();
+            out.reserve(static_cast<size_t>(c1 - c0) * (area.width / step) * 2);
+
+            for (int cell = c0; cell < c1; cell++) {
+                const int y = area.y + cell * step;
+                const float* top = cloud.ptr<float>(y);
+                const float* bottom = cloud.ptr<float>(y + step);
+
+                for (int x = area.x; x + step < area.x + area.width; x += step) {
+                    // Corners: a top-left, b bottom-left, c top-right, d bottom-right
+                    const float* p[4] = {top + 3 * x, bottom + 3 * x, top + 3 * (x + step), bottom + 3 * (x + step)};
+                    const int id[4] = {y * cloud.cols + x, (y + step) * cloud.cols + x, y * cloud.cols + x + step,
+                                       (y + step) * cloud.cols + x + step};
+                    bool valid[4];
+                    int count = 0;
+                    for (int k = 0; k < 4; k++) count += valid[k] = p[k][2] > 0.0f;
+                    if (count < 3) continue;
+
+                    auto dist2 = [&](int i, int j) {
+                        const float dx = p[i][0] - p[j][0], dy = p[i][1] - p[j][1], dz = p[i][2] - p[j][2];
+                        return dx * dx + dy * dy + dz * dz;
+                    };
+                    auto emit = [&](int i, int j, int k) {
+                        const float zmax = std::max(p[i][2], std::max(p[j][2], p[k][2]));
+                        const float limit = scale * zmax + params.absoluteMaxEdge;
+                        const float limit2 = limit * limit;
+                        if (dist2(i, j) <= limit2 && dist2(j, k) <= limit2 && dist2(k, i) <= limit2) {
+                            out.push_back(cv::Vec3i(id[i], id[j], id[k]));
+                        }
+                    };
+
+                    if (count == 4) {
+                        if (dist2(1, 2) <= dist2(0, 3)) {
+                            emit(0, 1, 2);
+                            emit(2, 1, 3);
+                        } else {
+                            emit(0, 1, 3);
+                            emit(0, 3, 2);
+                        }
+                    } else if (!valid[0]) {
+                        emit(2, 1, 3);
+                    } else if (!valid[1]) {
+                        emit(0, 3, 2);
+                    } else if (!valid[2]) {
+                        emit(0, 1, 3);
+                    } else {
+                        emit(0, 1, 2);
+                    }
+                }
+            }
+        }
+    });
+
+    std::vector<int> offsets(bands + 1, 0);
+    for (int band = 0; band < bands; band++) offsets[band + 1] = offsets[band] + static_cast<int>(bandFaces[band].size());
+
+    faces.create(std::max(1, offsets[bands]), 1, CV_32SC3);
+    cv::parallel_for_(cv::Range(0, bands), [&](const cv::Range& range) {
+        for (int band = range.start; band < range.end; band++) {
+            if (bandFaces[band].empty()) continue;
+            std::memcpy(faces.ptr<int>(offsets[band]), bandFaces[band].data(), bandFaces[band].size() * sizeof(cv::Vec3i));
+        }
+    });
+    faces = faces.rowRange(0, offsets[bands]);
+}
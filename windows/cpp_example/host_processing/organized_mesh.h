@@ -0,0 +1,33 @@
+#pragma once
+#include <opencv2/core.hpp>
+
+// ═══════════════════════════════════════════════════════════════════════
+// Organized Cloud Meshing
+// ═══════════════════════════════════════════════════════════════════════
+//
+// Triangulates a getPointcloudData buffer along its pixel grid: every
+// 2x2 pixel cell gives two triangles split along the shorter diagonal, or
+// one triangle when a single corner is invalid. A triangle is dropped when
+// any of its edges is longer than
+//
+//     maxEdgeAt1000mm * z / 1000 + absoluteMaxEdge     (z: its farthest corner)
+//
+// which removes the skins stretched across depth discontinuities; the
+// linear scaling follows the pixel footprint, like depthToPointCloud.
+// Faces are counter-clockwise seen from the camera.
+//
+// Row bands are meshed in parallel and concatenated in order, so the face
+// order does not depend on the thread count.
+
+struct OrganizedMeshParams {
+    cv::Rect roi;                   // meshed region; empty = whole frame
+    float maxEdgeAt1000mm = 3.0f;   // mm of edge length at z = 1000 mm
+    float absoluteMaxEdge = 0.0f;   // mm added to the scaled limit
+    int step = 1;                   // grid step in pixels; 2 or more decimates the mesh
+    int bandRows = 64;              // rows per parallel band
+};
+
+// cloud: CV_32FC3 (z <= 0 invalid). faces: M x 1 CV_32SC3 of pixel
+// indices (y * cols + x), as taken by savePointcloudToPly.
+void meshOrganizedCloud(const cv::Mat& cloud, cv::Mat& faces,
+                        const OrganizedMeshParams& params = OrganizedMeshParams());
@@ -0,0 +1,296 @@
+#include "phase_decoder.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <opencv2/core/hal/intrin.hpp>
+
+static const float TWO_PI = 6.28318531f;
+
+// ═══════════════════════════════════════════════════════════════════════
+// Geometry and Patterns
+// ═══════════════════════════════════════════════════════════════════════
+
+StructuredLightGeometry geometryFromCalibration(const XEMA::CalibrationParam& calibration,
+                                                const float projectorIntrinsic[9]) {
+    StructuredLightGeometry g;
+    for (int i = 0; i < 9; i++) g.projectorK.val[i] = projectorIntrinsic[i];
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) g.R(r, c) = calibration.extrinsic[4 * r + c];
+        g.T[r] = calibration.extrinsic[4 * r + 3];
+    }
+    return g;
+}
+
+std::vector<cv::Mat> generateFringePatterns(const FringePattern& pattern, const cv::Size& projectorSize) {
+    std::vector<cv::Mat> images;
+    for (int period : pattern.periods) {
+        for (int k = 0; k < pattern.steps; k++) {
+            cv::Mat image(projectorSize, CV_8UC1);
+            const float shift = TWO_PI * k / pattern.steps;
+            for (int u = 0; u < projectorSize.width; u++) {
+                float theta = TWO_PI * period * u / pattern.projectorWidth + shift;
+                image.at<uchar>(0, u) = cv::saturate_cast<uchar>(127.5f + 127.5f * std::cos(theta));
+            }
+            for (int v = 1; v < projectorSize.height; v++) {
+                std::copy(image.ptr<uchar>(0), image.ptr<uchar>(0) + projectorSize.width, image.ptr<uchar>(v));
+            }
+            images.push_back(image);
+        }
+    }
+    return images;
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Synthetic Fringes
+// ═══════════════════════════════════════════════════════════════════════
+
+cv::Mat projectorColumnsFromDepth(const cv::Mat& depth, const DepthRays& rays,
+                                  const StructuredLightGeometry& geometry, int projectorWidth) {
+    CV_Assert(depth.type() == CV_32FC1 && rays.x.size() == depth.size());
+    cv::Mat columns(depth.size(), CV_32FC1);
+    const cv::Matx33f& K = geometry.projectorK;
+
+    cv::parallel_for_(cv::Range(0, depth.rows), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; y++) {
+            const float* z = depth.ptr<float>(y);
+            const float* rx = rays.x.ptr<float>(y);
+            const float* ry = rays.y.ptr<float>(y);
+            float* out = columns.ptr<float>(y);
+            for (int x = 0; x < depth.cols; x++) {
+                out[x] = -1.0f;
+                if (!(z[x] > 0.0f)) continue;
+                cv::Vec3f p = geometry.R * cv::Vec3f(rx[x] * z[x], ry[x] * z[x], z[x]) + geometry.T;
+                if (!(p[2] > 0.0f)) continue;
+                float u = K(0, 0) * p[0] / p[2] + K(0, 2);
+                if (u >= 0.0f && u < projectorWidth) out[x] = u;
+            }
+        }
+    });
+    return columns;
+}
+
+std::vector<cv::Mat> synthesizeFringeImages(const cv::Mat& projectorColumns, const FringePattern& pattern,
+                                            const SyntheticFringeParams& params) {
+    CV_Assert(projectorColumns.type() == CV_32FC1);
+    std::vector<cv::Mat> images;
+    cv::RNG rng(params.seed);
+
+    for (int period : pattern.periods) {
+        for (int k = 0; k < pattern.steps; k++) {
+            cv::Mat image(projectorColumns.size(), CV_8UC1);
+            const float shift = TWO_PI * k / pattern.steps;
+            for (int y = 0; y < image.rows; y++) {
+                const float* u = projectorColumns.ptr<float>(y);
+                uchar* out = image.ptr<uchar>(y);
+                for (int x = 0; x < image.cols; x++) {
+                    float value = params.ambient + static_cast<float>(rng.gaussian(params.noiseSigma));
+                    if (u[x] >= 0.0f) value += params.modulation * std::cos(TWO_PI * period * u[x] / pattern.projectorWidth + shift);
+                    out[x] = cv::saturate_cast<uchar>(value);
+                }
+            }
+            images.push_back(image);
+        }
+    }
+    return images;
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Wrapped Phase
+// ═══════════════════════════════════════════════════════════════════════
+
+#if CV_SIMD128
+// atan2 with a degree-11 odd polynomial on [0, 1] (Abramowitz & Stegun
+// 4.4.49, |error| < 1e-5 rad)
+static inline cv::v_float32x4 v_atan2(const cv::v_float32x4& y, const cv::v_float32x4& x) {
+    const cv::v_float32x4 zero = cv::v_setzero_f32();
+    const cv::v_float32x4 ax = cv::v_abs(x), ay = cv::v_abs(y);
+    const cv::v_float32x4 hi = cv::v_max(ax, ay), lo = cv::v_min(ax, ay);
+    const cv::v_float32x4 a = lo / (hi + cv::v_setall_f32(1e-30f));
+    const cv::v_float32x4 s = a * a;
+    cv::v_float32x4 r = cv::v_muladd(cv::v_setall_f32(-0.0117212f), s, cv::v_setall_f32(0.05265332f));
+    r = cv::v_muladd(r, s, cv::v_setall_f32(-0.11643287f));
+    r = cv::v_muladd(r, s, cv::v_setall_f32(0.19354346f));
+    r = cv::v_muladd(r, s, cv::v_setall_f32(-0.33262347f));
+    r = cv::v_muladd(r, s, cv::v_setall_f32(0.99997726f)) * a;
+    r = cv::v_select(ay > ax, cv::v_setall_f32(1.57079637f) - r, r);
+    r = cv::v_select(x < zero, cv::v_setall_f32(3.14159274f) - r, r);
+    return cv::v_select(y < zero, zero - r, r);
+}
+#endif
+
+// One row of one period: phase in [0, 2 pi) and modulation B
+static void wrappedPhaseRow(const uchar* const* rows, int steps, const float* cosTab, const float* sinTab,
+                            int cols, float* phase, float* modulation) {
+    const float scale = 2.0f / steps;
+    int x = 0;
+#if CV_SIMD128
+    const cv::v_float32x4 zero = cv::v_setzero_f32(), twoPi = cv::v_setall_f32(TWO_PI);
+    const cv::v_float32x4 vscale = cv::v_setall_f32(scale);
+    for (; x <= cols - 4; x += 4) {
+        cv::v_float32x4 S = zero, C = zero;
+        for (int k = 0; k < steps; k++) {
+            cv::v_float32x4 I = cv::v_cvt_f32(cv::v_reinterpret_as_s32(cv::v_load_expand_q(rows[k] + x)));
+            S = cv::v_muladd(I, cv::v_setall_f32(sinTab[k]), S);
+            C = cv::v_muladd(I, cv::v_setall_f32(cosTab[k]), C);
+        }
+        cv::v_float32x4 phi = v_atan2(zero - S, C);
+        cv::v_store(phase + x, cv::v_select(phi < zero, phi + twoPi, phi));
+        cv::v_store(modulation + x, vscale * cv::v_sqrt(cv::v_muladd(S, S, C * C)));
+    }
+#endif
+    for (; x < cols; x++) {
+        float S = 0.0f, C = 0.0f;
+        for (int k = 0; k < steps; k++) {
+            S += rows[k][x] * sinTab[k];
+            C += rows[k][x] * cosTab[k];
+        }
+        float phi = std::atan2(-S, C);
+        phase[x] = phi < 0.0f ? phi + TWO_PI : phi;
+        modulation[x] = scale * std::sqrt(S * S + C * C);
+    }
+}
+
+static void shiftTables(int steps, std::vector<float>& cosTab, std::vector<float>& sinTab) {
+    cosTab.resize(steps);
+    sinTab.resize(steps);
+    for (int k = 0; k < steps; k++) {
+        cosTab[k] = std::cos(TWO_PI * k / steps);
+        sinTab[k] = std::sin(TWO_PI * k / steps);
+    }
+}
+
+void computeWrappedPhase(const cv::Mat* images, int steps, cv::Mat& phase, cv::Mat& modulation) {
+    CV_Assert(steps >= 3);
+    for (int k = 0; k < steps; k++) CV_Assert(images[k].type() == CV_8UC1 && images[k].size() == images[0].size());
+    std::vector<float> cosTab, sinTab;
+    shiftTables(steps, cosTab, sinTab);
+    phase.create(images[0].size(), CV_32FC1);
+    modulation.create(images[0].size(), CV_32FC1);
+
+    cv::parallel_for_(cv::Range(0, images[0].rows), [&](const cv::Range& range) {
+        std::vector<const uchar*> rows(steps);
+        for (int y = range.start; y < range.end; y++) {
+            for (int k = 0; k < steps; k++) rows[k] = images[k].ptr<uchar>(y);
+            wrappedPhaseRow(rows.data(), steps, cosTab.data(), sinTab.data(), images[0].cols,
+                            phase.ptr<float>(y), modulation.ptr<float>(y));
+        }
+    });
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Decoding
+// ═══════════════════════════════════════════════════════════════════════
+
+void decodeFringes(const std::vector<cv::Mat>& images, const FringePattern& pattern,
+                   const StructuredLightGeometry& geometry, const DepthRays& rays,
+                   PhaseDecodeResult& result, const PhaseDecodeParams& params) {
+    const int numPeriods = static_cast<int>(pattern.periods.size());
+    const int steps = pattern.steps;
+    CV_Assert(numPeriods >= 1 && pattern.periods[0] == 1 && steps >= 3);
+    CV_Assert(static_cast<int>(images.size()) == numPeriods * steps);
+    const cv::Size size = images[0].size();
+    for (const cv::Mat& image : images) CV_Assert(image.type() == CV_8UC1 && image.size() == size);
+    CV_Assert(rays.x.size() == size && rays.y.size() == size);
+
+    std::vector<float> cosTab, sinTab;
+    shiftTables(steps, cosTab, sinTab);
+
+    result.projectorColumn.create(size, CV_32FC1);
+    result.modulation.create(size, CV_32FC1);
+    result.depth.create(size, CV_32FC1);
+    result.pointCloud.create(size, CV_32FC3);
+
+    // Projector column u lies on the plane x_p - a * z_p = 0, a = (u - cx) / fx
+    const cv::Matx33f& K = geometry.projectorK;
+    const cv::Matx33f& R = geometry.R;
+    const cv::Vec3f& T = geometry.T;
+    const float columnScale = pattern.projectorWidth / (TWO_PI * pattern.periods.back());
+
+    cv::parallel_for_(cv::Range(0, size.height), [&](const cv::Range& range) {
+        std::vector<float> phase(numPeriods * size.width), modulation(numPeriods * size.width);
+        std::vector<const uchar*> rows(steps);
+
+        for (int y = range.start; y < range.end; y++) {
+            // 1. Wrapped phase of every period
+            for (int p = 0; p < numPeriods; p++) {
+                for (int k = 0; k < steps; k++) rows[k] = images[p * steps + k].ptr<uchar>(y);
+                wrappedPhaseRow(rows.data(), steps, cosTab.data(), sinTab.data(), size.width,
+                                &phase[p * size.width], &modulation[p * size.width]);
+            }
+
+            const float* rx = rays.x.ptr<float>(y);
+            const float* ry = rays.y.ptr<float>(y);
+            float* column = result.projectorColumn.ptr<float>(y);
+            float* mod = result.modulation.ptr<float>(y);
+            float* depth = result.depth.ptr<float>(y);
+            float* cloud = result.pointCloud.ptr<float>(y);
+            const float* finestMod = &modulation[(numPeriods - 1) * size.width];
+
+            // 2. Unwrapping coarse to fine, 3. triangulation
+            int x = 0;
+#if CV_SIMD128
+            const cv::v_float32x4 zero = cv::v_setzero_f32(), minus1 = cv::v_setall_f32(-1.0f);
+            const cv::v_float32x4 twoPi = cv::v_setall_f32(TWO_PI), invTwoPi = cv::v_setall_f32(1.0f / TWO_PI);
+            const cv::v_float32x4 minMod = cv::v_setall_f32(params.minModulation);
+            const cv::v_float32x4 maxErr = cv::v_setall_f32(params.maxUnwrapError);
+            for (; x <= size.width - 4; x += 4) {
+                cv::v_float32x4 Phi = cv::v_load(&phase[x]);
+                cv::v_float32x4 valid = cv::v_load(&modulation[x]) >= minMod;
+                for (int p = 1; p < numPeriods; p++) {
+                    const float ratio = static_cast<float>(pattern.periods[p]) / pattern.periods[p - 1];
+                    cv::v_float32x4 phi = cv::v_load(&phase[p * size.width + x]);
+                    cv::v_float32x4 e = (Phi * cv::v_setall_f32(ratio) - phi) * invTwoPi;
+                    cv::v_float32x4 k = cv::v_cvt_f32(cv::v_round(e));
+                    valid = valid & (cv::v_abs(e - k) <= maxErr) & (cv::v_load(&modulation[p * size.width + x]) >= minMod);
+                    Phi = cv::v_muladd(k, twoPi, phi);
+                }
+                cv::v_float32x4 u = Phi * cv::v_setall_f32(columnScale);
+                cv::v_float32x4 a = (u - cv::v_setall_f32(K(0, 2))) / cv::v_setall_f32(K(0, 0));
+
+                cv::v_float32x4 vrx = cv::v_load(rx + x), vry = cv::v_load(ry + x);
+                cv::v_float32x4 qx = cv::v_muladd(cv::v_setall_f32(R(0, 0)), vrx,
+                                     cv::v_muladd(cv::v_setall_f32(R(0, 1)), vry, cv::v_setall_f32(R(0, 2))));
+                cv::v_float32x4 qz = cv::v_muladd(cv::v_setall_f32(R(2, 0)), vrx,
+                                     cv::v_muladd(cv::v_setall_f32(R(2, 1)), vry, cv::v_setall_f32(R(2, 2))));
+                cv::v_float32x4 den = qx - a * qz;
+                cv::v_float32x4 t = (a * cv::v_setall_f32(T[2]) - cv::v_setall_f32(T[0])) / den;
+                valid = valid & (cv::v_abs(den) > cv::v_setall_f32(1e-6f)) & (t > zero);
+
+                t = cv::v_select(valid, t, zero);
+                cv::v_store(column + x, cv::v_select(valid, u, minus1));
+                cv::v_store(mod + x, cv::v_load(finestMod + x));
+                cv::v_store(depth + x, t);
+                cv::v_store_interleave(cloud + 3 * x, vrx * t, vry * t, t);
+            }
+#endif
+            for (; x < size.width; x++) {
+                float Phi = phase[x];
+                bool valid = modulation[x] >= params.minModulation;
+                for (int p = 1; p < numPeriods; p++) {
+                    const float ratio = static_cast<float>(pattern.periods[p]) / pattern.periods[p - 1];
+                    float phi = phase[p * size.width + x];
+                    float e = (Phi * ratio - phi) / TWO_PI;
+                    float k = std::round(e);
+                    valid = valid && std::abs(e - k) <= params.maxUnwrapError &&
+                            modulation[p * size.width + x] >= params.minModulation;
+                    Phi = phi + TWO_PI * k;
+                }
+                float u = Phi * columnScale;
+                float a = (u - K(0, 2)) / K(0, 0);
+                float qx = R(0, 0) * rx[x] + R(0, 1) * ry[x] + R(0, 2);
+                float qz = R(2, 0) * rx[x] + R(2, 1) * ry[x] + R(2, 2);
+                float den = qx - a * qz;
+                float t = std::abs(den) > 1e-6f ? (a * T[2] - T[0]) / den : 0.0f;
+                valid = valid && t > 0.0f;
+                if (!valid) t = 0.0f;
+
+                column[x] = valid ? u : -1.0f;
+                mod[x] = finestMod[x];
+                depth[x] = t;
+                cloud[3 * x] = rx[x] * t;
+                cloud[3 * x + 1] = ry[x] * t;
+                cloud[3 * x + 2] = t;
+            }
+        }
+    }, params.bands > 0 ? params.bands : -1.0);
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <vector>
+#include <opencv2/core.hpp>
+#include "xcamera.h"
+#include "depth_cloud.h"
+
+// ═══════════════════════════════════════════════════════════════════════
+// Structured-Light Phase Decoder
+// ═══════════════════════════════════════════════════════════════════════
+//
+// Host-side decoding of N-step phase-shifted fringe images with
+// multi-frequency (temporal, coarse to fine) unwrapping and ray / plane
+// triangulation against the projector.
+//
+// The SDK does not transfer the raw fringe images (captureData decodes on
+// the camera, whatever the XemaEngine), and XCamera is the ABI of the
+// shipped library, so the images come from the caller: another camera /
+// projector rig, a future firmware, or synthesizeFringeImages() below for
+// testing without hardware.
+//
+// Image order: for each entry of `periods`, `steps` images shifted by
+// 2 * pi * k / steps. Intensity on projector column u for period P:
+//     I_k(u) = A + B * cos(2 * pi * P * u / projectorWidth + 2 * pi * k / steps)
+
+struct FringePattern {
+    std::vector<int> periods = { 1, 8, 64 };    // fringe periods across the projector, coarse to fine; first must be 1
+    int steps = 4;                              // phase shifts per period (>= 3)
+    int projectorWidth = 1280;                  // projector pixels along the phase axis
+};
+
+// Camera and projector of one structured-light head (projector distortion
+// and skew are not modeled; camera distortion is in the DepthRays)
+struct StructuredLightGeometry {
+    cv::Matx33f projectorK;
+    cv::Matx33f R;          // camera -> projector rotation
+    cv::Vec3f T;            // camera -> projector translation (mm)
+};
+
+// CalibrationParam::extrinsic is taken as the camera -> projector transform
+// (row-major 4x4). The projector intrinsics are not part of
+// CalibrationParam and are passed separately (3x3 row-major).
+StructuredLightGeometry geometryFromCalibration(const XEMA::CalibrationParam& calibration,
+                                                const float projectorIntrinsic[9]);
+
+// Projector patterns to upload (CV_8UC1, in decoding order)
+std::vector<cv::Mat> generateFringePatterns(const FringePattern& pattern, const cv::Size& projectorSize);
+
+// ═══════════════════════════════════════════════════════════════════════
+// Synthetic Fringes
+// ═══════════════════════════════════════════════════════════════════════
+
+struct SyntheticFringeParams {
+    float ambient = 100.0f;         // A (gray levels)
+    float modulation = 80.0f;       // B (gray levels)
+    float noiseSigma = 1.0f;        // additive Gaussian noise (gray levels)
+    uint64 seed = 1;
+};
+
+// Projector column seen by every camera pixel of a depth map; -1 where
+// the depth is invalid or the point is outside the projector
+cv::Mat projectorColumnsFromDepth(const cv::Mat& depth, const DepthRays& rays,
+                                  const StructuredLightGeometry& geometry, int projectorWidth);
+
+// Camera images of the pattern sequence for a projector column map (CV_8UC1)
+std::vector<cv::Mat> synthesizeFringeImages(const cv::Mat& projectorColumns, const FringePattern& pattern,
+                                            const SyntheticFringeParams& params = SyntheticFringeParams());
+
+// ═══════════════════════════════════════════════════════════════════════
+// Decoding
+// ═══════════════════════════════════════════════════════════════════════
+
+struct PhaseDecodeParams {
+    float minModulation = 8.0f;     // gray levels of B on every period, below = invalid
+    float maxUnwrapError = 0.3f;    // periods; coarse / fine disagreement above = invalid
+    int bands = 0;                  // row bands for the thread pool; 0 = OpenCV default
+};
+
+struct PhaseDecodeResult {
+    cv::Mat projectorColumn;        // CV_32FC1, unwrapped projector column, -1 = invalid
+    cv::Mat modulation;             // CV_32FC1, B of the finest period
+    cv::Mat depth;                  // CV_32FC1, mm, 0 = invalid
+    cv::Mat pointCloud;             // CV_32FC3, getPointcloudData layout
+};
+
+// Wrapped phase in [0, 2 pi) and modulation of one period (`steps` CV_8UC1 images)
+void computeWrappedPhase(const cv::Mat* images, int steps, cv::Mat& phase, cv::Mat& modulation);
+
+// Phase, unwrapping and triangulation fused per row; rows are split in
+// bands over the thread pool
+void decodeFringes(const std::vector<cv::Mat>& images, const FringePattern& pattern,
+                   const StructuredLightGeometry& geometry, const DepthRays& rays,
+                   PhaseDecodeResult& result, const PhaseDecodeParams& params = PhaseDecodeParams());
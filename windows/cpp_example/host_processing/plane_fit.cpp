@@ -0,0 +1,296 @@
+#include "plane_fit.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <vector>
+#include <opencv2/core/hal/intrin.hpp>
+
+// ═══════════════════════════════════════════════════════════════════════
+// Subsample
+// ═══════════════════════════════════════════════════════════════════════
+
+// Valid points of the strided subsample as separate x/y/z arrays, so the
+// hypothesis scoring below runs on contiguous lanes.
+struct PointSoA {
+    std::vector<float> x, y, z;
+    size_t size() const { return z.size(); }
+};
+
+// True where the pixel has a point and enough confidence
+static inline bool usablePoint(const cv::Vec3f& p, const uchar* confidence, int c, int minConfidence) {
+    return p[2] > 0.0f && (!confidence || confidence[c] >= minConfidence);
+}
+
+static PointSoA gatherSubsample(const cv::Mat& cloud, const cv::Rect& roi, int stride,
+                                const cv::Mat& confidence, int minConfidence) {
+    PointSoA pts;
+    for (int r = roi.y; r < roi.y + roi.height; r += stride) {
+        const cv::Vec3f* row = cloud.ptr<cv::Vec3f>(r);
+        const uchar* conf = confidence.empty() ? nullptr : confidence.ptr<uchar>(r);
+        for (int c = roi.x; c < roi.x + roi.width; c += stride) {
+            const cv::Vec3f& p = row[c];
+            if (!usablePoint(p, conf, c, minConfidence)) continue;
+            pts.x.push_back(p[0]);
+            pts.y.push_back(p[1]);
+            pts.z.push_back(p[2]);
+        }
+    }
+    return pts;
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// RANSAC
+// ═══════════════════════════════════════════════════════════════════════
+
+struct PlaneHypothesis {
+    float a, b, c, d;
+};
+
+// Plane through three subsample points; false for (near) collinear samples.
+static bool planeFromSample(const PointSoA& pts, int i0, int i1, int i2, PlaneHypothesis& h) {
+    cv::Vec3f p0(pts.x[i0], pts.y[i0], pts.z[i0]);
+    cv::Vec3f e1 = cv::Vec3f(pts.x[i1], pts.y[i1], pts.z[i1]) - p0;
+    cv::Vec3f e2 = cv::Vec3f(pts.x[i2], pts.y[i2], pts.z[i2]) - p0;
+    cv::Vec3f n = e1.cross(e2);
+    float len = static_cast<float>(cv::norm(n));
+    if (len < 1e-3f * static_cast<float>(cv::norm(e1) * cv::norm(e2))) return false;
+    n *= 1.0f / len;
+    h.a = n[0];
+    h.b = n[1];
+    h.c = n[2];
+    h.d = -n.dot(p0);
+    return true;
+}
+
+static int countInliers(const PointSoA& pts, const PlaneHypothesis& h, float threshold) {
+    const int n = static_cast<int>(pts.size());
+    const float* xs = pts.x.data();
+    const float* ys = pts.y.data();
+    const float* zs = pts.z.data();
+    int count = 0;
+    int i = 0;
+#if CV_SIMD128
+    const cv::v_float32x4 va = cv::v_setall_f32(h.a), vb = cv::v_setall_f32(h.b);
+    const cv::v_float32x4 vc = cv::v_setall_f32(h.c), vd = cv::v_setall_f32(h.d);
+    const cv::v_float32x4 vthr = cv::v_setall_f32(threshold);
+    const cv::v_float32x4 one = cv::v_setall_f32(1.0f), zero = cv::v_setzero_f32();
+    cv::v_float32x4 acc = zero;
+    for (; i <= n - 4; i += 4) {
+        cv::v_float32x4 dist = cv::v_muladd(va, cv::v_load(xs + i),
+                               cv::v_muladd(vb, cv::v_load(ys + i),
+                               cv::v_muladd(vc, cv::v_load(zs + i), vd)));
+        acc += cv::v_select(cv::v_abs(dist) < vthr, one, zero);
+    }
+    count = cvRound(cv::v_reduce_sum(acc));
+#endif
+    for (; i < n; i++) {
+        if (std::abs(h.a * xs[i] + h.b * ys[i] + h.c * zs[i] + h.d) < threshold) count++;
+    }
+    return count;
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Least-Squares Refinement
+// ═══════════════════════════════════════════════════════════════════════
+
+// Weighted sums over the inliers, relative to `origin` for numerical
+// stability. Weights are confidence / 255, or 1 without a confidence map.
+struct PlaneMoments {
+    double n;           // inlier count
+    double w;           // weight sum
+    double s[3];        // x, y, z
+    double ss[6];       // xx, xy, xz, yy, yz, zz
+};
+
+static void addRowSums(PlaneMoments& mom, const float* s, const float* ss, float count, float weight) {
+    mom.n += count;
+    mom.w += weight;
+    for (int k = 0; k < 3; k++) mom.s[k] += s[k];
+    for (int k = 0; k < 6; k++) mom.ss[k] += ss[k];
+}
+
+static PlaneMoments accumulateInliers(const cv::Mat& cloud, const cv::Rect& roi, const PlaneHypothesis& h,
+                                      float threshold, const cv::Point3f& origin,
+                                      const cv::Mat& confidence, int minConfidence) {
+    PlaneMoments total = {};
+    std::mutex mutex;
+
+    cv::parallel_for_(cv::Range(roi.y, roi.y + roi.height), [&](const cv::Range& range) {
+        PlaneMoments local = {};
+        const float ox = origin.x, oy = origin.y, oz = origin.z;
+        // Offset form of the plane: h.a*x' + h.b*y' + h.c*z' + dOff for x' = x - origin
+        const float dOff = h.a * ox + h.b * oy + h.c * oz + h.d;
+
+        for (int r = range.start; r < range.end; r++) {
+            const float* row = cloud.ptr<float>(r) + 3 * roi.x;
+            const uchar* conf = confidence.empty() ? nullptr : confidence.ptr<uchar>(r) + roi.x;
+            float s[3] = { 0, 0, 0 };
+            float ss[6] = { 0, 0, 0, 0, 0, 0 };
+            float cnt = 0.0f, wsum = 0.0f;
+
+            int c = 0;
+#if CV_SIMD128
+            const cv::v_float32x4 zero = cv::v_setzero_f32(), one = cv::v_setall_f32(1.0f);
+            const cv::v_float32x4 va = cv::v_setall_f32(h.a), vb = cv::v_setall_f32(h.b);
+            const cv::v_float32x4 vc = cv::v_setall_f32(h.c), vd = cv::v_setall_f32(dOff);
+            const cv::v_float32x4 vox = cv::v_setall_f32(ox), voy = cv::v_setall_f32(oy), voz = cv::v_setall_f32(oz);
+            const cv::v_float32x4 vthr = cv::v_setall_f32(threshold);
+            const cv::v_float32x4 vminConf = cv::v_setall_f32(static_cast<float>(minConfidence));
+            const cv::v_float32x4 inv255 = cv::v_setall_f32(1.0f / 255.0f);
+            cv::v_float32x4 vn = zero, vw = zero, sx = zero, sy = zero, sz = zero;
+            cv::v_float32x4 sxx = zero, sxy = zero, sxz = zero, syy = zero, syz = zero, szz = zero;
+
+            for (; c <= roi.width - 4; c += 4) {
+                cv::v_float32x4 x, y, z;
+                cv::v_load_deinterleave(row + 3 * c, x, y, z);
+                cv::v_float32x4 valid = z > zero;
+                x = x - vox;
+                y = y - voy;
+                z = z - voz;
+                cv::v_float32x4 dist = cv::v_muladd(va, x, cv::v_muladd(vb, y, cv::v_muladd(vc, z, vd)));
+                cv::v_float32x4 mask = valid & (cv::v_abs(dist) < vthr);
+                cv::v_float32x4 w = one;
+                if (conf) {
+                    cv::v_float32x4 cf = cv::v_cvt_f32(cv::v_reinterpret_as_s32(cv::v_load_expand_q(conf + c)));
+                    mask = mask & (cf >= vminConf);
+                    w = cf * inv255;
+                }
+                w = cv::v_select(mask, w, zero);
+                vn += cv::v_select(mask, one, zero);
+                vw += w;
+                cv::v_float32x4 xw = x * w, yw = y * w, zw = z * w;
+                sx += xw;
+                sy += yw;
+                sz += zw;
+                sxx = cv::v_muladd(xw, x, sxx);
+                sxy = cv::v_muladd(xw, y, sxy);
+                sxz = cv::v_muladd(xw, z, sxz);
+                syy = cv::v_muladd(yw, y, syy);
+                syz = cv::v_muladd(yw, z, syz);
+                szz = cv::v_muladd(zw, z, szz);
+            }
+            cnt = cv::v_reduce_sum(vn);
+            wsum = cv::v_reduce_sum(vw);
+            s[0] = cv::v_reduce_sum(sx); s[1] = cv::v_reduce_sum(sy); s[2] = cv::v_reduce_sum(sz);
+            ss[0] = cv::v_reduce_sum(sxx); ss[1] = cv::v_reduce_sum(sxy); ss[2] = cv::v_reduce_sum(sxz);
+            ss[3] = cv::v_reduce_sum(syy); ss[4] = cv::v_reduce_sum(syz); ss[5] = cv::v_reduce_sum(szz);
+#endif
+            for (; c < roi.width; c++) {
+                const float* p = row + 3 * c;
+                if (!(p[2] > 0.0f) || (conf && conf[c] < minConfidence)) continue;
+                float x = p[0] - ox, y = p[1] - oy, z = p[2] - oz;
+                if (std::abs(h.a * x + h.b * y + h.c * z + dOff) >= threshold) continue;
+                float w = conf ? conf[c] / 255.0f : 1.0f;
+                cnt += 1.0f;
+                wsum += w;
+                s[0] += w * x; s[1] += w * y; s[2] += w * z;
+                ss[0] += w * x * x; ss[1] += w * x * y; ss[2] += w * x * z;
+                ss[3] += w * y * y; ss[4] += w * y * z; ss[5] += w * z * z;
+            }
+            addRowSums(local, s, ss, cnt, wsum);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        total.n += local.n;
+        total.w += local.w;
+        for (int k = 0; k < 3; k++) total.s[k] += local.s[k];
+        for (int k = 0; k < 6; k++) total.ss[k] += local.ss[k];
+    });
+
+    return total;
+}
+
+static int countValid(const cv::Mat& cloud, const cv::Rect& roi, const cv::Mat& confidence, int minConfidence) {
+    int count = 0;
+    for (int r = roi.y; r < roi.y + roi.height; r++) {
+        const cv::Vec3f* row = cloud.ptr<cv::Vec3f>(r);
+        const uchar* conf = confidence.empty() ? nullptr : confidence.ptr<uchar>(r);
+        for (int c = roi.x; c < roi.x + roi.width; c++) {
+            if (usablePoint(row[c], conf, c, minConfidence)) count++;
+        }
+    }
+    return count;
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Dominant Plane
+// ═══════════════════════════════════════════════════════════════════════
+
+PlaneFitResult fitDominantPlane(const cv::Mat& pointCloud, const PlaneFitParams& params) {
+    PlaneFitResult result = {};
+    CV_Assert(pointCloud.type() == CV_32FC3);
+
+    cv::Rect roi = params.roi.area() > 0 ? params.roi & cv::Rect(0, 0, pointCloud.cols, pointCloud.rows)
+                                         : cv::Rect(0, 0, pointCloud.cols, pointCloud.rows);
+    CV_Assert(params.confidence.empty() ||
+              (params.confidence.type() == CV_8UC1 && params.confidence.size() == pointCloud.size()));
+    result.support = countValid(pointCloud, roi, params.confidence, params.minConfidence);
+
+    PointSoA pts = gatherSubsample(pointCloud, roi, std::max(1, params.stride), params.confidence, params.minConfidence);
+    const int n = static_cast<int>(pts.size());
+    if (n < 3) return result;
+
+    // 1. Hypotheses are drawn sequentially (reproducible), scored in parallel
+    cv::RNG rng(params.seed);
+    std::vector<PlaneHypothesis> hypotheses;
+    for (int attempt = 0; attempt < 10 * params.iterations && static_cast<int>(hypotheses.size()) < params.iterations; attempt++) {
+        int i0 = rng.uniform(0, n), i1 = rng.uniform(0, n), i2 = rng.uniform(0, n);
+        if (i0 == i1 || i1 == i2 || i0 == i2) continue;
+        PlaneHypothesis h;
+        if (planeFromSample(pts, i0, i1, i2, h)) hypotheses.push_back(h);
+    }
+    if (hypotheses.empty()) return result;
+
+    std::vector<int> scores(hypotheses.size());
+    cv::parallel_for_(cv::Range(0, static_cast<int>(hypotheses.size())), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; i++) {
+            scores[i] = countInliers(pts, hypotheses[i], params.inlierThreshold);
+        }
+    });
+
+    int best = 0;
+    for (size_t i = 1; i < scores.size(); i++) {
+        if (scores[i] > scores[best]) best = static_cast<int>(i);
+    }
+    if (scores[best] < 3) return result;
+
+    // 2. PCA on the full-resolution inliers, re-gated by the refined plane
+    PlaneHypothesis plane = hypotheses[best];
+    cv::Point3f origin(pts.x[0], pts.y[0], pts.z[0]);
+    for (int iter = 0; iter < std::max(1, params.refineIterations); iter++) {
+        PlaneMoments mom = accumulateInliers(pointCloud, roi, plane, params.inlierThreshold, origin,
+                                             params.confidence, params.minConfidence);
+        if (mom.n < 3 || !(mom.w > 0.0)) return result;
+
+        double inv = 1.0 / mom.w;
+        double mx = mom.s[0] * inv, my = mom.s[1] * inv, mz = mom.s[2] * inv;
+        cv::Matx33d cov(mom.ss[0] * inv - mx * mx, mom.ss[1] * inv - mx * my, mom.ss[2] * inv - mx * mz,
+                        mom.ss[1] * inv - mx * my, mom.ss[3] * inv - my * my, mom.ss[4] * inv - my * mz,
+                        mom.ss[2] * inv - mx * mz, mom.ss[4] * inv - my * mz, mom.ss[5] * inv - mz * mz);
+        cv::Mat eigenvalues, eigenvectors;
+        cv::eigen(cv::Mat(cov), eigenvalues, eigenvectors);
+
+        // Smallest eigenvalue is last
+        cv::Vec3f normal(static_cast<float>(eigenvectors.at<double>(2, 0)),
+                         static_cast<float>(eigenvectors.at<double>(2, 1)),
+                         static_cast<float>(eigenvectors.at<double>(2, 2)));
+        if (normal[2] < 0) normal = -normal;
+        cv::Point3f centroid(static_cast<float>(origin.x + mx), static_cast<float>(origin.y + my),
+                             static_cast<float>(origin.z + mz));
+
+        plane.a = normal[0];
+        plane.b = normal[1];
+        plane.c = normal[2];
+        plane.d = -normal.dot(cv::Vec3f(centroid.x, centroid.y, centroid.z));
+
+        result.normal = normal;
+        result.d = plane.d;
+        result.centroid = centroid;
+        result.inliers = static_cast<int>(mom.n);
+        result.rms = static_cast<float>(std::sqrt(std::max(0.0, eigenvalues.at<double>(2))));
+        result.valid = true;
+        origin = centroid;
+    }
+
+    return result;
+}
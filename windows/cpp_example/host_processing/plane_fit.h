@@ -0,0 +1,43 @@
+#pragma once
+#include <opencv2/core.hpp>
+
+// ═══════════════════════════════════════════════════════════════════════
+// Dominant Plane Fit
+// ═══════════════════════════════════════════════════════════════════════
+//
+// Robust fit of the largest plane in an organized point cloud
+// (getPointcloudData layout, CV_32FC3, z <= 0 invalid):
+//   1. RANSAC on a strided subsample kept as x/y/z arrays, hypotheses
+//      scored in parallel with SIMD,
+//   2. least-squares refinement (PCA) on the full-resolution inliers,
+//      weighted by the confidence map when one is given.
+//
+// The plane is normal . p + d = 0 with |normal| = 1 and normal.z >= 0.
+
+struct PlaneFitParams {
+    cv::Rect roi;                   // region of the image to use; empty = whole image
+    int stride = 4;                 // subsample step for the RANSAC stage (pixels)
+    int iterations = 256;           // RANSAC hypotheses
+    float inlierThreshold = 1.0f;   // |distance| limit (mm)
+    int refineIterations = 3;       // least-squares passes on full-resolution inliers
+    uint64 seed = 0x2545F4914F6CDD1DULL;
+    cv::Mat confidence;             // optional CV_8UC1 per-pixel weight (computeConfidence); empty = uniform
+    int minConfidence = 0;          // pixels below are ignored
+};
+
+struct PlaneFitResult {
+    cv::Vec3f normal;
+    float d;
+    cv::Point3f centroid;           // mean of the inliers (lies on the plane)
+    int inliers;                    // full-resolution inliers of the final fit
+    int support;                    // valid points inside the ROI
+    float rms;                      // RMS distance of the inliers (mm)
+    bool valid;
+};
+
+PlaneFitResult fitDominantPlane(const cv::Mat& pointCloud, const PlaneFitParams& params = PlaneFitParams());
+
+// Signed point-to-plane distance
+inline float planePointDistance(const PlaneFitResult& plane, const cv::Point3f& p) {
+    return plane.normal[0] * p.x + plane.normal[1] * p.y + plane.normal[2] * p.z + plane.d;
+}
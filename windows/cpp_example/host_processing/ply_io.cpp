@@ -0,0 +1,173 @@
+#include "ply_io.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+// Triangle list (3 indices per face) as `list uchar int vertex_indices`
+static void writeFaces(std::ofstream& file, const int* indices, size_t faces, bool binary) {
+    if (!binary) {
+        for (size_t i = 0; i < faces; i++) {
+            file << "3 " << indices[3 * i] << " " << indices[3 * i + 1] << " " << indices[3 * i + 2] << "\n";
+        }
+        return;
+    }
+    // Chunks of 13-byte records
+    const size_t chunk = 4096;
+    std::vector<char> buffer(chunk * 13);
+    for (size_t first = 0; first < faces; first += chunk) {
+        const size_t n = std::min(chunk, faces - first);
+        char* out = buffer.data();
+        for (size_t i = first; i < first + n; i++) {
+            *out++ = 3;
+            std::memcpy(out, indices + 3 * i, 3 * sizeof(int));
+            out += 3 * sizeof(int);
+        }
+        file.write(buffer.data(), out - buffer.data());
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Point Cloud
+// ═══════════════════════════════════════════════════════════════════════
+
+int savePointcloudToPly(const cv::Mat& cloud, const cv::Mat& brightness, const std::string& path,
+                        const NormalMap* normals, bool binary, const cv::Mat& faces) {
+    CV_Assert(cloud.type() == CV_32FC3);
+    CV_Assert(brightness.empty() ||
+              ((brightness.type() == CV_8UC1 || brightness.type() == CV_8UC3) && brightness.size() == cloud.size()));
+    CV_Assert(!normals || (normals->nx.size() == cloud.size() && normals->ny.size() == cloud.size() &&
+                           normals->nz.size() == cloud.size()));
+    CV_Assert(faces.empty() || (faces.type() == CV_32SC3 && faces.isContinuous()));
+    const int channels = brightness.empty() ? 0 : brightness.channels();
+
+    // Vertex number of every pixel, -1 when invalid (needed for faces only)
+    std::vector<int> vertexOf(faces.empty() ? 0 : cloud.total(), -1);
+    size_t count = 0;
+    for (int y = 0; y < cloud.rows; y++) {
+        const float* p = cloud.ptr<float>(y);
+        for (int x = 0; x < cloud.cols; x++) {
+            if (!(p[3 * x + 2] > 0.0f)) continue;
+            if (!vertexOf.empty()) vertexOf[y * cloud.cols + x] = static_cast<int>(count);
+            count++;
+        }
+    }
+
+    // Faces renumbered to the written vertices
+    std::vector<int> faceIndices;
+    faceIndices.reserve(faces.total() * 3);
+    const int* f = faces.empty() ? nullptr : faces.ptr<int>();
+    for (size_t i = 0; i < faces.total(); i++) {
+        int v[3];
+        bool ok = true;
+        for (int k = 0; k < 3 && ok; k++) {
+            const int pixel = f[3 * i + k];
+            ok = pixel >= 0 && pixel < static_cast<int>(vertexOf.size()) && (v[k] = vertexOf[pixel]) >= 0;
+        }
+        if (ok) faceIndices.insert(faceIndices.end(), v, v + 3);
+    }
+
+    std::ofstream file(path, binary ? std::ios::out | std::ios::binary : std::ios::out);
+    if (!file.is_open()) {
+        std::cerr << "Cannot open: " << path << std::endl;
+        return -1;
+    }
+
+    file << "ply\n" << (binary ? "format binary_little_endian 1.0\n" : "format ascii 1.0\n");
+    file << "element vertex " << count << "\n";
+    file << "property float x\nproperty float y\nproperty float z\n";
+    if (normals) file << "property float nx\nproperty float ny\nproperty float nz\n";
+    if (channels) file << "property uchar red\nproperty uchar green\nproperty uchar blue\n";
+    if (!faces.empty()) file << "element face " << faceIndices.size() / 3 << "\nproperty list uchar int vertex_indices\n";
+    file << "end_header\n";
+    // 9 significant digits round-trip a float; the default 6 rounds
+    // coordinates around 1000 mm to 0.01 mm
+    file << std::setprecision(9);
+
+    // One row of records at a time
+    const size_t record = 3 * sizeof(float) + (normals ? 3 * sizeof(float) : 0) + (channels ? 3 : 0);
+    std::vector<char> buffer(record * cloud.cols);
+
+    for (int y = 0; y < cloud.rows; y++) {
+        const float* p = cloud.ptr<float>(y);
+        const uchar* b = channels ? brightness.ptr<uchar>(y) : nullptr;
+        const float* nx = normals ? normals->nx.ptr<float>(y) : nullptr;
+        const float* ny = normals ? normals->ny.ptr<float>(y) : nullptr;
+        const float* nz = normals ? normals->nz.ptr<float>(y) : nullptr;
+        char* out = buffer.data();
+
+        for (int x = 0; x < cloud.cols; x++) {
+            if (!(p[3 * x + 2] > 0.0f)) continue;
+            uchar rgb[3] = {0, 0, 0};
+            if (channels == 1) rgb[0] = rgb[1] = rgb[2] = b[x];
+            else if (channels == 3) std::memcpy(rgb, b + 3 * x, 3);
+
+            if (binary) {
+                std::memcpy(out, p + 3 * x, 3 * sizeof(float));
+                out += 3 * sizeof(float);
+                if (normals) {
+                    const float n[3] = {nx[x], ny[x], nz[x]};
+                    std::memcpy(out, n, sizeof(n));
+                    out += sizeof(n);
+                }
+                if (channels) {
+                    std::memcpy(out, rgb, 3);
+                    out += 3;
+                }
+            } else {
+                file << p[3 * x] << " " << p[3 * x + 1] << " " << p[3 * x + 2];
+                if (normals) file << " " << nx[x] << " " << ny[x] << " " << nz[x];
+                if (channels) file << " " << int(rgb[0]) << " " << int(rgb[1]) << " " << int(rgb[2]);
+                file << "\n";
+            }
+        }
+        if (binary) file.write(buffer.data(), out - buffer.data());
+    }
+    if (!faces.empty()) writeFaces(file, faceIndices.data(), faceIndices.size() / 3, binary);
+
+    if (!file) {
+        std::cerr << "Write Error: " << path << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Mesh
+// ═══════════════════════════════════════════════════════════════════════
+
+int saveMeshToPly(const TriangleMesh& mesh, const std::string& path, bool binary) {
+    CV_Assert(mesh.vertices.empty() || (mesh.vertices.type() == CV_32FC3 && mesh.vertices.isContinuous()));
+    CV_Assert(mesh.faces.empty() || (mesh.faces.type() == CV_32SC3 && mesh.faces.isContinuous()));
+    const int vertices = static_cast<int>(mesh.vertices.total()), faces = static_cast<int>(mesh.faces.total());
+
+    std::ofstream file(path, binary ? std::ios::out | std::ios::binary : std::ios::out);
+    if (!file.is_open()) {
+        std::cerr << "Cannot open: " << path << std::endl;
+        return -1;
+    }
+
+    file << "ply\n" << (binary ? "format binary_little_endian 1.0\n" : "format ascii 1.0\n");
+    file << "element vertex " << vertices << "\n";
+    file << "property float x\nproperty float y\nproperty float z\n";
+    file << "element face " << faces << "\n";
+    file << "property list uchar int vertex_indices\n";
+    file << "end_header\n";
+    file << std::setprecision(9);
+
+    const float* v = vertices ? mesh.vertices.ptr<float>() : nullptr;
+    if (binary) {
+        if (vertices) file.write(reinterpret_cast<const char*>(v), static_cast<std::streamsize>(vertices) * 3 * sizeof(float));
+    } else {
+        for (int i = 0; i < vertices; i++) file << v[3 * i] << " " << v[3 * i + 1] << " " << v[3 * i + 2] << "\n";
+    }
+    writeFaces(file, faces ? mesh.faces.ptr<int>() : nullptr, faces, binary);
+
+    if (!file) {
+        std::cerr << "Write Error: " << path << std::endl;
+        return -1;
+    }
+    return 0;
+}
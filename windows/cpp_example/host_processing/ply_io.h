@@ -0,0 +1,32 @@
+#pragma once
+#include <string>
+#include <opencv2/core.hpp>
+#include "normals.h"
+
+// ═══════════════════════════════════════════════════════════════════════
+// PLY Export
+// ═══════════════════════════════════════════════════════════════════════
+//
+// Host-side counterpart of the SDK's savePointcloudToPly (not exported by
+// the Windows XCamera), with optional normals and faces. Vertex properties:
+//     x y z [nx ny nz] [red green blue]
+// Only valid points (z > 0) are written. Binary output is little endian.
+
+// cloud: CV_32FC3 (organized or N x 1). brightness (optional): CV_8UC1 or
+// CV_8UC3 in RGB order (getColorBrightnessData(XemaColor::Rgb)), same size.
+// normals (optional): estimateNormals output of the same size.
+// faces (optional): M x 1 CV_32SC3 of pixel indices (y * cols + x), as
+// from meshOrganizedCloud; renumbered to the written vertices, faces with
+// an invalid corner are skipped.
+// Returns 0 on success, -1 when the file cannot be written.
+int savePointcloudToPly(const cv::Mat& cloud, const cv::Mat& brightness, const std::string& path,
+                        const NormalMap* normals = nullptr, bool binary = true, const cv::Mat& faces = cv::Mat());
+
+struct TriangleMesh {
+    cv::Mat vertices;       // N x 1 CV_32FC3
+    cv::Mat faces;          // M x 1 CV_32SC3, vertex indices, counter-clockwise seen from outside
+};
+
+// Vertex properties x y z, face property `list uchar int vertex_indices`.
+// Returns 0 on success, -1 when the file cannot be written.
+int saveMeshToPly(const TriangleMesh& mesh, const std::string& path, bool binary = true);
@@ -0,0 +1,213 @@
+#include "radius_filter.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <opencv2/core/hal/intrin.hpp>
+
+// ═══════════════════════════════════════════════════════════════════════
+// Focal Length
+// ═══════════════════════════════════════════════════════════════════════
+
+float estimateFocalLength(const cv::Mat& pointCloud) {
+    CV_Assert(pointCloud.type() == CV_32FC3);
+
+    // Adjacent pixels on a surface facing the camera are z / f apart in x
+    std::vector<float> samples;
+    for (int r = 0; r < pointCloud.rows; r += 16) {
+        const cv::Vec3f* row = pointCloud.ptr<cv::Vec3f>(r);
+        for (int c = 0; c + 1 < pointCloud.cols; c += 16) {
+            const cv::Vec3f& p0 = row[c];
+            const cv::Vec3f& p1 = row[c + 1];
+            if (!(p0[2] > 0.0f) || !(p1[2] > 0.0f)) continue;
+            if (std::abs(p1[2] - p0[2]) > 0.01f * p0[2]) continue;
+            float dx = p1[0] - p0[0];
+            if (dx <= 0.0f) continue;
+            samples.push_back(p0[2] / dx);
+        }
+    }
+    if (samples.empty()) return 0.0f;
+
+    std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+    return samples[samples.size() / 2];
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Window Offsets
+// ═══════════════════════════════════════════════════════════════════════
+
+struct WindowOffset {
+    int dx, dy;
+    float reach;    // max(|dx|, |dy|): the smallest window half-size containing it
+};
+
+// Every offset of the largest window except (0, 0), nearest first, so
+// that typical inliers are confirmed after the first few dozen.
+static std::vector<WindowOffset> windowOffsets(int maxW) {
+    std::vector<WindowOffset> offsets;
+    for (int dy = -maxW; dy <= maxW; dy++) {
+        for (int dx = -maxW; dx <= maxW; dx++) {
+            if (dx == 0 && dy == 0) continue;
+            WindowOffset o = { dx, dy, static_cast<float>(std::max(std::abs(dx), std::abs(dy))) };
+            offsets.push_back(o);
+        }
+    }
+    std::stable_sort(offsets.begin(), offsets.end(), [](const WindowOffset& a, const WindowOffset& b) {
+        return a.dx * a.dx + a.dy * a.dy < b.dx * b.dx + b.dy * b.dy;
+    });
+    return offsets;
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Filter
+// ═══════════════════════════════════════════════════════════════════════
+
+void radiusOutlierFilter(const cv::Mat& pointCloud, cv::Mat& mask, const RadiusFilterParams& params) {
+    CV_Assert(pointCloud.type() == CV_32FC3);
+    const int rows = pointCloud.rows;
+    const int cols = pointCloud.cols;
+    const cv::Rect frame(0, 0, cols, rows);
+    const cv::Rect roi = params.roi.area() > 0 ? params.roi & frame : frame;
+
+    const float f = params.focalLength > 0.0f ? params.focalLength : estimateFocalLength(pointCloud);
+    const float windowScale = params.radius * f;
+    const float r2 = params.radius * params.radius;
+    const int maxW = std::max(1, params.maxWindowRadius);
+
+    // x / y / z planes padded by maxW invalid columns, so shifted loads stay in bounds
+    const int pad = maxW;
+    cv::Mat planes[3];
+    for (int k = 0; k < 3; k++) planes[k] = cv::Mat::zeros(rows, cols + 2 * pad, CV_32FC1);
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+        for (int r = range.start; r < range.end; r++) {
+            const float* src = pointCloud.ptr<float>(r);
+            float* px = planes[0].ptr<float>(r) + pad;
+            float* py = planes[1].ptr<float>(r) + pad;
+            float* pz = planes[2].ptr<float>(r) + pad;
+            int c = 0;
+#if CV_SIMD128
+            for (; c <= cols - 4; c += 4) {
+                cv::v_float32x4 x, y, z;
+                cv::v_load_deinterleave(src + 3 * c, x, y, z);
+                cv::v_store(px + c, x);
+                cv::v_store(py + c, y);
+                cv::v_store(pz + c, z);
+            }
+#endif
+            for (; c < cols; c++) {
+                px[c] = src[3 * c];
+                py[c] = src[3 * c + 1];
+                pz[c] = src[3 * c + 2];
+            }
+        }
+    });
+
+    const std::vector<WindowOffset> offsets = windowOffsets(maxW);
+    const int numOffsets = static_cast<int>(offsets.size());
+    const int firstPass = std::min(numOffsets, params.minNeighbors + params.minNeighbors / 4 + 4);
+
+    mask.create(rows, cols, CV_8UC1);
+
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+        std::vector<float> reach(cols), count(cols);
+        const float* nx[128];
+        const float* ny[128];
+        const float* nz[128];
+        CV_Assert(2 * maxW + 1 <= 128);
+
+        for (int r = range.start; r < range.end; r++) {
+            const float* cx = planes[0].ptr<float>(r) + pad;
+            const float* cy = planes[1].ptr<float>(r) + pad;
+            const float* cz = planes[2].ptr<float>(r) + pad;
+            uchar* dst = mask.ptr<uchar>(r);
+
+            // Valid points outside the ROI are kept unchanged
+            for (int c = 0; c < cols; c++) dst[c] = cz[c] > 0.0f ? 255 : 0;
+            if (r < roi.y || r >= roi.y + roi.height) continue;
+
+            // Neighbor row pointers by dy; rows outside the image are skipped
+            for (int dy = -maxW; dy <= maxW; dy++) {
+                bool inside = r + dy >= 0 && r + dy < rows;
+                nx[dy + maxW] = inside ? planes[0].ptr<float>(r + dy) + pad : nullptr;
+                ny[dy + maxW] = inside ? planes[1].ptr<float>(r + dy) + pad : nullptr;
+                nz[dy + maxW] = inside ? planes[2].ptr<float>(r + dy) + pad : nullptr;
+            }
+
+            // Window half-size bounded by the radius projected at each depth; -1 for invalid points
+            for (int c = roi.x; c < roi.x + roi.width; c++) {
+                float z = cz[c];
+                if (!(z > 0.0f)) reach[c] = -1.0f;
+                else if (windowScale > 0.0f) reach[c] = std::min(static_cast<float>(maxW), std::max(1.0f, std::ceil(windowScale / z)));
+                else reach[c] = static_cast<float>(maxW);
+            }
+
+            // 1. Nearest offsets for four centers at a time
+            const int c0 = roi.x, c1 = roi.x + roi.width;
+            int c = c0;
+#if CV_SIMD128
+            const cv::v_float32x4 vr2 = cv::v_setall_f32(r2);
+            const cv::v_float32x4 zero = cv::v_setzero_f32(), one = cv::v_setall_f32(1.0f);
+            for (; c <= c1 - 4; c += 4) {
+                const cv::v_float32x4 px = cv::v_load(cx + c), py = cv::v_load(cy + c), pz = cv::v_load(cz + c);
+                const cv::v_float32x4 vw = cv::v_load(&reach[c]);
+                cv::v_float32x4 cnt = zero;
+                for (int k = 0; k < firstPass; k++) {
+                    const WindowOffset& o = offsets[k];
+                    const int row = o.dy + maxW;
+                    if (!nz[row]) continue;
+                    cv::v_float32x4 z = cv::v_load(nz[row] + c + o.dx);
+                    cv::v_float32x4 dx = cv::v_load(nx[row] + c + o.dx) - px;
+                    cv::v_float32x4 dy = cv::v_load(ny[row] + c + o.dx) - py;
+                    cv::v_float32x4 dz = z - pz;
+                    cv::v_float32x4 d2 = cv::v_muladd(dx, dx, cv::v_muladd(dy, dy, dz * dz));
+                    cv::v_float32x4 hit = (d2 < vr2) & (z > zero) & (cv::v_setall_f32(o.reach) <= vw);
+                    cnt += cv::v_select(hit, one, zero);
+                }
+                cv::v_store(&count[c], cnt);
+            }
+#endif
+            for (; c < c1; c++) {
+                int n = 0;
+                for (int k = 0; k < firstPass; k++) {
+                    const WindowOffset& o = offsets[k];
+                    const int row = o.dy + maxW;
+                    if (!nz[row] || o.reach > reach[c]) continue;
+                    float z = nz[row][c + o.dx];
+                    if (!(z > 0.0f)) continue;
+                    float dx = nx[row][c + o.dx] - cx[c], dy = ny[row][c + o.dx] - cy[c], dz = z - cz[c];
+                    if (dx * dx + dy * dy + dz * dz < r2) n++;
+                }
+                count[c] = static_cast<float>(n);
+            }
+
+            // 2. Undecided points continue through the rest of their window
+            for (c = c0; c < c1; c++) {
+                if (reach[c] < 0.0f) continue;
+                int n = static_cast<int>(count[c]);
+                for (int k = firstPass; k < numOffsets && n < params.minNeighbors; k++) {
+                    const WindowOffset& o = offsets[k];
+                    const int row = o.dy + maxW;
+                    if (!nz[row] || o.reach > reach[c]) continue;
+                    float z = nz[row][c + o.dx];
+                    if (!(z > 0.0f)) continue;
+                    float dx = nx[row][c + o.dx] - cx[c], dy = ny[row][c + o.dx] - cy[c], dz = z - cz[c];
+                    if (dx * dx + dy * dy + dz * dz < r2) n++;
+                }
+                dst[c] = n >= params.minNeighbors ? 255 : 0;
+            }
+        }
+    });
+}
+
+void applyPointMask(cv::Mat& pointCloud, const cv::Mat& mask) {
+    CV_Assert(pointCloud.type() == CV_32FC3 && mask.type() == CV_8UC1 && mask.size() == pointCloud.size());
+
+    cv::parallel_for_(cv::Range(0, pointCloud.rows), [&](const cv::Range& range) {
+        for (int r = range.start; r < range.end; r++) {
+            cv::Vec3f* p = pointCloud.ptr<cv::Vec3f>(r);
+            const uchar* m = mask.ptr<uchar>(r);
+            for (int c = 0; c < pointCloud.cols; c++) {
+                if (!m[c]) p[c] = cv::Vec3f(0.0f, 0.0f, 0.0f);
+            }
+        }
+    });
+}
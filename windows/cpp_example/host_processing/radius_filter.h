@@ -0,0 +1,31 @@
+#pragma once
+#include <opencv2/core.hpp>
+
+// ═══════════════════════════════════════════════════════════════════════
+// Radius Outlier Filter
+// ═══════════════════════════════════════════════════════════════════════
+//
+// Host-side counterpart of setParamRadiusFilter(use, radius, num): a point
+// is kept when at least minNeighbors other points lie within `radius`.
+// The organized pixel grid of getPointcloudData is the neighborhood
+// structure: a point at depth z can only have neighbors inside a pixel
+// window of half-size radius * f / z, so no kd-tree is built.
+
+struct RadiusFilterParams {
+    float radius = 2.0f;            // mm (radius_filter_r)
+    int minNeighbors = 40;          // radius_filter_threshold_num
+    cv::Rect roi;                   // filtered region; empty = whole frame, outside points are kept
+    float focalLength = 0.0f;       // pixels; 0 = estimated from the cloud
+    int maxWindowRadius = 16;       // cap on the pixel half-window
+};
+
+// pointCloud: CV_32FC3 (z <= 0 invalid). mask: CV_8UC1, 255 = keep,
+// 0 = removed or invalid. Rows are processed in parallel.
+void radiusOutlierFilter(const cv::Mat& pointCloud, cv::Mat& mask,
+                         const RadiusFilterParams& params = RadiusFilterParams());
+
+// Focal length (pixels) from the spacing of horizontally adjacent points
+float estimateFocalLength(const cv::Mat& pointCloud);
+
+// Sets the points where mask == 0 to (0, 0, 0), the SDK's invalid value
+void applyPointMask(cv::Mat& pointCloud, const cv::Mat& mask);
@@ -0,0 +1,199 @@
+#include "reflect_filter.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <opencv2/core/hal/intrin.hpp>
+
+// ═══════════════════════════════════════════════════════════════════════
+// Saturation Dilation
+// ═══════════════════════════════════════════════════════════════════════
+
+// 255 where brightness >= level within `radius` columns
+static void saturatedRows(const cv::Mat& brightness, uchar level, int radius, cv::Mat& dilated) {
+    const int rows = brightness.rows, cols = brightness.cols;
+    dilated.create(rows, cols, CV_8UC1);
+
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& range) {
+        std::vector<uchar> padded(cols + 2 * radius + 16, 0);
+        uchar* flags = &padded[radius];
+        for (int y = range.start; y < range.end; y++) {
+            const uchar* b = brightness.ptr<uchar>(y);
+            uchar* out = dilated.ptr<uchar>(y);
+
+            int x = 0;
+#if CV_SIMD128
+            const cv::v_uint8x16 vlevel = cv::v_setall_u8(level);
+            for (; x <= cols - 16; x += 16) cv::v_store(flags + x, cv::v_load(b + x) >= vlevel);
+#endif
+            for (; x < cols; x++) flags[x] = b[x] >= level ? 255 : 0;
+
+            x = 0;
+#if CV_SIMD128
+            for (; x <= cols - 16; x += 16) {
+                cv::v_uint8x16 v = cv::v_load(flags + x - radius);
+                for (int k = 1; k <= 2 * radius; k++) v = v | cv::v_load(flags + x - radius + k);
+                cv::v_store(out + x, v);
+            }
+#endif
+            for (; x < cols; x++) {
+                uchar v = 0;
+                for (int k = -radius; k <= radius; k++) v |= flags[x + k];
+                out[x] = v;
+            }
+        }
+    });
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Filter
+// ═══════════════════════════════════════════════════════════════════════
+
+void reflectionFilter(const std::vector<const DepthFrame*>& frames, cv::Mat& depth, const ReflectFilterParams& params,
+                      cv::Mat* reasons) {
+    CV_Assert(!frames.empty());
+    const cv::Size size = frames[0]->depth.size();
+    for (const DepthFrame* f : frames) {
+        CV_Assert(f->depth.type() == CV_32FC1 && f->depth.size() == size);
+        CV_Assert(f->brightness.type() == CV_8UC1 && f->brightness.size() == size);
+    }
+    const int rows = size.height, cols = size.width;
+    const int witnesses = static_cast<int>(frames.size()) - 1;
+
+    // Neighbor reads must see the unfiltered reference
+    const cv::Mat src = depth.data == frames[0]->depth.data ? frames[0]->depth.clone() : frames[0]->depth;
+    if (depth.data != frames[0]->depth.data) src.copyTo(depth);
+    if (reasons) *reasons = cv::Mat::zeros(size, CV_8UC1);
+
+    const cv::Rect frame(0, 0, cols, rows);
+    const cv::Rect area = params.roi.area() > 0 ? params.roi & frame : frame;
+    if (area.area() == 0) return;
+
+    const int bloom = std::min(8, std::max(0, params.bloomRadius));
+    const uchar satLevel = cv::saturate_cast<uchar>(std::ceil(params.saturationLevel));
+    cv::Mat saturated;
+    saturatedRows(frames[0]->brightness, satLevel, bloom, saturated);
+
+    const float consistency = params.consistencyAt1000mm * 1e-3f;
+    const float agreement = params.agreementAt1000mm * 1e-3f;
+    const float minAgreeing = static_cast<float>(params.minAgreeing);
+
+    cv::parallel_for_(cv::Range(area.y, area.y + area.height), [&](const cv::Range& range) {
+        const std::vector<float> invalidRow(cols + 2, 0.0f);
+        std::vector<uchar> satRow(cols + 16);
+        std::vector<const float*> wz(witnesses);
+        std::vector<const uchar*> wb(witnesses);
+
+        for (int y = range.start; y < range.end; y++) {
+            // Vertical part of the bloom dilation
+            const int y0 = std::max(0, y - bloom), y1 = std::min(rows - 1, y + bloom);
+            std::copy(saturated.ptr<uchar>(y0), saturated.ptr<uchar>(y0) + cols, satRow.begin());
+            for (int r = y0 + 1; r <= y1; r++) {
+                const uchar* s = saturated.ptr<uchar>(r);
+                int x = 0;
+#if CV_SIMD128
+                for (; x <= cols - 16; x += 16) cv::v_store(&satRow[x], cv::v_load(&satRow[x]) | cv::v_load(s + x));
+#endif
+                for (; x < cols; x++) satRow[x] |= s[x];
+            }
+
+            const float* zc = src.ptr<float>(y);
+            const float* zu = y > 0 ? src.ptr<float>(y - 1) : invalidRow.data() + 1;
+            const float* zd = y + 1 < rows ? src.ptr<float>(y + 1) : invalidRow.data() + 1;
+            for (int i = 0; i < witnesses; i++) {
+                wz[i] = frames[i + 1]->depth.ptr<float>(y);
+                wb[i] = frames[i + 1]->brightness.ptr<uchar>(y);
+            }
+            float* out = depth.ptr<float>(y);
+            uchar* why = reasons ? reasons->ptr<uchar>(y) : nullptr;
+
+            auto filterPixel = [&](int x) {
+                const float z = zc[x];
+                if (!(z > 0.0f)) return;
+                int reason = satRow[x] ? ReflectSaturated : 0;
+
+                const float tol = consistency * z;
+                int agreeing = 0;
+                for (int dy = -1; dy <= 1; dy++) {
+                    const float* zr = dy < 0 ? zu : (dy > 0 ? zd : zc);
+                    for (int dx = -1; dx <= 1; dx++) {
+                        if ((dx == 0 && dy == 0) || x + dx < 0 || x + dx >= cols) continue;
+                        const float zn = zr[x + dx];
+                        if (zn > 0.0f && std::abs(zn - z) <= tol) agreeing++;
+                    }
+                }
+                if (agreeing < minAgreeing) reason |= ReflectInconsistent;
+
+                const float atol = agreement * z;
+                int agree = 0, disagree = 0;
+                for (int i = 0; i < witnesses; i++) {
+                    const float zw = wz[i][x];
+                    if (!(zw > 0.0f) || wb[i][x] >= satLevel) continue;
+                    if (std::abs(zw - z) <= atol) agree++;
+                    else disagree++;
+                }
+                if (disagree > 0 && disagree >= agree) reason |= ReflectDisagreeing;
+
+                if (reason) {
+                    out[x] = 0.0f;
+                    if (why) why[x] = static_cast<uchar>(reason);
+                }
+            };
+
+            const int xEnd = area.x + area.width;
+            int x = area.x;
+#if CV_SIMD128
+            const cv::v_float32x4 zero = cv::v_setzero_f32(), one = cv::v_setall_f32(1.0f);
+            const cv::v_float32x4 vcons = cv::v_setall_f32(consistency), vagree = cv::v_setall_f32(agreement);
+            const cv::v_float32x4 vminAgree = cv::v_setall_f32(minAgreeing), vsat = cv::v_setall_f32(satLevel);
+            const cv::v_float32x4 vSatBit = cv::v_setall_f32(ReflectSaturated);
+            const cv::v_float32x4 vConsBit = cv::v_setall_f32(ReflectInconsistent);
+            const cv::v_float32x4 vAgreeBit = cv::v_setall_f32(ReflectDisagreeing);
+
+            // Columns whose neighborhood is inside the image
+            for (; x < std::min(xEnd, 1); x++) filterPixel(x);
+            for (; x <= std::min(xEnd, cols - 1) - 4; x += 4) {
+                const cv::v_float32x4 z = cv::v_load(zc + x);
+                const cv::v_float32x4 valid = z > zero;
+                if (!cv::v_check_any(valid)) continue;
+
+                const cv::v_float32x4 tol = vcons * z;
+                cv::v_float32x4 agreeing = zero;
+                const float* neighbors[8] = {
+                    zu + x - 1, zu + x, zu + x + 1,
+                    zc + x - 1,         zc + x + 1,
+                    zd + x - 1, zd + x, zd + x + 1
+                };
+                for (int k = 0; k < 8; k++) {
+                    cv::v_float32x4 zn = cv::v_load(neighbors[k]);
+                    agreeing += cv::v_select((zn > zero) & (cv::v_abs(zn - z) <= tol), one, zero);
+                }
+
+                const cv::v_float32x4 atol = vagree * z;
+                cv::v_float32x4 agree = zero, disagree = zero;
+                for (int i = 0; i < witnesses; i++) {
+                    cv::v_float32x4 zw = cv::v_load(wz[i] + x);
+                    cv::v_float32x4 bw = cv::v_cvt_f32(cv::v_reinterpret_as_s32(cv::v_load_expand_q(wb[i] + x)));
+                    cv::v_float32x4 usable = (zw > zero) & (bw < vsat);
+                    cv::v_float32x4 close = cv::v_abs(zw - z) <= atol;
+                    agree += cv::v_select(usable & close, one, zero);
+                    disagree += cv::v_select(usable & ~close, one, zero);
+                }
+
+                cv::v_float32x4 sat = cv::v_cvt_f32(cv::v_reinterpret_as_s32(cv::v_load_expand_q(&satRow[x])));
+                cv::v_float32x4 reason = cv::v_select(sat > zero, vSatBit, zero);
+                reason += cv::v_select(agreeing < vminAgree, vConsBit, zero);
+                reason += cv::v_select((disagree > zero) & (disagree >= agree), vAgreeBit, zero);
+                const cv::v_float32x4 reject = valid & (reason > zero);
+
+                cv::v_store(out + x, cv::v_select(reject, zero, z));
+                if (why && cv::v_check_any(reject)) {
+                    float bits[4];
+                    cv::v_store(bits, cv::v_select(reject, reason, zero));
+                    for (int l = 0; l < 4; l++) why[x + l] = static_cast<uchar>(bits[l]);
+                }
+            }
+#endif
+            for (; x < xEnd; x++) filterPixel(x);
+        }
+    });
+}
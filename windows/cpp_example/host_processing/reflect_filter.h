@@ -0,0 +1,47 @@
+#pragma once
+#include <vector>
+#include <opencv2/core.hpp>
+#include "confidence.h"
+
+// ═══════════════════════════════════════════════════════════════════════
+// Specular and Multipath Suppression
+// ═══════════════════════════════════════════════════════════════════════
+//
+// Host-side complement to setParamReflectFilter (one scalar on the
+// camera). Depth of the reference frame (frames[0]) is rejected by three
+// cues:
+//
+//   saturated     brightness >= saturationLevel within bloomRadius pixels
+//                 (clipped fringes and the blooming around highlights)
+//   inconsistent  fewer than minAgreeing of the 8 neighbors within
+//                 consistencyAt1000mm * z / 1000 (multipath speckle)
+//   disagreeing   other exposures (frames[1..]), where not saturated,
+//                 give a different depth: at least as many witnesses
+//                 disagree by more than agreementAt1000mm * z / 1000 as
+//                 agree. Inter-reflections shift with exposure while the
+//                 direct return does not.
+//
+// Single-frame input uses the first two cues only.
+
+enum ReflectReason {
+    ReflectSaturated = 1,
+    ReflectInconsistent = 2,
+    ReflectDisagreeing = 4,
+};
+
+struct ReflectFilterParams {
+    cv::Rect roi;                       // filtered region; empty = whole frame, outside is copied
+    float saturationLevel = 250.0f;     // brightness of clipped fringes
+    int bloomRadius = 2;                // pixels around a saturated pixel also rejected (0-8)
+    float consistencyAt1000mm = 2.0f;   // neighbor agreement (mm) at z = 1000 mm
+    int minAgreeing = 3;                // agreeing neighbors (of 8) a pixel needs
+    float agreementAt1000mm = 1.5f;     // exposure agreement (mm) at z = 1000 mm
+};
+
+// frames: depth CV_32FC1 and brightness CV_8UC1, all of one size.
+// depth: frames[0]->depth with rejected pixels set to 0 (may be
+// frames[0]->depth itself). reasons (optional): CV_8UC1 ReflectReason bits
+// of each rejected pixel, 0 = kept or invalid.
+// Rows are processed in parallel.
+void reflectionFilter(const std::vector<const DepthFrame*>& frames, cv::Mat& depth,
+                      const ReflectFilterParams& params = ReflectFilterParams(), cv::Mat* reasons = nullptr);
@@ -0,0 +1,285 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include "reflect_filter.h"
+
+// ═══════════════════════════════════════════════════════════════════════
+// Reflection Filter Benchmark
+// ═══════════════════════════════════════════════════════════════════════
+//
+// Times reflectionFilter on recorded shiny-part captures, or on a
+// rendered shiny cylinder with known artifacts when no list is given.
+//
+// Usage: reflect_filter_bench [--list FILE] [--runs N] [--width W] [--height H]
+//                             [--exposures N] [--seed N] [--budget MS]
+//
+// List file, one exposure per line, grouped by frame id; the first line
+// of a frame is the reference exposure:
+//     frame brightPath depthPath
+// Depth is a CV_32FC1 or CV_16UC1 (mm) TIFF as saved by the camera GUI.
+//
+// The synthetic part has a saturated specular stripe with bloom, a
+// multipath patch whose depth bias changes with exposure, and speckle;
+// precision and recall are reported against that ground truth. Exits with
+// 1 when the p99 latency exceeds --budget.
+
+struct BenchOptions {
+    std::string listFile;
+    int runs = 50;
+    int width = 1920;
+    int height = 1200;
+    int exposures = 2;
+    uint64 seed = 12345;
+    double budgetMs = -1.0;
+};
+
+struct BenchFrame {
+    std::vector<DepthFrame> exposures;
+    cv::Mat artifacts;          // CV_8UC1 ground truth, empty for recorded frames
+};
+
+static double elapsedMs(int64 start) {
+    return (cv::getTickCount() - start) * 1000.0 / cv::getTickFrequency();
+}
+
+static double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    size_t idx = static_cast<size_t>(std::ceil(p / 100.0 * values.size()));
+    return values[std::min(values.size() - 1, idx > 0 ? idx - 1 : 0)];
+}
+
+static void printLatency(const std::string& name, const std::vector<double>& values) {
+    std::cout << "  " << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(3)
+              << "  p50 " << std::setw(9) << percentile(values, 50)
+              << "  p90 " << std::setw(9) << percentile(values, 90)
+              << "  p99 " << std::setw(9) << percentile(values, 99)
+              << "  max " << std::setw(9) << percentile(values, 100) << " ms" << std::endl;
+}
+
+static bool parseOptions(int argc, char** argv, BenchOptions& opt) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--list" && hasValue) opt.listFile = argv[++i];
+        else if (arg == "--runs" && hasValue) opt.runs = std::atoi(argv[++i]);
+        else if (arg == "--width" && hasValue) opt.width = std::atoi(argv[++i]);
+        else if (arg == "--height" && hasValue) opt.height = std::atoi(argv[++i]);
+        else if (arg == "--exposures" && hasValue) opt.exposures = std::atoi(argv[++i]);
+        else if (arg == "--seed" && hasValue) opt.seed = static_cast<uint64>(std::atoll(argv[++i]));
+        else if (arg == "--budget" && hasValue) opt.budgetMs = std::atof(argv[++i]);
+        else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        }
+    }
+    return opt.runs > 0 && opt.width > 16 && opt.height > 16 && opt.exposures >= 1;
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Frames
+// ═══════════════════════════════════════════════════════════════════════
+
+static std::vector<BenchFrame> loadFrames(const std::string& filename) {
+    std::vector<BenchFrame> frames;
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Cannot open: " << filename << std::endl;
+        return frames;
+    }
+
+    std::map<int, size_t> index;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream iss(line);
+        int id;
+        std::string brightPath, depthPath;
+        if (!(iss >> id >> brightPath >> depthPath)) continue;
+
+        DepthFrame f;
+        f.brightness = cv::imread(brightPath, cv::IMREAD_GRAYSCALE);
+        cv::Mat depth = cv::imread(depthPath, cv::IMREAD_UNCHANGED);
+        if (f.brightness.empty() || depth.empty()) {
+            std::cerr << "Cannot load: " << brightPath << " / " << depthPath << std::endl;
+            continue;
+        }
+        if (depth.type() != CV_16UC1 && depth.type() != CV_32FC1) {
+            std::cerr << "Unsupported depth type: " << depthPath << std::endl;
+            continue;
+        }
+        depth.convertTo(f.depth, CV_32FC1);
+
+        if (!index.count(id)) {
+            index[id] = frames.size();
+            frames.emplace_back();
+        }
+        BenchFrame& frame = frames[index[id]];
+        if (!frame.exposures.empty() && f.depth.size() != frame.exposures[0].depth.size()) {
+            std::cerr << "Size mismatch in frame " << id << std::endl;
+            continue;
+        }
+        frame.exposures.push_back(f);
+    }
+    return frames;
+}
+
+// Horizontal cylinder (axis along x) at 600 mm; exposure i is 4^i times
+// shorter than the reference
+static BenchFrame renderShinyPart(const BenchOptions& opt, cv::RNG& rng) {
+    const int w = opt.width, h = opt.height;
+    const float radius = 0.4f * h;
+    const int stripe0 = h / 2 - h / 40, stripe1 = h / 2 + h / 40;
+    const cv::Rect patch(w / 5, h / 5, w / 8, h / 8);
+
+    BenchFrame frame;
+    frame.artifacts = cv::Mat::zeros(h, w, CV_8UC1);
+    cv::Mat truth(h, w, CV_32FC1), albedo(h, w, CV_32FC1);
+    for (int y = 0; y < h; y++) {
+        const float dy = (y - h * 0.5f) / radius;
+        const float bulge = dy * dy < 1.0f ? std::sqrt(1.0f - dy * dy) : 0.0f;
+        for (int x = 0; x < w; x++) {
+            truth.at<float>(y, x) = bulge > 0.0f ? 600.0f - 60.0f * bulge : 0.0f;
+            albedo.at<float>(y, x) = 120.0f * bulge;
+        }
+    }
+
+    for (int e = 0; e < opt.exposures; e++) {
+        const float scale = std::pow(0.25f, static_cast<float>(e));
+        DepthFrame f;
+        f.depth.create(h, w, CV_32FC1);
+        f.brightness.create(h, w, CV_8UC1);
+        for (int y = 0; y < h; y++) {
+            const bool inStripe = y >= stripe0 && y < stripe1;
+            const bool inBloom = y >= stripe0 - 2 && y < stripe1 + 2;
+            for (int x = 0; x < w; x++) {
+                const float z = truth.at<float>(y, x);
+                float b = albedo.at<float>(y, x) * scale;
+                float zm = z > 0.0f ? z + rng.gaussian(0.05) : 0.0f;
+                bool bad = false;
+                if (z > 0.0f && inStripe) {
+                    // Specular highlight: clipped in the reference, fringes lost
+                    b = 2000.0f * scale;
+                    if (b >= 250.0f) {
+                        zm = z + static_cast<float>(rng.uniform(-8.0, 8.0));
+                        bad = true;
+                    }
+                } else if (z > 0.0f && inBloom && e == 0) {
+                    zm = z + static_cast<float>(rng.uniform(-3.0, 3.0));
+                    bad = true;
+                }
+                if (z > 0.0f && patch.contains(cv::Point(x, y))) {
+                    // Inter-reflection: smooth bias that shrinks with exposure
+                    zm += 4.0f * scale;
+                    bad = bad || 4.0f * scale > 1.0f;
+                }
+                if (z > 0.0f && rng.uniform(0.0, 1.0) < 0.002) {
+                    zm = z + static_cast<float>(rng.uniform(-20.0, 20.0));
+                    bad = true;
+                }
+                f.depth.at<float>(y, x) = zm;
+                f.brightness.at<uchar>(y, x) = cv::saturate_cast<uchar>(b + rng.gaussian(1.0));
+                if (e == 0 && bad) frame.artifacts.at<uchar>(y, x) = 255;
+            }
+        }
+        frame.exposures.push_back(f);
+    }
+    return frame;
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Main
+// ═══════════════════════════════════════════════════════════════════════
+
+int main(int argc, char** argv) {
+    BenchOptions opt;
+    if (!parseOptions(argc, argv, opt)) {
+        std::cerr << "Usage: reflect_filter_bench [--list FILE] [--runs N] [--width W] [--height H]"
+                  << " [--exposures N] [--seed N] [--budget MS]" << std::endl;
+        return -1;
+    }
+
+    cv::RNG rng(opt.seed);
+    std::vector<BenchFrame> frames;
+    if (opt.listFile.empty()) frames.push_back(renderShinyPart(opt, rng));
+    else frames = loadFrames(opt.listFile);
+    if (frames.empty()) {
+        std::cerr << "No frames" << std::endl;
+        return -1;
+    }
+
+    std::cout << "=== Reflection Filter Benchmark ===" << std::endl;
+    std::cout << "  " << (opt.listFile.empty() ? "Synthetic shiny cylinder" : "Recorded: " + opt.listFile) << ", "
+              << frames.size() << " frame(s), " << frames[0].exposures[0].depth.cols << "x"
+              << frames[0].exposures[0].depth.rows << ", " << opt.runs << " runs, "
+              << cv::getNumThreads() << " threads" << std::endl;
+
+    ReflectFilterParams params;
+    std::vector<double> single, multi;
+    long long valid = 0, rejected = 0, truePositive = 0, artifacts = 0, goodRejected = 0;
+    int reasonCounts[3] = {0, 0, 0};
+
+    for (const BenchFrame& frame : frames) {
+        std::vector<const DepthFrame*> all, reference;
+        for (const DepthFrame& f : frame.exposures) all.push_back(&f);
+        reference.push_back(all[0]);
+
+        cv::Mat depth, reasons;
+        for (int run = 0; run < opt.runs; run++) {
+            int64 t = cv::getTickCount();
+            reflectionFilter(reference, depth, params);
+            single.push_back(elapsedMs(t));
+            if (all.size() > 1) {
+                t = cv::getTickCount();
+                reflectionFilter(all, depth, params);
+                multi.push_back(elapsedMs(t));
+            }
+        }
+
+        reflectionFilter(all, depth, params, &reasons);
+        const cv::Mat& input = frame.exposures[0].depth;
+        for (int y = 0; y < input.rows; y++) {
+            for (int x = 0; x < input.cols; x++) {
+                if (!(input.at<float>(y, x) > 0.0f)) continue;
+                valid++;
+                const uchar why = reasons.at<uchar>(y, x);
+                const bool bad = !frame.artifacts.empty() && frame.artifacts.at<uchar>(y, x);
+                if (why) rejected++;
+                for (int k = 0; k < 3; k++) reasonCounts[k] += (why >> k) & 1;
+                if (bad) artifacts++;
+                if (bad && why) truePositive++;
+                if (!frame.artifacts.empty() && !bad && why) goodRejected++;
+            }
+        }
+    }
+
+    std::cout << "\n--- Latency ---" << std::endl;
+    printLatency("1 exposure", single);
+    if (!multi.empty()) printLatency(std::to_string(frames[0].exposures.size()) + " exposures", multi);
+
+    std::cout << "\n--- Rejection ---" << std::endl;
+    std::cout << "  " << rejected << "/" << valid << " valid pixels (" << std::setprecision(2)
+              << 100.0 * rejected / std::max(1LL, valid) << " %): saturated " << reasonCounts[0]
+              << ", inconsistent " << reasonCounts[1] << ", disagreeing " << reasonCounts[2] << std::endl;
+    if (artifacts > 0) {
+        std::cout << "  Recall " << 100.0 * truePositive / artifacts << " %, precision "
+                  << 100.0 * truePositive / std::max(1LL, rejected) << " %, good pixels rejected "
+                  << 100.0 * goodRejected / std::max(1LL, valid - artifacts) << " %" << std::endl;
+    }
+
+    const std::vector<double>& timed = multi.empty() ? single : multi;
+    if (opt.budgetMs >= 0 && percentile(timed, 99) > opt.budgetMs) {
+        std::cerr << "FAIL: p99 latency above " << opt.budgetMs << " ms" << std::endl;
+        return 1;
+    }
+    return 0;
+}
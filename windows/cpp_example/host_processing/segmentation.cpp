@@ -0,0 +1,331 @@
+#include "segmentation.h"
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+
+namespace {
+
+int findRoot(std::vector<int>& parent, int i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+// Read-only variant for concurrent resolution
+int findRootConst(const std::vector<int>& parent, int i) {
+    while (parent[i] != i) i = parent[i];
+    return i;
+}
+
+// The smaller index becomes the root, so a root is its component's first pixel
+void unite(std::vector<int>& parent, int a, int b) {
+    a = findRoot(parent, a);
+    b = findRoot(parent, b);
+    if (a < b) parent[b] = a;
+    else if (b < a) parent[a] = b;
+}
+
+struct Moments {
+    double n, x, y, z, xx, xy, xz, yy, yz, zz;
+    int minX, minY, maxX, maxY;
+
+    void reset() {
+        n = x = y = z = xx = xy = xz = yy = yz = zz = 0.0;
+        minX = minY = INT_MAX;
+        maxX = maxY = INT_MIN;
+    }
+    void add(const Moments& o) {
+        n += o.n; x += o.x; y += o.y; z += o.z;
+        xx += o.xx; xy += o.xy; xz += o.xz; yy += o.yy; yz += o.yz; zz += o.zz;
+        minX = std::min(minX, o.minX); minY = std::min(minY, o.minY);
+        maxX = std::max(maxX, o.maxX); maxY = std::max(maxY, o.maxY);
+    }
+};
+
+struct MomentRun {
+    int id;
+    Moments m;
+};
+
+struct ExtentRun {
+    int segment;
+    float lo[3], hi[3];
+};
+
+// Cyclic Jacobi; eigenvalues descending, eigenvectors as rows
+void symmetricEigen3(double a[3][3], double values[3], double vectors[3][3]) {
+    double v[3][3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+    for (int sweep = 0; sweep < 32; sweep++) {
+        const double off = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+        const double diag = a[0][0] * a[0][0] + a[1][1] * a[1][1] + a[2][2] * a[2][2];
+        if (off <= 1e-24 * diag || off == 0.0) break;
+        for (int p = 0; p < 2; p++) {
+            for (int q = p + 1; q < 3; q++) {
+                if (a[p][q] == 0.0) continue;
+                const double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+                const double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+                const double c = 1.0 / std::sqrt(t * t + 1.0), s = t * c;
+                for (int k = 0; k < 3; k++) {
+                    const double akp = a[k][p], akq = a[k][q];
+                    a[k][p] = c * akp - s * akq;
+                    a[k][q] = s * akp + c * akq;
+                }
+                for (int k = 0; k < 3; k++) {
+                    const double apk = a[p][k], aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+                }
+                for (int k = 0; k < 3; k++) {
+                    const double vkp = v[k][p], vkq = v[k][q];
+                    v[k][p] = c * vkp - s * vkq;
+                    v[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+    int order[3] = {0, 1, 2};
+    std::sort(order, order + 3, [&](int i, int j) { return a[i][i] > a[j][j]; });
+    for (int r = 0; r < 3; r++) {
+        values[r] = a[order[r]][order[r]];
+        for (int k = 0; k < 3; k++) vectors[r][k] = v[k][order[r]];
+    }
+    // Right-handed
+    vectors[2][0] = vectors[0][1] * vectors[1][2] - vectors[0][2] * vectors[1][1];
+    vectors[2][1] = vectors[0][2] * vectors[1][0] - vectors[0][0] * vectors[1][2];
+    vectors[2][2] = vectors[0][0] * vectors[1][1] - vectors[0][1] * vectors[1][0];
+}
+
+}  // namespace
+
+void segmentOrganizedCloud(const cv::Mat& cloud, const NormalMap* normals, cv::Mat& labels,
+                           std::vector<Segment>& segments, const SegmentationParams& params) {
+    CV_Assert(cloud.type() == CV_32FC3);
+    CV_Assert(!normals || (normals->nx.size() == cloud.size() && normals->ny.size() == cloud.size() &&
+                           normals->nz.size() == cloud.size()));
+    const cv::Rect frame(0, 0, cloud.cols, cloud.rows);
+    const cv::Rect area = params.roi.area() > 0 ? params.roi & frame : frame;
+    const int width = area.width, height = area.height;
+    const int bandRows = std::max(1, params.bandRows);
+    const int bands = (height + bandRows - 1) / bandRows;
+    const float scale = params.maxDepthStepAt1000mm * 1e-3f;
+    const float minCos = static_cast<float>(std::cos(params.maxNormalAngleDeg * CV_PI / 180.0));
+
+    labels.create(cloud.size(), CV_32SC1);
+    labels.setTo(cv::Scalar(0));
+    segments.clear();
+    if (area.area() <= 0) return;
+
+    // Neighbors at area-relative (xa, ya) and (xb, yb)
+    auto joined = [&](int xa, int ya, int xb, int yb) {
+        const float za = cloud.ptr<float>(area.y + ya)[3 * (area.x + xa) + 2];
+        const float zb = cloud.ptr<float>(area.y + yb)[3 * (area.x + xb) + 2];
+        if (std::abs(za - zb) > scale * std::max(za, zb) + params.absoluteDepthStep) return false;
+        if (!normals) return true;
+        xa += area.x; ya += area.y; xb += area.x; yb += area.y;
+        const float na[3] = {normals->nx.ptr<float>(ya)[xa], normals->ny.ptr<float>(ya)[xa], normals->nz.ptr<float>(ya)[xa]};
+        const float nb[3] = {normals->nx.ptr<float>(yb)[xb], normals->ny.ptr<float>(yb)[xb], normals->nz.ptr<float>(yb)[xb]};
+        if ((na[0] == 0.0f && na[1] == 0.0f && na[2] == 0.0f) || (nb[0] == 0.0f && nb[1] == 0.0f && nb[2] == 0.0f)) return false;
+        return na[0] * nb[0] + na[1] * nb[1] + na[2] * nb[2] >= minCos;
+    };
+
+    // 1. Union-find within each band
+    std::vector<int> parent(static_cast<size_t>(width) * height);
+    cv::parallel_for_(cv::Range(0, bands), [&](const cv::Range& range) {
+        for (int band = range.start; band < range.end; band++) {
+            const int y0 = band * bandRows, y1 = std::min(height, y0 + bandRows);
+            for (int y = y0; y < y1; y++) {
+                const float* p = cloud.ptr<float>(area.y + y) + 3 * area.x;
+                const float* up = y > y0 ? cloud.ptr<float>(area.y + y - 1) + 3 * area.x : nullptr;
+                int* row = &parent[static_cast<size_t>(y) * width];
+                for (int x = 0; x < width; x++) {
+                    const float z = p[3 * x + 2];
+                    const int i = y * width + x;
+                    if (!(z > 0.0f)) {
+                        row[x] = -1;
+                        continue;
+                    }
+                    row[x] = i;
+                    // Depth test inline; the full test only for candidates
+                    if (x > 0 && row[x - 1] >= 0 &&
+                        std::abs(z - p[3 * x - 1]) <= scale * std::max(z, p[3 * x - 1]) + params.absoluteDepthStep &&
+                        (!normals || joined(x, y, x - 1, y))) {
+                        unite(parent, i, i - 1);
+                    }
+                    if (up && row[x - width] >= 0 &&
+                        std::abs(z - up[3 * x + 2]) <= scale * std::max(z, up[3 * x + 2]) + params.absoluteDepthStep &&
+                        (!normals || joined(x, y, x, y - 1))) {
+                        unite(parent, i, i - width);
+                    }
+                }
+            }
+        }
+    });
+
+    // 2. Band borders
+    for (int band = 1; band < bands; band++) {
+        const int y = band * bandRows;
+        for (int x = 0; x < width; x++) {
+            const int i = y * width + x;
+            if (parent[i] >= 0 && parent[i - width] >= 0 && joined(x, y, x, y - 1)) unite(parent, i, i - width);
+        }
+    }
+
+    // 3. Roots, numbered in pixel order
+    cv::Mat roots(height, width, CV_32SC1);
+    std::vector<int> rootCount(bands + 1, 0);
+    cv::parallel_for_(cv::Range(0, bands), [&](const cv::Range& range) {
+        for (int band = range.start; band < range.end; band++) {
+            const int y0 = band * bandRows, y1 = std::min(height, y0 + bandRows);
+            int n = 0;
+            for (int y = y0; y < y1; y++) {
+                int* r = roots.ptr<int>(y);
+                for (int x = 0; x < width; x++) {
+                    const int i = y * width + x;
+                    r[x] = parent[i] < 0 ? -1 : findRootConst(parent, i);
+                    n += r[x] == i;
+                }
+            }
+            rootCount[band + 1] = n;
+        }
+    });
+    for (int band = 0; band < bands; band++) rootCount[band + 1] += rootCount[band];
+    const int components = rootCount[bands];
+
+    // parent is free now: it maps a root pixel to its component number
+    cv::parallel_for_(cv::Range(0, bands), [&](const cv::Range& range) {
+        for (int band = range.start; band < range.end; band++) {
+            const int y0 = band * bandRows, y1 = std::min(height, y0 + bandRows);
+            int next = rootCount[band];
+            for (int y = y0; y < y1; y++) {
+                const int* r = roots.ptr<int>(y);
+                for (int x = 0; x < width; x++) {
+                    if (r[x] == y * width + x) parent[r[x]] = next++;
+                }
+            }
+        }
+    });
+
+    // 4. Component numbers and moments, summed over runs of one component
+    std::vector<std::vector<MomentRun>> bandRuns(bands);
+    cv::parallel_for_(cv::Range(0, bands), [&](const cv::Range& range) {
+        for (int band = range.start; band < range.end; band++) {
+            const int y0 = band * bandRows, y1 = std::min(height, y0 + bandRows);
+            std::vector<MomentRun>& runs = bandRuns[band];
+            runs.clear();
+            for (int y = y0; y < y1; y++) {
+                int* r = roots.ptr<int>(y);
+                const float* p = cloud.ptr<float>(area.y + y) + 3 * area.x;
+                MomentRun run;
+                run.id = -1;
+                for (int x = 0; x <= width; x++) {
+                    const int id = x < width && r[x] >= 0 ? parent[r[x]] : -1;
+                    if (x < width) r[x] = id;
+                    if (id != run.id) {
+                        if (run.id >= 0) runs.push_back(run);
+                        run.id = id;
+                        run.m.reset();
+                    }
+                    if (id < 0) continue;
+                    const double px = p[3 * x], py = p[3 * x + 1], pz = p[3 * x + 2];
+                    Moments& m = run.m;
+                    m.n += 1.0; m.x += px; m.y += py; m.z += pz;
+                    m.xx += px * px; m.xy += px * py; m.xz += px * pz;
+                    m.yy += py * py; m.yz += py * pz; m.zz += pz * pz;
+                    m.minX = std::min(m.minX, x); m.maxX = std::max(m.maxX, x);
+                    m.minY = std::min(m.minY, y); m.maxY = std::max(m.maxY, y);
+                }
+            }
+        }
+    });
+
+    std::vector<Moments> moments(components);
+    for (Moments& m : moments) m.reset();
+    for (const std::vector<MomentRun>& runs : bandRuns) {
+        for (const MomentRun& run : runs) moments[run.id].add(run.m);
+    }
+
+    // Segments by size, ties in pixel order
+    std::vector<int> kept;
+    for (int c = 0; c < components; c++) {
+        if (moments[c].n >= params.minPoints) kept.push_back(c);
+    }
+    std::stable_sort(kept.begin(), kept.end(), [&](int a, int b) { return moments[a].n > moments[b].n; });
+    std::vector<int> segmentOf(components, -1);
+    segments.resize(kept.size());
+    for (size_t s = 0; s < kept.size(); s++) {
+        const Moments& m = moments[kept[s]];
+        segmentOf[kept[s]] = static_cast<int>(s);
+        Segment& seg = segments[s];
+        seg.label = static_cast<int>(s) + 1;
+        seg.points = static_cast<int>(m.n);
+        seg.bbox = cv::Rect(area.x + m.minX, area.y + m.minY, m.maxX - m.minX + 1, m.maxY - m.minY + 1);
+        const double inv = 1.0 / m.n;
+        const double cx = m.x * inv, cy = m.y * inv, cz = m.z * inv;
+        double cov[3][3] = {
+            {m.xx * inv - cx * cx, m.xy * inv - cx * cy, m.xz * inv - cx * cz},
+            {m.xy * inv - cx * cy, m.yy * inv - cy * cy, m.yz * inv - cy * cz},
+            {m.xz * inv - cx * cz, m.yz * inv - cy * cz, m.zz * inv - cz * cz}};
+        double values[3], vectors[3][3];
+        symmetricEigen3(cov, values, vectors);
+        seg.centroid = cv::Vec3f(static_cast<float>(cx), static_cast<float>(cy), static_cast<float>(cz));
+        for (int r = 0; r < 3; r++) {
+            seg.variances[r] = static_cast<float>(std::max(0.0, values[r]));
+            for (int k = 0; k < 3; k++) seg.axes(r, k) = static_cast<float>(vectors[r][k]);
+        }
+    }
+
+    // 5. Final labels and extents along the axes, again per run
+    std::vector<std::vector<ExtentRun>> bandExtents(bands);
+    cv::parallel_for_(cv::Range(0, bands), [&](const cv::Range& range) {
+        for (int band = range.start; band < range.end; band++) {
+            const int y0 = band * bandRows, y1 = std::min(height, y0 + bandRows);
+            std::vector<ExtentRun>& runs = bandExtents[band];
+            runs.clear();
+            for (int y = y0; y < y1; y++) {
+                const int* r = roots.ptr<int>(y);
+                int* out = labels.ptr<int>(area.y + y) + area.x;
+                const float* p = cloud.ptr<float>(area.y + y) + 3 * area.x;
+                ExtentRun run;
+                run.segment = -1;
+                for (int x = 0; x <= width; x++) {
+                    const int s = x < width && r[x] >= 0 ? segmentOf[r[x]] : -1;
+                    if (x < width) out[x] = s + 1;
+                    if (s != run.segment) {
+                        if (run.segment >= 0) runs.push_back(run);
+                        run.segment = s;
+                        std::fill(run.lo, run.lo + 3, FLT_MAX);
+                        std::fill(run.hi, run.hi + 3, -FLT_MAX);
+                    }
+                    if (s < 0) continue;
+                    const Segment& seg = segments[s];
+                    const float dx = p[3 * x] - seg.centroid[0], dy = p[3 * x + 1] - seg.centroid[1];
+                    const float dz = p[3 * x + 2] - seg.centroid[2];
+                    for (int k = 0; k < 3; k++) {
+                        const float d = seg.axes(k, 0) * dx + seg.axes(k, 1) * dy + seg.axes(k, 2) * dz;
+                        run.lo[k] = std::min(run.lo[k], d);
+                        run.hi[k] = std::max(run.hi[k], d);
+                    }
+                }
+            }
+        }
+    });
+
+    std::vector<cv::Vec3f> lo(segments.size(), cv::Vec3f::all(FLT_MAX)), hi(segments.size(), cv::Vec3f::all(-FLT_MAX));
+    for (const std::vector<ExtentRun>& runs : bandExtents) {
+        for (const ExtentRun& run : runs) {
+            for (int k = 0; k < 3; k++) {
+                lo[run.segment][k] = std::min(lo[run.segment][k], run.lo[k]);
+                hi[run.segment][k] = std::max(hi[run.segment][k], run.hi[k]);
+            }
+        }
+    }
+    for (size_t s = 0; s < segments.size(); s++) {
+        Segment& seg = segments[s];
+        const cv::Vec3f mid = (lo[s] + hi[s]) * 0.5f;
+        seg.obbHalfSize = (hi[s] - lo[s]) * 0.5f;
+        seg.obbCenter = seg.centroid + seg.axes.t() * mid;
+    }
+}
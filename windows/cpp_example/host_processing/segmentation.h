@@ -0,0 +1,54 @@
+#pragma once
+#include <vector>
+#include <opencv2/core.hpp>
+#include "normals.h"
+
+// ═══════════════════════════════════════════════════════════════════════
+// Connected-Component Segmentation
+// ═══════════════════════════════════════════════════════════════════════
+//
+// Splits an organized cloud into object candidates by connectivity on
+// the pixel grid instead of a kd-tree Euclidean clustering. Two
+// 4-neighbors belong together when both are valid, their depths differ by
+// at most
+//
+//     maxDepthStepAt1000mm * z / 1000 + absoluteDepthStep
+//
+// and, with normals given, the normals differ by at most maxNormalAngleDeg
+// (pixels without a normal join nothing). The normal test separates
+// touching parts whose surfaces meet at an angle, as in a bin.
+//
+//   1. Row bands are labeled in parallel with union-find (union by the
+//      smaller pixel index, path halving).
+//   2. Band borders are merged; roots are resolved in parallel.
+//   3. Per-segment moments and extents are summed over runs of equal
+//      labels per band, then reduced in band order.
+//
+// The result is identical for any thread count.
+
+struct SegmentationParams {
+    cv::Rect roi;                       // segmented region; empty = whole frame
+    float maxDepthStepAt1000mm = 2.0f;  // mm of depth step between neighbors at z = 1000 mm
+    float absoluteDepthStep = 0.0f;     // mm added to the scaled step
+    float maxNormalAngleDeg = 20.0f;    // neighbor normal difference (with normals only)
+    int minPoints = 200;                // smaller components are not reported (label 0)
+    int bandRows = 32;                  // rows per parallel band
+};
+
+struct Segment {
+    int label;                  // value in the label map
+    int points;
+    cv::Rect bbox;              // pixel bounding box
+    cv::Vec3f centroid;         // mm
+    cv::Matx33f axes;           // rows: principal axes, largest variance first, right-handed
+    cv::Vec3f variances;        // along the axes (mm^2)
+    cv::Vec3f obbCenter;        // center of the oriented bounding box along `axes`
+    cv::Vec3f obbHalfSize;      // half extents along `axes` (mm)
+};
+
+// cloud: CV_32FC3 (z <= 0 invalid). normals (optional): estimateNormals
+// output of the same size. labels: CV_32SC1, 0 = background / small,
+// 1..N = segments ordered by size (largest first).
+void segmentOrganizedCloud(const cv::Mat& cloud, const NormalMap* normals, cv::Mat& labels,
+                           std::vector<Segment>& segments,
+                           const SegmentationParams& params = SegmentationParams());
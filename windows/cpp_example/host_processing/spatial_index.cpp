@@ -0,0 +1,489 @@
+#include "spatial_index.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <opencv2/core/hal/intrin.hpp>
+
+namespace {
+
+const int kStripes = 64;
+const int kBucketBits = 12;             // top Morton bits of the counting sort
+const int kBuckets = 1 << kBucketBits;
+const int kBucketShift = 63 - kBucketBits;
+const int kSubBucketBits = 8;           // second counting pass inside a bucket
+const int kSubBuckets = 1 << kSubBucketBits;
+const int kSubBucketShift = kBucketShift - kSubBucketBits;
+const int kSmallBucket = 64;            // sorted directly
+const int kQueryBlock = 256;            // queries per parallel task
+const int kStackSize = 128;
+
+cv::Vec6f emptyBox() {
+    return cv::Vec6f(FLT_MAX, FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX);
+}
+
+void expandBox(cv::Vec6f& box, float x, float y, float z) {
+    box[0] = std::min(box[0], x);
+    box[1] = std::min(box[1], y);
+    box[2] = std::min(box[2], z);
+    box[3] = std::max(box[3], x);
+    box[4] = std::max(box[4], y);
+    box[5] = std::max(box[5], z);
+}
+
+cv::Vec6f unionBox(const cv::Vec6f& a, const cv::Vec6f& b) {
+    return cv::Vec6f(std::min(a[0], b[0]), std::min(a[1], b[1]), std::min(a[2], b[2]),
+                     std::max(a[3], b[3]), std::max(a[4], b[4]), std::max(a[5], b[5]));
+}
+
+bool validPoint(const cv::Vec3f& p, bool skipZeroDepth) {
+    return std::isfinite(p[0]) && std::isfinite(p[1]) && std::isfinite(p[2]) && (!skipZeroDepth || p[2] > 0.0f);
+}
+
+// Spreads the low 21 bits of v to every third bit
+uint64_t spreadBits(uint64_t v) {
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffffULL;
+    v = (v | v << 16) & 0x1f0000ff0000ffULL;
+    v = (v | v << 8) & 0x100f00f00f00f00fULL;
+    v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+    v = (v | v << 2) & 0x1249249249249249ULL;
+    return v;
+}
+
+// Squared distance from q to the box; empty boxes are infinitely far
+float boxDistance(const cv::Vec6f& b, const cv::Vec3f& q) {
+    const float dx = std::max(std::max(b[0] - q[0], q[0] - b[3]), 0.0f);
+    const float dy = std::max(std::max(b[1] - q[1], q[1] - b[4]), 0.0f);
+    const float dz = std::max(std::max(b[2] - q[2], q[2] - b[5]), 0.0f);
+    return dx * dx + dy * dy + dz * dz;
+}
+
+// Squared distance from q to the farthest box corner
+float boxFarDistance(const cv::Vec6f& b, const cv::Vec3f& q) {
+    const float dx = std::max(std::fabs(q[0] - b[0]), std::fabs(q[0] - b[3]));
+    const float dy = std::max(std::fabs(q[1] - b[1]), std::fabs(q[1] - b[4]));
+    const float dz = std::max(std::fabs(q[2] - b[2]), std::fabs(q[2] - b[5]));
+    return dx * dx + dy * dy + dz * dz;
+}
+
+// Point range (Morton positions) of a node
+cv::Range nodePoints(const SpatialIndex& index, int node) {
+    int first = node, last = node;
+    while (first < index.leafBase) {
+        first = 2 * first;
+        last = 2 * last + 1;
+    }
+    const int n = static_cast<int>(index.x.size());
+    return cv::Range(std::min((first - index.leafBase) * index.leafSize, n),
+                     std::min((last - index.leafBase + 1) * index.leafSize, n));
+}
+
+// k best so far, sorted by distance
+struct KnnList {
+    int k, count;
+    int* position;
+    float* distance;
+
+    float worst() const { return count < k ? FLT_MAX : distance[k - 1]; }
+
+    void insert(float d, int p) {
+        int i = k - 1;
+        if (count < k) i = count++;
+        else if (d >= distance[i]) return;
+        while (i > 0 && distance[i - 1] > d) {
+            distance[i] = distance[i - 1];
+            position[i] = position[i - 1];
+            i--;
+        }
+        distance[i] = d;
+        position[i] = p;
+    }
+};
+
+struct StackEntry {
+    int node;
+    float distance;
+};
+
+void knnQuery(const SpatialIndex& index, const cv::Vec3f& q, KnnList& list) {
+    StackEntry stack[kStackSize];
+    int top = 0;
+    stack[top++] = {1, boxDistance(index.boxes[1], q)};
+    const float* px = index.x.data();
+    const float* py = index.y.data();
+    const float* pz = index.z.data();
+
+    while (top > 0) {
+        const StackEntry e = stack[--top];
+        if (e.distance >= list.worst()) continue;
+
+        if (e.node >= index.leafBase) {
+            const cv::Range r = nodePoints(index, e.node);
+            int i = r.start;
+#if CV_SIMD128
+            const cv::v_float32x4 qx = cv::v_setall_f32(q[0]), qy = cv::v_setall_f32(q[1]),
+                                  qz = cv::v_setall_f32(q[2]);
+            for (; i <= r.end - 4; i += 4) {
+                const cv::v_float32x4 dx = cv::v_load(px + i) - qx, dy = cv::v_load(py + i) - qy,
+                                      dz = cv::v_load(pz + i) - qz;
+                const cv::v_float32x4 d = dx * dx + dy * dy + dz * dz;
+                if (cv::v_reduce_min(d) >= list.worst()) continue;
+                float lanes[4];
+                cv::v_store(lanes, d);
+                for (int j = 0; j < 4; j++) {
+                    if (lanes[j] < list.worst()) list.insert(lanes[j], i + j);
+                }
+            }
+#endif
+            for (; i < r.end; i++) {
+                const float dx = px[i] - q[0], dy = py[i] - q[1], dz = pz[i] - q[2];
+                const float d = dx * dx + dy * dy + dz * dz;
+                if (d < list.worst()) list.insert(d, i);
+            }
+            continue;
+        }
+
+        // Nearer child on top of the stack
+        const int a = 2 * e.node, b = a + 1;
+        const float da = boxDistance(index.boxes[a], q), db = boxDistance(index.boxes[b], q);
+        const float worst = list.worst();
+        const StackEntry near = da <= db ? StackEntry{a, da} : StackEntry{b, db};
+        const StackEntry far = da <= db ? StackEntry{b, db} : StackEntry{a, da};
+        if (far.distance < worst) stack[top++] = far;
+        if (near.distance < worst) stack[top++] = near;
+    }
+}
+
+void appendRange(const SpatialIndex& index, const cv::Range& r, std::vector<int>& out) {
+    out.insert(out.end(), index.source.begin() + r.start, index.source.begin() + r.end);
+}
+
+void radiusQuery(const SpatialIndex& index, const cv::Vec3f& q, float radius, std::vector<int>& out) {
+    const float r2 = radius * radius;
+    StackEntry stack[kStackSize];
+    int top = 0;
+    stack[top++] = {1, 0.0f};
+    const float* px = index.x.data();
+    const float* py = index.y.data();
+    const float* pz = index.z.data();
+
+    while (top > 0) {
+        const int node = stack[--top].node;
+        const cv::Vec6f& box = index.boxes[node];
+        if (boxDistance(box, q) > r2) continue;
+        if (boxFarDistance(box, q) <= r2) {
+            appendRange(index, nodePoints(index, node), out);
+            continue;
+        }
+        if (node < index.leafBase) {
+            stack[top++] = {2 * node + 1, 0.0f};
+            stack[top++] = {2 * node, 0.0f};
+            continue;
+        }
+
+        const cv::Range r = nodePoints(index, node);
+        int i = r.start;
+#if CV_SIMD128
+        const cv::v_float32x4 qx = cv::v_setall_f32(q[0]), qy = cv::v_setall_f32(q[1]), qz = cv::v_setall_f32(q[2]),
+                              vr2 = cv::v_setall_f32(r2);
+        for (; i <= r.end - 4; i += 4) {
+            const cv::v_float32x4 dx = cv::v_load(px + i) - qx, dy = cv::v_load(py + i) - qy,
+                                  dz = cv::v_load(pz + i) - qz;
+            const int mask = cv::v_signmask(dx * dx + dy * dy + dz * dz <= vr2);
+            for (int j = 0; j < 4; j++) {
+                if (mask & (1 << j)) out.push_back(index.source[i + j]);
+            }
+        }
+#endif
+        for (; i < r.end; i++) {
+            const float dx = px[i] - q[0], dy = py[i] - q[1], dz = pz[i] - q[2];
+            if (dx * dx + dy * dy + dz * dz <= r2) out.push_back(index.source[i]);
+        }
+    }
+}
+
+cv::Vec3f queryPoint(const cv::Mat& queries, int i) {
+    return queries.ptr<cv::Vec3f>(i / queries.cols)[i % queries.cols];
+}
+
+bool finitePoint(const cv::Vec3f& p) {
+    return std::isfinite(p[0]) && std::isfinite(p[1]) && std::isfinite(p[2]);
+}
+
+} // namespace
+
+void buildSpatialIndex(const cv::Mat& cloud, SpatialIndex& index, const SpatialIndexParams& params) {
+    SpatialIndexBuildBuffers buffers;
+    buildSpatialIndex(cloud, index, buffers, params);
+}
+
+void buildSpatialIndex(const cv::Mat& cloud, SpatialIndex& index, SpatialIndexBuildBuffers& buffers,
+                       const SpatialIndexParams& params) {
+    CV_Assert(cloud.type() == CV_32FC3);
+    const int rows = cloud.rows, cols = cloud.cols;
+    const int stripes = std::max(1, std::min(kStripes, rows));
+    index.leafSize = std::max(1, params.leafSize);
+
+    // ── 1. Valid points and bounds per stripe ──
+    std::vector<int> stripeStart(stripes + 1, 0);
+    std::vector<cv::Vec6f> stripeBox(stripes, emptyBox());
+    cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range& range) {
+        for (int s = range.start; s < range.end; s++) {
+            int count = 0;
+            cv::Vec6f box = emptyBox();
+            for (int y = rows * s / stripes; y < rows * (s + 1) / stripes; y++) {
+                const cv::Vec3f* p = cloud.ptr<cv::Vec3f>(y);
+                for (int x = 0; x < cols; x++) {
+                    if (!validPoint(p[x], params.skipZeroDepth)) continue;
+                    count++;
+                    expandBox(box, p[x][0], p[x][1], p[x][2]);
+                }
+            }
+            stripeStart[s + 1] = count;
+            stripeBox[s] = box;
+        }
+    });
+    cv::Vec6f bounds = emptyBox();
+    for (int s = 0; s < stripes; s++) {
+        stripeStart[s + 1] += stripeStart[s];
+        bounds = unionBox(bounds, stripeBox[s]);
+    }
+    const int n = stripeStart[stripes];
+
+    index.x.resize(n);
+    index.y.resize(n);
+    index.z.resize(n);
+    index.source.resize(n);
+    if (n == 0) {
+        index.leafBase = 1;
+        index.boxes.assign(2, emptyBox());
+        return;
+    }
+
+    // ── 2. Morton codes, counting sort by the top bits, bucket sorts ──
+    const float extent = std::max(std::max(bounds[3] - bounds[0], bounds[4] - bounds[1]), bounds[5] - bounds[2]);
+    const float scale = extent > 0.0f ? static_cast<float>((1 << 21) - 1) / extent : 0.0f;
+    const float lo[3] = {bounds[0], bounds[1], bounds[2]};
+
+    std::vector<std::pair<uint64_t, int>>& entries = buffers.entries;
+    std::vector<std::pair<uint64_t, int>>& sorted = buffers.sorted;
+    entries.resize(n);
+    sorted.resize(n);
+    std::vector<int> histogram(static_cast<size_t>(stripes) * kBuckets, 0);
+
+    cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range& range) {
+        for (int s = range.start; s < range.end; s++) {
+            int c = stripeStart[s];
+            int* hist = &histogram[static_cast<size_t>(s) * kBuckets];
+            for (int y = rows * s / stripes; y < rows * (s + 1) / stripes; y++) {
+                const cv::Vec3f* p = cloud.ptr<cv::Vec3f>(y);
+                for (int x = 0; x < cols; x++) {
+                    if (!validPoint(p[x], params.skipZeroDepth)) continue;
+                    uint64_t code = 0;
+                    for (int k = 0; k < 3; k++) {
+                        const int v = std::min(std::max(static_cast<int>((p[x][k] - lo[k]) * scale), 0), (1 << 21) - 1);
+                        code |= spreadBits(static_cast<uint64_t>(v)) << k;
+                    }
+                    entries[c++] = std::make_pair(code, y * cols + x);
+                    hist[code >> kBucketShift]++;
+                }
+            }
+        }
+    });
+
+    // Bucket-major offsets; within a bucket, stripes in order
+    std::vector<int> bucketStart(kBuckets + 1, 0);
+    int running = 0;
+    for (int b = 0; b < kBuckets; b++) {
+        bucketStart[b] = running;
+        for (int s = 0; s < stripes; s++) {
+            const int count = histogram[static_cast<size_t>(s) * kBuckets + b];
+            histogram[static_cast<size_t>(s) * kBuckets + b] = running;
+            running += count;
+        }
+    }
+    bucketStart[kBuckets] = running;
+
+    cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range& range) {
+        for (int s = range.start; s < range.end; s++) {
+            int* offset = &histogram[static_cast<size_t>(s) * kBuckets];
+            for (int c = stripeStart[s]; c < stripeStart[s + 1]; c++) {
+                sorted[offset[entries[c].first >> kBucketShift]++] = entries[c];
+            }
+        }
+    });
+
+    // Flat scenes use few top-level buckets, so each bucket is counting-
+    // sorted once more (back into entries) before the final sorts.
+    cv::parallel_for_(cv::Range(0, kBuckets), [&](const cv::Range& range) {
+        int offset[kSubBuckets];
+        for (int b = range.start; b < range.end; b++) {
+            const int begin = bucketStart[b], end = bucketStart[b + 1];
+            if (end - begin <= kSmallBucket) {
+                std::copy(sorted.begin() + begin, sorted.begin() + end, entries.begin() + begin);
+                std::sort(entries.begin() + begin, entries.begin() + end);
+                continue;
+            }
+            std::fill(offset, offset + kSubBuckets, 0);
+            for (int i = begin; i < end; i++) offset[(sorted[i].first >> kSubBucketShift) & (kSubBuckets - 1)]++;
+            int start = begin;
+            for (int k = 0; k < kSubBuckets; k++) {
+                const int count = offset[k];
+                offset[k] = start;
+                start += count;
+            }
+            for (int i = begin; i < end; i++) {
+                entries[offset[(sorted[i].first >> kSubBucketShift) & (kSubBuckets - 1)]++] = sorted[i];
+            }
+            // offset[k] is now the end of sub-bucket k
+            start = begin;
+            for (int k = 0; k < kSubBuckets; k++) {
+                std::sort(entries.begin() + start, entries.begin() + offset[k]);
+                start = offset[k];
+            }
+        }
+    });
+
+    // ── 3. Gather in Morton order, leaf boxes, tree levels ──
+    cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range& range) {
+        for (int s = range.start; s < range.end; s++) {
+            for (int i = stripeStart[s]; i < stripeStart[s + 1]; i++) {
+                const int e = entries[i].second;
+                const cv::Vec3f& p = cloud.ptr<cv::Vec3f>(e / cols)[e % cols];
+                index.x[i] = p[0];
+                index.y[i] = p[1];
+                index.z[i] = p[2];
+                index.source[i] = e;
+            }
+        }
+    });
+
+    const int leaves = (n + index.leafSize - 1) / index.leafSize;
+    int leafBase = 1;
+    while (leafBase < leaves) leafBase <<= 1;
+    index.leafBase = leafBase;
+    index.boxes.assign(2 * static_cast<size_t>(leafBase), emptyBox());
+
+    cv::parallel_for_(cv::Range(0, leaves), [&](const cv::Range& range) {
+        for (int l = range.start; l < range.end; l++) {
+            cv::Vec6f box = emptyBox();
+            for (int i = l * index.leafSize; i < std::min((l + 1) * index.leafSize, n); i++) {
+                expandBox(box, index.x[i], index.y[i], index.z[i]);
+            }
+            index.boxes[leafBase + l] = box;
+        }
+    });
+    for (int level = leafBase / 2; level >= 1; level /= 2) {
+        cv::parallel_for_(cv::Range(level, 2 * level), [&](const cv::Range& range) {
+            for (int i = range.start; i < range.end; i++) {
+                index.boxes[i] = unionBox(index.boxes[2 * i], index.boxes[2 * i + 1]);
+            }
+        });
+    }
+}
+
+int nearestNeighbors(const SpatialIndex& index, const cv::Vec3f& query, int k, int* indices,
+                     float* sqDistances) {
+    if (k <= 0) return 0;
+    KnnList list = {k, 0, indices, sqDistances};
+    if (!index.x.empty() && finitePoint(query)) knnQuery(index, query, list);
+    for (int i = 0; i < list.count; i++) indices[i] = index.source[indices[i]];
+    for (int i = list.count; i < k; i++) {
+        indices[i] = -1;
+        sqDistances[i] = FLT_MAX;
+    }
+    return list.count;
+}
+
+void radiusSearch(const SpatialIndex& index, const cv::Vec3f& query, float radius, std::vector<int>& indices) {
+    indices.clear();
+    if (!index.x.empty() && finitePoint(query) && radius >= 0.0f) radiusQuery(index, query, radius, indices);
+}
+
+void boxSearch(const SpatialIndex& index, const cv::Vec3f& lo, const cv::Vec3f& hi, std::vector<int>& indices) {
+    indices.clear();
+    if (index.x.empty()) return;
+    StackEntry stack[kStackSize];
+    int top = 0;
+    stack[top++] = {1, 0.0f};
+
+    while (top > 0) {
+        const int node = stack[--top].node;
+        const cv::Vec6f& b = index.boxes[node];
+        if (b[0] > hi[0] || b[1] > hi[1] || b[2] > hi[2] || b[3] < lo[0] || b[4] < lo[1] || b[5] < lo[2]) continue;
+        if (b[0] >= lo[0] && b[1] >= lo[1] && b[2] >= lo[2] && b[3] <= hi[0] && b[4] <= hi[1] && b[5] <= hi[2]) {
+            appendRange(index, nodePoints(index, node), indices);
+            continue;
+        }
+        if (node < index.leafBase) {
+            stack[top++] = {2 * node + 1, 0.0f};
+            stack[top++] = {2 * node, 0.0f};
+            continue;
+        }
+
+        const cv::Range r = nodePoints(index, node);
+        int i = r.start;
+#if CV_SIMD128
+        const cv::v_float32x4 lx = cv::v_setall_f32(lo[0]), ly = cv::v_setall_f32(lo[1]), lz = cv::v_setall_f32(lo[2]);
+        const cv::v_float32x4 hx = cv::v_setall_f32(hi[0]), hy = cv::v_setall_f32(hi[1]), hz = cv::v_setall_f32(hi[2]);
+        for (; i <= r.end - 4; i += 4) {
+            const cv::v_float32x4 x = cv::v_load(&index.x[i]), y = cv::v_load(&index.y[i]), z = cv::v_load(&index.z[i]);
+            const int mask = cv::v_signmask((x >= lx) & (x <= hx) & (y >= ly) & (y <= hy) & (z >= lz) & (z <= hz));
+            for (int j = 0; j < 4; j++) {
+                if (mask & (1 << j)) indices.push_back(index.source[i + j]);
+            }
+        }
+#endif
+        for (; i < r.end; i++) {
+            if (index.x[i] >= lo[0] && index.x[i] <= hi[0] && index.y[i] >= lo[1] && index.y[i] <= hi[1] &&
+                index.z[i] >= lo[2] && index.z[i] <= hi[2]) {
+                indices.push_back(index.source[i]);
+            }
+        }
+    }
+}
+
+void nearestNeighborsBatch(const SpatialIndex& index, const cv::Mat& queries, int k, cv::Mat& indices,
+                           cv::Mat& sqDistances) {
+    CV_Assert(queries.type() == CV_32FC3 && k > 0);
+    const int count = static_cast<int>(queries.total());
+    indices.create(count, k, CV_32SC1);
+    sqDistances.create(count, k, CV_32FC1);
+    const int blocks = (count + kQueryBlock - 1) / kQueryBlock;
+    cv::parallel_for_(cv::Range(0, blocks), [&](const cv::Range& range) {
+        for (int b = range.start; b < range.end; b++) {
+            for (int i = b * kQueryBlock; i < std::min((b + 1) * kQueryBlock, count); i++) {
+                nearestNeighbors(index, queryPoint(queries, i), k, indices.ptr<int>(i), sqDistances.ptr<float>(i));
+            }
+        }
+    });
+}
+
+void radiusSearchBatch(const SpatialIndex& index, const cv::Mat& queries, float radius, NeighborLists& lists) {
+    CV_Assert(queries.type() == CV_32FC3);
+    const int count = static_cast<int>(queries.total());
+    const int blocks = (count + kQueryBlock - 1) / kQueryBlock;
+    lists.offsets.assign(count + 1, 0);
+    std::vector<std::vector<int>> blockIndices(blocks);
+
+    cv::parallel_for_(cv::Range(0, blocks), [&](const cv::Range& range) {
+        std::vector<int> found;
+        for (int b = range.start; b < range.end; b++) {
+            std::vector<int>& out = blockIndices[b];
+            out.clear();
+            for (int i = b * kQueryBlock; i < std::min((b + 1) * kQueryBlock, count); i++) {
+                radiusSearch(index, queryPoint(queries, i), radius, found);
+                out.insert(out.end(), found.begin(), found.end());
+                lists.offsets[i + 1] = static_cast<int>(found.size());
+            }
+        }
+    });
+
+    for (int i = 0; i < count; i++) lists.offsets[i + 1] += lists.offsets[i];
+    lists.indices.resize(lists.offsets[count]);
+    cv::parallel_for_(cv::Range(0, blocks), [&](const cv::Range& range) {
+        for (int b = range.start; b < range.end; b++) {
+            std::copy(blockIndices[b].begin(), blockIndices[b].end(), lists.indices.begin() + lists.offsets[b * kQueryBlock]);
+        }
+    });
+}
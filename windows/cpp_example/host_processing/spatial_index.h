@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <opencv2/core.hpp>
+
+// ═══════════════════════════════════════════════════════════════════════
+// Spatial Index for Unorganized Clouds
+// ═══════════════════════════════════════════════════════════════════════
+//
+// Nearest-neighbor, radius and box queries once the pixel grid is gone
+// (fused, voxelized or compacted clouds). Points are stored in Morton
+// order, cut into leaves of leafSize consecutive points, and an implicit
+// complete binary tree of bounding boxes sits on top of the leaves: node
+// i has children 2i and 2i+1, the root is node 1. Consecutive Morton
+// points are close in space, so the leaf boxes are tight, and every node
+// covers one contiguous range of points.
+//
+// Build:
+//   1. Row stripes find the valid points and the bounding cube.
+//   2. Each point gets a 63-bit Morton code (21 bits per axis) in its
+//      bounding cube. Points are counting-sorted by the top 12 code bits
+//      (stripes in parallel), then each bucket by the next 8 bits and the
+//      small remaining groups by full code (buckets in parallel).
+//   3. Coordinates are gathered in that order into x/y/z arrays; leaf
+//      boxes, then each tree level, are computed in parallel.
+//
+// Queries walk the tree nearest child first and prune by box distance;
+// leaves are scanned 4 points per SIMD step. Batched queries split the
+// query list over threads. The index is read-only after the build, so any
+// number of threads may query it. The build is deterministic.
+
+struct SpatialIndexParams {
+    int leafSize = 32;              // points per leaf
+    bool skipZeroDepth = true;      // z <= 0 is invalid (camera-frame SDK clouds); false for world frames
+};
+
+struct SpatialIndex {
+    std::vector<float> x, y, z;     // points in Morton order
+    std::vector<int> source;        // element index in the built cloud (row-major)
+    std::vector<cv::Vec6f> boxes;   // per node: min x, y, z, max x, y, z (empty: min > max)
+    int leafSize = 0;
+    int leafBase = 0;               // first leaf node (power of two)
+};
+
+// Build working arrays (16 bytes per valid point, twice), kept by callers
+// that rebuild every frame; not needed by queries
+struct SpatialIndexBuildBuffers {
+    std::vector<std::pair<uint64_t, int>> entries, sorted;  // (Morton code, element); result in entries
+};
+
+// cloud: CV_32FC3 of any shape (getPointcloudData, FusedCloud::points);
+// non-finite points are skipped. Results refer to cloud elements by their
+// row-major index. Without `buffers` the working arrays are freed on return.
+void buildSpatialIndex(const cv::Mat& cloud, SpatialIndex& index,
+                       const SpatialIndexParams& params = SpatialIndexParams());
+void buildSpatialIndex(const cv::Mat& cloud, SpatialIndex& index, SpatialIndexBuildBuffers& buffers,
+                       const SpatialIndexParams& params = SpatialIndexParams());
+
+// Up to k nearest points, closest first. Returns the number found; the
+// remaining entries get index -1.
+int nearestNeighbors(const SpatialIndex& index, const cv::Vec3f& query, int k, int* indices,
+                     float* sqDistances);
+
+// Points within radius, unordered
+void radiusSearch(const SpatialIndex& index, const cv::Vec3f& query, float radius, std::vector<int>& indices);
+
+// Points with lo <= p <= hi on every axis
+void boxSearch(const SpatialIndex& index, const cv::Vec3f& lo, const cv::Vec3f& hi, std::vector<int>& indices);
+
+// queries: CV_32FC3 of any shape; non-finite queries find nothing.
+// indices: queries.total() x k CV_32SC1, sqDistances: same size CV_32FC1.
+void nearestNeighborsBatch(const SpatialIndex& index, const cv::Mat& queries, int k, cv::Mat& indices,
+                           cv::Mat& sqDistances);
+
+// Neighbors of query i are indices[offsets[i]] .. indices[offsets[i + 1] - 1]
+struct NeighborLists {
+    std::vector<int> offsets;       // queries.total() + 1
+    std::vector<int> indices;
+};
+
+void radiusSearchBatch(const SpatialIndex& index, const cv::Mat& queries, float radius, NeighborLists& lists);
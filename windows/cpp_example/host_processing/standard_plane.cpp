@@ -0,0 +1,94 @@
+#include "standard_plane.h"
+#include <cmath>
+#include <iostream>
+
+StandardPlaneExternal standardPlaneFromFit(const PlaneFitResult& plane) {
+    StandardPlaneExternal ext;
+
+    cv::Vec3f ez = plane.normal;
+    cv::Vec3f ex = cv::Vec3f(1.0f, 0.0f, 0.0f) - ez * ez[0];
+    if (cv::norm(ex) < 1e-3) ex = cv::Vec3f(0.0f, 1.0f, 0.0f) - ez * ez[1];  // plane seen edge-on
+    ex *= 1.0f / static_cast<float>(cv::norm(ex));
+    cv::Vec3f ey = ez.cross(ex);
+
+    const cv::Vec3f rows[3] = { ex, ey, ez };
+    const cv::Vec3f c(plane.centroid.x, plane.centroid.y, plane.centroid.z);
+    for (int r = 0; r < 3; r++) {
+        for (int k = 0; k < 3; k++) ext.R[3 * r + k] = rows[r][k];
+        ext.T[r] = -rows[r].dot(c);
+    }
+    return ext;
+}
+
+static double elapsedMs(int64 start) {
+    return (cv::getTickCount() - start) * 1000.0 / cv::getTickFrequency();
+}
+
+int calibrateStandardPlane(XEMA::XCamera* camera, const StandardPlaneCalibParams& params,
+                           StandardPlaneCalibResult& result) {
+    result = StandardPlaneCalibResult();
+
+    int width = 0, height = 0;
+    if (0 != camera->getCameraResolution(&width, &height) || width <= 0 || height <= 0) {
+        std::cerr << "Get Camera Resolution Error!" << std::endl;
+        return -1;
+    }
+
+    // 1. Capture
+    int64 start = cv::getTickCount();
+    char timestamp[30] = "";
+    cv::Mat cloud(height, width, CV_32FC3);
+    if (0 != camera->captureData(params.exposureNum, timestamp) ||
+        0 != camera->getPointcloudData(cloud.ptr<float>())) {
+        std::cerr << "Capture Data Error!" << std::endl;
+        return -1;
+    }
+    result.captureMs = elapsedMs(start);
+
+    // 2. Plane fit
+    start = cv::getTickCount();
+    result.plane = fitDominantPlane(cloud, params.fit);
+    result.fitMs = elapsedMs(start);
+
+    const PlaneFitResult& plane = result.plane;
+    if (!plane.valid) {
+        std::cerr << "No plane found (valid points: " << plane.support << ")" << std::endl;
+        return -1;
+    }
+    float ratio = plane.support > 0 ? static_cast<float>(plane.inliers) / plane.support : 0.0f;
+    std::cout << "Plane: normal=(" << plane.normal[0] << ", " << plane.normal[1] << ", " << plane.normal[2]
+              << "), d=" << plane.d << ", inliers=" << plane.inliers << "/" << plane.support
+              << ", rms=" << plane.rms << " mm" << std::endl;
+    if (ratio < params.minInlierRatio) {
+        std::cerr << "Plane covers only " << ratio * 100.0f << "% of the valid points, rejected" << std::endl;
+        return -1;
+    }
+
+    // 3. R/T
+    result.external = standardPlaneFromFit(plane);
+    if (!params.writeToCamera) return 0;
+
+    if (0 != camera->setParamStandardPlaneExternal(result.external.R, result.external.T)) {
+        std::cerr << "Set Param Standard Plane External Error!" << std::endl;
+        return -1;
+    }
+
+    StandardPlaneExternal readBack;
+    if (0 != camera->getParamStandardPlaneExternal(readBack.R, readBack.T)) {
+        std::cerr << "Get Param Standard Plane External Error!" << std::endl;
+        return -1;
+    }
+    for (int i = 0; i < 9; i++) {
+        if (std::abs(readBack.R[i] - result.external.R[i]) > 1e-5f) {
+            std::cerr << "Standard plane R read back differs from the written value" << std::endl;
+            return -1;
+        }
+    }
+    for (int i = 0; i < 3; i++) {
+        if (std::abs(readBack.T[i] - result.external.T[i]) > 1e-3f) {
+            std::cerr << "Standard plane T read back differs from the written value" << std::endl;
+            return -1;
+        }
+    }
+    return 0;
+}
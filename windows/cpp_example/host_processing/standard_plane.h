@@ -0,0 +1,43 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include "xcamera.h"
+#include "plane_fit.h"
+
+// ═══════════════════════════════════════════════════════════════════════
+// Standard-Plane Calibration
+// ═══════════════════════════════════════════════════════════════════════
+//
+// Derives the setParamStandardPlaneExternal(R, T) parameters from a single
+// capture: the dominant plane in view becomes z' = 0 of the height map.
+//
+//   p' = R * p + T
+//
+// R's third row is the plane normal (pointing away from the camera), its
+// first row the camera x axis projected onto the plane. T puts the origin
+// at the centroid of the plane inliers.
+
+struct StandardPlaneExternal {
+    float R[3 * 3];     // row-major
+    float T[3];
+};
+
+struct StandardPlaneCalibParams {
+    PlaneFitParams fit;
+    int exposureNum = 1;            // captureData exposure count (>1 uses the HDR settings)
+    float minInlierRatio = 0.3f;    // inliers / valid points in the ROI below which the fit is rejected
+    bool writeToCamera = true;      // false: compute only (dry run)
+};
+
+struct StandardPlaneCalibResult {
+    PlaneFitResult plane;
+    StandardPlaneExternal external;
+    double captureMs;
+    double fitMs;
+};
+
+StandardPlaneExternal standardPlaneFromFit(const PlaneFitResult& plane);
+
+// Captures one frame, fits the plane and (optionally) writes R/T to the
+// camera and reads them back. Returns 0 on success, -1 on failure.
+int calibrateStandardPlane(XEMA::XCamera* camera, const StandardPlaneCalibParams& params,
+                           StandardPlaneCalibResult& result);
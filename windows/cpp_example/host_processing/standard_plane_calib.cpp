@@ -0,0 +1,106 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include "xcamera.h"
+#include "enumerate.h"
+#include "standard_plane.h"
+
+using namespace XEMA;
+
+// ═══════════════════════════════════════════════════════════════════════
+// Standard-Plane Calibration Tool
+// ═══════════════════════════════════════════════════════════════════════
+//
+// Re-levels the height map after a fixture change: captures one frame,
+// fits the support plane and writes R/T with setParamStandardPlaneExternal.
+//
+// Usage: standard_plane_calib [--ip IP] [--roi X Y W H] [--threshold MM]
+//                             [--exposure-num N] [--dry-run]
+//
+// Without --ip the first camera found is used. --roi restricts the fit to
+// the part of the image that shows the support plane.
+
+static bool parseOptions(int argc, char** argv, std::string& ip, StandardPlaneCalibParams& params) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--ip" && hasValue) ip = argv[++i];
+        else if (arg == "--roi" && i + 4 < argc) {
+            params.fit.roi.x = std::atoi(argv[++i]);
+            params.fit.roi.y = std::atoi(argv[++i]);
+            params.fit.roi.width = std::atoi(argv[++i]);
+            params.fit.roi.height = std::atoi(argv[++i]);
+        }
+        else if (arg == "--threshold" && hasValue) params.fit.inlierThreshold = static_cast<float>(std::atof(argv[++i]));
+        else if (arg == "--exposure-num" && hasValue) params.exposureNum = std::atoi(argv[++i]);
+        else if (arg == "--dry-run") params.writeToCamera = false;
+        else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static void printExternal(const StandardPlaneExternal& ext) {
+    std::cout << std::fixed << std::setprecision(6);
+    std::cout << "R:" << std::endl;
+    for (int r = 0; r < 3; r++) {
+        std::cout << "  " << ext.R[3 * r] << "\t" << ext.R[3 * r + 1] << "\t" << ext.R[3 * r + 2] << std::endl;
+    }
+    std::cout << "T:" << std::endl;
+    std::cout << "  " << ext.T[0] << "\t" << ext.T[1] << "\t" << ext.T[2] << std::endl;
+
+    // Same layout as the config.json block
+    std::cout << "\n\"standard_plane_external_param\": [" << std::endl;
+    for (int i = 0; i < 12; i++) {
+        float v = i < 9 ? ext.R[i] : ext.T[i - 9];
+        std::cout << "    " << std::setprecision(9) << v << (i < 11 ? "," : "") << std::endl;
+    }
+    std::cout << "]," << std::endl;
+}
+
+int main(int argc, char** argv) {
+    std::string ip;
+    StandardPlaneCalibParams params;
+    if (!parseOptions(argc, argv, ip, params)) {
+        std::cerr << "Usage: standard_plane_calib [--ip IP] [--roi X Y W H] [--threshold MM]"
+                  << " [--exposure-num N] [--dry-run]" << std::endl;
+        return -1;
+    }
+
+    if (ip.empty()) {
+        int camera_num = 0;
+        if (0 != DfUpdateDeviceList(camera_num) || 0 == camera_num) {
+            std::cerr << "No camera found!" << std::endl;
+            return -1;
+        }
+        std::vector<DeviceBaseInfo> devices(camera_num);
+        int n_size = camera_num * sizeof(DeviceBaseInfo);
+        DfGetAllDeviceBaseInfo(devices.data(), &n_size);
+        ip = devices[0].ip;
+    }
+
+    XCamera* p_camera = (XCamera*)createXCamera();
+    if (0 != p_camera->connect(ip.c_str())) {
+        std::cerr << "Connect Camera Error! (" << ip << ")" << std::endl;
+        destroyXCamera(p_camera);
+        return -1;
+    }
+    std::cout << "Connected: " << ip << std::endl;
+
+    StandardPlaneCalibResult result;
+    int ret_code = calibrateStandardPlane(p_camera, params, result);
+
+    if (0 == ret_code) {
+        printExternal(result.external);
+        std::cout << std::setprecision(1) << "\nCapture " << result.captureMs << " ms, fit " << result.fitMs << " ms" << std::endl;
+        std::cout << (params.writeToCamera ? "Standard plane written to camera." : "Dry run, camera not changed.") << std::endl;
+    }
+
+    p_camera->disconnect(ip.c_str());
+    destroyXCamera(p_camera);
+    return ret_code;
+}
@@ -0,0 +1,183 @@
+#include "temporal_filter.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <opencv2/core/hal/intrin.hpp>
+
+// ═══════════════════════════════════════════════════════════════════════
+// Accumulation
+// ═══════════════════════════════════════════════════════════════════════
+
+void resetTemporalAccumulator(TemporalAccumulator& acc, const cv::Size& size) {
+    acc.mean = cv::Mat::zeros(size, CV_32FC1);
+    acc.m2 = cv::Mat::zeros(size, CV_32FC1);
+    acc.count = cv::Mat::zeros(size, CV_32FC1);
+    acc.strikes = cv::Mat::zeros(size, CV_32FC1);
+    acc.frames = 0;
+}
+
+void accumulateDepth(TemporalAccumulator& acc, const cv::Mat& depth, const TemporalParams& params) {
+    CV_Assert(depth.type() == CV_32FC1);
+    if (acc.mean.size() != depth.size()) resetTemporalAccumulator(acc, depth.size());
+
+    const float minSamples = static_cast<float>(std::max(2, params.minSamples));
+    const float sigma2 = params.motionSigma * params.motionSigma;
+    const float floorScale = params.motionAt1000mm * 1e-6f;
+    const float motionFrames = static_cast<float>(std::max(1, params.motionFrames));
+    const int cols = depth.cols;
+
+    cv::parallel_for_(cv::Range(0, depth.rows), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; y++) {
+            const float* zr = depth.ptr<float>(y);
+            float* mean = acc.mean.ptr<float>(y);
+            float* m2 = acc.m2.ptr<float>(y);
+            float* count = acc.count.ptr<float>(y);
+            float* strikes = acc.strikes.ptr<float>(y);
+
+            int x = 0;
+#if CV_SIMD128
+            const cv::v_float32x4 zero = cv::v_setzero_f32(), one = cv::v_setall_f32(1.0f);
+            const cv::v_float32x4 vmin = cv::v_setall_f32(minSamples), vsigma2 = cv::v_setall_f32(sigma2);
+            const cv::v_float32x4 vfloor = cv::v_setall_f32(floorScale), vframes = cv::v_setall_f32(motionFrames);
+            for (; x <= cols - 4; x += 4) {
+                cv::v_float32x4 z = cv::v_load(zr + x), m = cv::v_load(mean + x);
+                cv::v_float32x4 s = cv::v_load(m2 + x), n = cv::v_load(count + x), k = cv::v_load(strikes + x);
+                cv::v_float32x4 valid = z > zero;
+
+                // Squared distances compared, no sqrt: d^2 > sigma^2 * var or d^2 > floor^2
+                cv::v_float32x4 d = z - m;
+                cv::v_float32x4 var = s / cv::v_max(n - one, one);
+                cv::v_float32x4 floorZ = vfloor * z * z;
+                cv::v_float32x4 motion = valid & (n >= vmin) & (d * d > vsigma2 * var) & (d * d > floorZ * floorZ);
+
+                k = cv::v_select(motion, k + one, cv::v_select(valid, zero, k));
+                cv::v_float32x4 restart = motion & (k >= vframes);
+                cv::v_float32x4 accept = valid & ~motion;
+
+                cv::v_float32x4 n1 = n + one;
+                cv::v_float32x4 m1 = m + d / n1;
+                cv::v_float32x4 s1 = cv::v_muladd(d, z - m1, s);
+
+                m = cv::v_select(restart, z, cv::v_select(accept, m1, m));
+                s = cv::v_select(restart, zero, cv::v_select(accept, s1, s));
+                n = cv::v_select(restart, one, cv::v_select(accept, n1, n));
+                k = cv::v_select(restart, zero, k);
+
+                cv::v_store(mean + x, m);
+                cv::v_store(m2 + x, s);
+                cv::v_store(count + x, n);
+                cv::v_store(strikes + x, k);
+            }
+#endif
+            for (; x < cols; x++) {
+                const float z = zr[x];
+                if (!(z > 0.0f)) continue;
+                const float d = z - mean[x];
+                const float var = m2[x] / std::max(count[x] - 1.0f, 1.0f);
+                const float floorZ = floorScale * z * z;
+                if (count[x] >= minSamples && d * d > sigma2 * var && d * d > floorZ * floorZ) {
+                    strikes[x] += 1.0f;
+                    if (strikes[x] >= motionFrames) {
+                        mean[x] = z;
+                        m2[x] = 0.0f;
+                        count[x] = 1.0f;
+                        strikes[x] = 0.0f;
+                    }
+                    continue;
+                }
+                strikes[x] = 0.0f;
+                count[x] += 1.0f;
+                mean[x] += d / count[x];
+                m2[x] += d * (z - mean[x]);
+            }
+        }
+    });
+    acc.frames++;
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Convergence and Result
+// ═══════════════════════════════════════════════════════════════════════
+
+float temporalConvergence(const TemporalAccumulator& acc, const TemporalParams& params) {
+    const int minSamples = std::max(2, params.minSamples);
+    if (acc.frames < minSamples || acc.mean.empty()) return 0.0f;
+
+    const cv::Rect frame(0, 0, acc.mean.cols, acc.mean.rows);
+    const cv::Rect area = params.roi.area() > 0 ? params.roi & frame : frame;
+    const float targetScale = params.targetAt1000mm * 1e-6f;
+    std::atomic<long long> validTotal(0), metTotal(0);
+
+    cv::parallel_for_(cv::Range(area.y, area.y + area.height), [&](const cv::Range& range) {
+        long long valid = 0, met = 0;
+        for (int y = range.start; y < range.end; y++) {
+            const float* mean = acc.mean.ptr<float>(y) + area.x;
+            const float* m2 = acc.m2.ptr<float>(y) + area.x;
+            const float* count = acc.count.ptr<float>(y) + area.x;
+            for (int x = 0; x < area.width; x++) {
+                const float n = count[x];
+                if (n < minSamples) continue;
+                // stderr^2 = m2 / ((n - 1) * n) against target^2, without sqrt
+                const float target = targetScale * mean[x] * mean[x];
+                valid++;
+                if (m2[x] <= target * target * (n - 1.0f) * n) met++;
+            }
+        }
+        validTotal += valid;
+        metTotal += met;
+    });
+    return validTotal > 0 ? static_cast<float>(static_cast<double>(metTotal) / validTotal) : 0.0f;
+}
+
+void temporalResult(const TemporalAccumulator& acc, int minCount, cv::Mat& depth, cv::Mat* stdError) {
+    CV_Assert(!acc.mean.empty());
+    const float minN = static_cast<float>(std::max(1, minCount));
+    depth.create(acc.mean.size(), CV_32FC1);
+    if (stdError) stdError->create(acc.mean.size(), CV_32FC1);
+
+    cv::parallel_for_(cv::Range(0, acc.mean.rows), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; y++) {
+            const float* mean = acc.mean.ptr<float>(y);
+            const float* m2 = acc.m2.ptr<float>(y);
+            const float* count = acc.count.ptr<float>(y);
+            float* out = depth.ptr<float>(y);
+            float* err = stdError ? stdError->ptr<float>(y) : nullptr;
+            for (int x = 0; x < acc.mean.cols; x++) {
+                const float n = count[x];
+                out[x] = n >= minN ? mean[x] : 0.0f;
+                if (err) err[x] = n >= minN && n >= 2.0f ? std::sqrt(m2[x] / ((n - 1.0f) * n)) : 0.0f;
+            }
+        }
+    });
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Capture
+// ═══════════════════════════════════════════════════════════════════════
+
+int captureTemporalDepth(XEMA::XCamera* camera, const TemporalParams& params, TemporalAccumulator& acc,
+                         cv::Mat& depth, int& frames) {
+    frames = 0;
+    int width = 0, height = 0;
+    if (0 != camera->getCameraResolution(&width, &height) || width <= 0 || height <= 0) {
+        std::cerr << "Get Camera Resolution Error!" << std::endl;
+        return -1;
+    }
+    resetTemporalAccumulator(acc, cv::Size(width, height));
+
+    cv::Mat frame(height, width, CV_32FC1);
+    char timestamp[30] = "";
+    while (frames < std::max(1, params.maxFrames)) {
+        if (0 != camera->captureData(1, timestamp) || 0 != camera->getDepthData(frame.ptr<float>())) {
+            std::cerr << "Capture Data Error!" << std::endl;
+            return -1;
+        }
+        frames++;
+        accumulateDepth(acc, frame, params);
+        if (temporalConvergence(acc, params) >= params.targetFraction) break;
+    }
+
+    temporalResult(acc, frames >= params.minSamples ? params.minSamples : 1, depth);
+    return 0;
+}
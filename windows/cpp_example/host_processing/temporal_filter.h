@@ -0,0 +1,65 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include "xcamera.h"
+
+// ═══════════════════════════════════════════════════════════════════════
+// Temporal Depth Averaging
+// ═══════════════════════════════════════════════════════════════════════
+//
+// Host-side replacement for setParamRepetitionExposureNum (fixed 2-10
+// repeats averaged on the camera): single captures are streamed in and
+// averaged per pixel with Welford's running mean / variance, so capturing
+// stops as soon as the noise target is met.
+//
+// Statistics are kept as one plane each (mean, m2, count, strikes), so a
+// frame update is four aligned streams and vectorizes directly.
+//
+// Motion rejection: once a pixel has minSamples, a sample further than
+//     max(motionSigma * std, motionAt1000mm * (z / 1000)^2)
+// from the mean is not averaged in. motionFrames such samples in a row
+// mean the surface moved: the pixel restarts from the new sample.
+//
+// Noise target: standard error of the mean
+//     sqrt(m2 / (n - 1) / n) <= targetAt1000mm * (z / 1000)^2
+// for targetFraction of the valid ROI pixels.
+
+struct TemporalParams {
+    cv::Rect roi;                   // region for the noise target; empty = whole frame
+    int minSamples = 3;             // samples before motion rejection and the noise target apply
+    float motionSigma = 4.0f;       // rejection distance in standard deviations
+    float motionAt1000mm = 1.0f;    // minimum rejection distance (mm) at z = 1000 mm
+    int motionFrames = 2;           // rejected samples in a row that restart a pixel
+    float targetAt1000mm = 0.05f;   // standard error target (mm) at z = 1000 mm
+    float targetFraction = 0.95f;   // fraction of valid ROI pixels that must meet it
+    int maxFrames = 10;             // capture limit of captureTemporalDepth
+};
+
+struct TemporalAccumulator {
+    cv::Mat mean;                   // CV_32FC1, mm
+    cv::Mat m2;                     // CV_32FC1, sum of squared deviations
+    cv::Mat count;                  // CV_32FC1, samples in the mean
+    cv::Mat strikes;                // CV_32FC1, rejected samples in a row
+    int frames = 0;                 // frames accumulated
+};
+
+// Clears all statistics for frames of `size`
+void resetTemporalAccumulator(TemporalAccumulator& acc, const cv::Size& size);
+
+// Adds one getDepthData frame (CV_32FC1, z <= 0 invalid). Rows are
+// processed in parallel.
+void accumulateDepth(TemporalAccumulator& acc, const cv::Mat& depth, const TemporalParams& params = TemporalParams());
+
+// Fraction of the valid ROI pixels (count >= minSamples) that meet the
+// noise target; 0 before minSamples frames
+float temporalConvergence(const TemporalAccumulator& acc, const TemporalParams& params = TemporalParams());
+
+// depth: CV_32FC1 mean, 0 where count < minCount.
+// stdError (optional): CV_32FC1 standard error of the mean, 0 where unknown.
+void temporalResult(const TemporalAccumulator& acc, int minCount, cv::Mat& depth, cv::Mat* stdError = nullptr);
+
+// captureData(1) + getDepthData until the noise target or maxFrames is
+// reached; depth is temporalResult(acc, minSamples) (minCount 1 when
+// fewer frames were taken). frames: captures used.
+// Returns 0 on success, -1 on any SDK error.
+int captureTemporalDepth(XEMA::XCamera* camera, const TemporalParams& params, TemporalAccumulator& acc,
+                         cv::Mat& depth, int& frames);
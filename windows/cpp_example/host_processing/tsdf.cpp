@@ -0,0 +1,462 @@
+#include "tsdf.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <opencv2/core/hal/intrin.hpp>
+#include "voxel_key.h"
+
+namespace {
+
+const int kStripes = 32;
+
+using voxel_key::voxelIndex;
+
+// Blocks are keyed by their block coordinates
+inline uint64_t blockKey(int bx, int by, int bz) {
+    return voxel_key::voxelKey(bx, by, bz);
+}
+
+inline cv::Vec3i blockCoord(uint64_t key) {
+    return voxel_key::voxelCoord(key);
+}
+
+inline size_t slotOf(uint64_t key, size_t mask) {
+    return (voxel_key::voxelHash(key) >> 20) & mask;
+}
+
+int findBlock(const TsdfVolume& volume, uint64_t key) {
+    if (volume.slotBlocks.empty()) return -1;
+    const size_t mask = volume.slotBlocks.size() - 1;
+    for (size_t slot = slotOf(key, mask);; slot = (slot + 1) & mask) {
+        const int index = volume.slotBlocks[slot];
+        if (index < 0 || volume.slotKeys[slot] == key) return index;
+    }
+}
+
+int insertBlock(TsdfVolume& volume, uint64_t key) {
+    if (2 * (volume.blocks.size() + 1) > volume.slotBlocks.size()) {
+        const size_t capacity = std::max<size_t>(1024, 2 * volume.slotBlocks.size());
+        volume.slotKeys.assign(capacity, 0);
+        volume.slotBlocks.assign(capacity, -1);
+        for (size_t i = 0; i < volume.blocks.size(); i++) {
+            const cv::Vec3i& c = volume.blocks[i].coord;
+            const uint64_t k = blockKey(c[0], c[1], c[2]);
+            size_t slot = slotOf(k, capacity - 1);
+            while (volume.slotBlocks[slot] >= 0) slot = (slot + 1) & (capacity - 1);
+            volume.slotKeys[slot] = k;
+            volume.slotBlocks[slot] = static_cast<int>(i);
+        }
+    }
+    const size_t mask = volume.slotBlocks.size() - 1;
+    size_t slot = slotOf(key, mask);
+    while (volume.slotBlocks[slot] >= 0) {
+        if (volume.slotKeys[slot] == key) return volume.slotBlocks[slot];
+        slot = (slot + 1) & mask;
+    }
+    volume.slotKeys[slot] = key;
+    volume.slotBlocks[slot] = static_cast<int>(volume.blocks.size());
+    volume.blocks.emplace_back();
+    TsdfBlock& block = volume.blocks.back();
+    block.coord = blockCoord(key);
+    block.lastFrame = -1;
+    std::memset(block.voxels, 0, sizeof(block.voxels));
+    return volume.slotBlocks[slot];
+}
+
+}  // namespace
+
+void resetTsdfVolume(TsdfVolume& volume, const TsdfParams& params) {
+    volume.params = params;
+    volume.blocks.clear();
+    volume.slotKeys.clear();
+    volume.slotBlocks.clear();
+    volume.frames = 0;
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Integration
+// ═══════════════════════════════════════════════════════════════════════
+
+void integrateDepth(TsdfVolume& volume, const cv::Mat& depth, const XEMA::CalibrationParam& calibration,
+                    const cv::Matx44d& pose) {
+    CV_Assert(depth.type() == CV_32FC1);
+    const TsdfParams& params = volume.params;
+    CV_Assert(params.voxelSize > 0.0f && params.truncation > 0.0f);
+    const int rows = depth.rows, cols = depth.cols;
+    const float blockSize = kTsdfBlockSide * params.voxelSize;
+    const float invBlock = 1.0f / blockSize;
+    const float trunc = params.truncation;
+
+    // Allocation rays
+    float cal[14];
+    std::copy(calibration.intrinsic, calibration.intrinsic + 9, cal);
+    std::copy(calibration.distortion, calibration.distortion + 5, cal + 9);
+    if (volume.rays.x.size() != depth.size() || std::memcmp(cal, volume.rayCalibration, sizeof(cal)) != 0) {
+        volume.rays = makeDepthRays(depth.size(), calibration.intrinsic, calibration.distortion);
+        std::copy(cal, cal + 14, volume.rayCalibration);
+    }
+
+    const cv::Matx44f T = pose;
+    const cv::Matx33f R = T.get_minor<3, 3>(0, 0);
+    const cv::Vec3f t(T(0, 3), T(1, 3), T(2, 3));
+
+    // 1. Blocks within the truncation band of the sampled rays
+    const int step = std::max(1, params.allocationStep);
+    std::vector<std::vector<uint64_t>> stripeKeys(kStripes);
+    cv::parallel_for_(cv::Range(0, kStripes), [&](const cv::Range& range) {
+        for (int s = range.start; s < range.end; s++) {
+            std::vector<uint64_t>& keys = stripeKeys[s];
+            keys.clear();
+            const int y0 = rows * s / kStripes, y1 = rows * (s + 1) / kStripes;
+            uint64_t last = ~0ull;
+            for (int y = y0 + (step - y0 % step) % step; y < y1; y += step) {
+                const float* z = depth.ptr<float>(y);
+                const float* rx = volume.rays.x.ptr<float>(y);
+                const float* ry = volume.rays.y.ptr<float>(y);
+                for (int x = 0; x < cols; x += step) {
+                    if (!(z[x] >= params.minDepth && z[x] <= params.maxDepth)) continue;
+                    const cv::Vec3f dir = R * cv::Vec3f(rx[x], ry[x], 1.0f);
+                    for (float d = z[x] - trunc;; d += 0.5f * blockSize) {
+                        d = std::min(d, z[x] + trunc);
+                        const cv::Vec3f p = dir * d + t;
+                        const uint64_t key = blockKey(voxelIndex(p[0] * invBlock), voxelIndex(p[1] * invBlock),
+                                                      voxelIndex(p[2] * invBlock));
+                        if (key != last) keys.push_back(key);
+                        last = key;
+                        if (d >= z[x] + trunc) break;
+                    }
+                }
+            }
+            std::sort(keys.begin(), keys.end());
+            keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+        }
+    });
+
+    const int frame = volume.frames;
+    std::vector<int> visible;
+    for (const std::vector<uint64_t>& keys : stripeKeys) {
+        for (uint64_t key : keys) {
+            const int index = insertBlock(volume, key);
+            if (volume.blocks[index].lastFrame == frame) continue;
+            volume.blocks[index].lastFrame = frame;
+            visible.push_back(index);
+        }
+    }
+
+    // 2. Projective update of the visible blocks
+    const cv::Matx33f Ri = R.t();
+    const cv::Vec3f ti = -(Ri * t);
+    const float fx = calibration.intrinsic[0], skew = calibration.intrinsic[1], cx = calibration.intrinsic[2];
+    const float fy = calibration.intrinsic[4], cy = calibration.intrinsic[5];
+    const float k1 = calibration.distortion[0], k2 = calibration.distortion[1];
+    const float p1 = calibration.distortion[2], p2 = calibration.distortion[3], k3 = calibration.distortion[4];
+    const float vs = params.voxelSize, invTrunc = 1.0f / trunc, maxWeight = params.maxWeight;
+    const cv::Vec3f dx = Ri * cv::Vec3f(vs, 0.0f, 0.0f);
+
+    cv::parallel_for_(cv::Range(0, static_cast<int>(visible.size())), [&](const cv::Range& range) {
+        int u[kTsdfBlockSide], v[kTsdfBlockSide];
+        float zc[kTsdfBlockSide];
+
+        for (int b = range.start; b < range.end; b++) {
+            TsdfBlock& block = volume.blocks[visible[b]];
+            const cv::Vec3i origin = block.coord * kTsdfBlockSide;
+
+            for (int lz = 0; lz < kTsdfBlockSide; lz++) {
+                for (int ly = 0; ly < kTsdfBlockSide; ly++) {
+                    const cv::Vec3f world(origin[0] * vs, (origin[1] + ly) * vs, (origin[2] + lz) * vs);
+                    const cv::Vec3f p0 = Ri * world + ti;
+
+                    // Voxel centers along x, projected with the lens distortion
+                    int lx = 0;
+#if CV_SIMD128
+                    const cv::v_float32x4 one = cv::v_setall_f32(1.0f), two = cv::v_setall_f32(2.0f);
+                    const cv::v_float32x4 vk1 = cv::v_setall_f32(k1), vk2 = cv::v_setall_f32(k2), vk3 = cv::v_setall_f32(k3);
+                    const cv::v_float32x4 vp1 = cv::v_setall_f32(p1), vp2 = cv::v_setall_f32(p2);
+                    for (; lx < kTsdfBlockSide; lx += 4) {
+                        const cv::v_float32x4 i(static_cast<float>(lx), lx + 1.0f, lx + 2.0f, lx + 3.0f);
+                        const cv::v_float32x4 px = cv::v_setall_f32(p0[0]) + i * cv::v_setall_f32(dx[0]);
+                        const cv::v_float32x4 py = cv::v_setall_f32(p0[1]) + i * cv::v_setall_f32(dx[1]);
+                        const cv::v_float32x4 pz = cv::v_setall_f32(p0[2]) + i * cv::v_setall_f32(dx[2]);
+                        const cv::v_float32x4 iz = one / pz;
+                        const cv::v_float32x4 x = px * iz, y = py * iz;
+                        const cv::v_float32x4 xx = x * x, yy = y * y, xy = x * y, r2 = xx + yy;
+                        const cv::v_float32x4 radial = one + r2 * (vk1 + r2 * (vk2 + r2 * vk3));
+                        const cv::v_float32x4 xd = x * radial + two * vp1 * xy + vp2 * (r2 + two * xx);
+                        const cv::v_float32x4 yd = y * radial + vp1 * (r2 + two * yy) + two * vp2 * xy;
+                        cv::v_store(u + lx, cv::v_round(cv::v_setall_f32(fx) * xd + cv::v_setall_f32(skew) * yd +
+                                                        cv::v_setall_f32(cx)));
+                        cv::v_store(v + lx, cv::v_round(cv::v_setall_f32(fy) * yd + cv::v_setall_f32(cy)));
+                        cv::v_store(zc + lx, pz);
+                    }
+#endif
+                    for (; lx < kTsdfBlockSide; lx++) {
+                        const cv::Vec3f p = p0 + dx * static_cast<float>(lx);
+                        const float x = p[0] / p[2], y = p[1] / p[2];
+                        const float r2 = x * x + y * y;
+                        const float radial = 1.0f + r2 * (k1 + r2 * (k2 + r2 * k3));
+                        const float xd = x * radial + 2.0f * p1 * x * y + p2 * (r2 + 2.0f * x * x);
+                        const float yd = y * radial + p1 * (r2 + 2.0f * y * y) + 2.0f * p2 * x * y;
+                        u[lx] = static_cast<int>(std::lround(fx * xd + skew * yd + cx));
+                        v[lx] = static_cast<int>(std::lround(fy * yd + cy));
+                        zc[lx] = p[2];
+                    }
+
+                    TsdfVoxel* voxel = &block.voxels[(lz * kTsdfBlockSide + ly) * kTsdfBlockSide];
+                    for (lx = 0; lx < kTsdfBlockSide; lx++) {
+                        if (!(zc[lx] > 0.0f) || u[lx] < 0 || v[lx] < 0 || u[lx] >= cols || v[lx] >= rows) continue;
+                        const float d = depth.ptr<float>(v[lx])[u[lx]];
+                        if (!(d >= params.minDepth && d <= params.maxDepth)) continue;
+                        const float sdf = d - zc[lx];
+                        if (sdf < -trunc) continue;
+                        const float value = std::min(1.0f, sdf * invTrunc);
+                        TsdfVoxel& vox = voxel[lx];
+                        vox.tsdf = (vox.tsdf * vox.weight + value) / (vox.weight + 1.0f);
+                        vox.weight = std::min(maxWeight, vox.weight + 1.0f);
+                    }
+                }
+            }
+        }
+    });
+    volume.frames++;
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Marching Cubes
+// ═══════════════════════════════════════════════════════════════════════
+
+namespace {
+
+// Corner c of a cube sits at (c & 1, c >> 1 & 1, c >> 2 & 1). Edge
+// 4 * axis + k runs along `axis` from the corner whose other two
+// coordinates are the bits of k (in cyclic axis order).
+struct MarchingCubesTable {
+    int edgeStart[12];
+    int edgeAxis[12];
+    signed char triangles[256][31];   // edge triples, -1 terminated
+
+    MarchingCubesTable() {
+        for (int axis = 0; axis < 3; axis++) {
+            for (int k = 0; k < 4; k++) {
+                edgeStart[4 * axis + k] = ((k & 1) << ((axis + 1) % 3)) | ((k >> 1) << ((axis + 2) % 3));
+                edgeAxis[4 * axis + k] = axis;
+            }
+        }
+
+        // Each face contributes one segment per run of inside corners,
+        // from the edge entering the run to the edge leaving it (corners
+        // counter-clockwise seen from outside the cube). Runs never join
+        // across a face diagonal, and both cubes sharing a face decide it
+        // alike, so neighboring cubes always agree. Every crossed edge
+        // starts one segment and ends another; the segments chain into
+        // loops, fanned into triangles.
+        for (int config = 0; config < 256; config++) {
+            int next[12];
+            std::fill(next, next + 12, -1);
+            for (int axis = 0; axis < 3; axis++) {
+                const int b = (axis + 1) % 3, c = (axis + 2) % 3;
+                for (int side = 0; side < 2; side++) {
+                    int corners[4] = {side << axis, (side << axis) | (1 << b), (side << axis) | (1 << b) | (1 << c),
+                                      (side << axis) | (1 << c)};
+                    if (side == 0) std::swap(corners[1], corners[3]);
+                    for (int i = 0; i < 4; i++) {
+                        const int prev = corners[(i + 3) % 4];
+                        if (!inside(config, corners[i]) || inside(config, prev)) continue;
+                        int j = i;
+                        while (inside(config, corners[(j + 1) % 4])) j = (j + 1) % 4;
+                        next[edgeOf(prev, corners[i])] = edgeOf(corners[j], corners[(j + 1) % 4]);
+                    }
+                }
+            }
+
+            int n = 0;
+            bool visited[12] = {false};
+            for (int e = 0; e < 12; e++) {
+                if (next[e] < 0 || visited[e]) continue;
+                int loop[12], length = 0;
+                for (int f = e; !visited[f]; f = next[f]) {
+                    visited[f] = true;
+                    loop[length++] = f;
+                }
+                for (int i = 1; i + 1 < length; i++) {
+                    triangles[config][n++] = static_cast<signed char>(loop[0]);
+                    triangles[config][n++] = static_cast<signed char>(loop[i]);
+                    triangles[config][n++] = static_cast<signed char>(loop[i + 1]);
+                }
+            }
+            triangles[config][n] = -1;
+        }
+    }
+
+    static bool inside(int config, int corner) { return (config >> corner) & 1; }
+
+    int edgeOf(int c0, int c1) const {
+        const int start = c0 & c1, axis = (c0 ^ c1) == 1 ? 0 : (c0 ^ c1) == 2 ? 1 : 2;
+        const int k = ((start >> ((axis + 1) % 3)) & 1) | (((start >> ((axis + 2) % 3)) & 1) << 1);
+        return 4 * axis + k;
+    }
+};
+
+const MarchingCubesTable& marchingCubesTable() {
+    static const MarchingCubesTable table;
+    return table;
+}
+
+// The block and its 7 neighbors in +x / +y / +z, indexed by offset bits
+struct BlockNeighborhood {
+    const TsdfBlock* blocks[8];
+    int index[8];
+
+    // Voxel at block-local (x, y, z), each in [0, 16)
+    const TsdfVoxel* voxel(int x, int y, int z, int* block = nullptr, int* local = nullptr) const {
+        const int n = (x >> 3) | ((y >> 3) << 1) | ((z >> 3) << 2);
+        if (!blocks[n]) return nullptr;
+        const int l = ((z & 7) * kTsdfBlockSide + (y & 7)) * kTsdfBlockSide + (x & 7);
+        if (block) *block = index[n];
+        if (local) *local = l;
+        return &blocks[n]->voxels[l];
+    }
+};
+
+}  // namespace
+
+void extractTsdfMesh(const TsdfVolume& volume, TriangleMesh& mesh, float minWeight) {
+    const MarchingCubesTable& mc = marchingCubesTable();
+    const int blocks = static_cast<int>(volume.blocks.size());
+    const float vs = volume.params.voxelSize;
+    minWeight = std::max(minWeight, 1e-6f);
+
+    std::vector<BlockNeighborhood> hoods(blocks);
+    for (int b = 0; b < blocks; b++) {
+        const cv::Vec3i& c = volume.blocks[b].coord;
+        for (int n = 0; n < 8; n++) {
+            const int index = findBlock(volume, blockKey(c[0] + (n & 1), c[1] + ((n >> 1) & 1), c[2] + (n >> 2)));
+            hoods[b].index[n] = index;
+            hoods[b].blocks[n] = index >= 0 ? &volume.blocks[index] : nullptr;
+        }
+    }
+
+    // 1. Vertices on the crossed edges owned by each voxel (+x, +y, +z)
+    std::vector<int> localIndex(static_cast<size_t>(blocks) * kTsdfBlockVoxels * 3, -1);
+    std::vector<std::vector<cv::Vec3f>> blockVertices(blocks);
+
+    cv::parallel_for_(cv::Range(0, blocks), [&](const cv::Range& range) {
+        for (int b = range.start; b < range.end; b++) {
+            const BlockNeighborhood& hood = hoods[b];
+            const cv::Vec3i origin = volume.blocks[b].coord * kTsdfBlockSide;
+            int* indices = &localIndex[static_cast<size_t>(b) * kTsdfBlockVoxels * 3];
+            std::vector<cv::Vec3f>& vertices = blockVertices[b];
+            vertices.clear();
+
+            for (int z = 0; z < kTsdfBlockSide; z++) {
+                for (int y = 0; y < kTsdfBlockSide; y++) {
+                    for (int x = 0; x < kTsdfBlockSide; x++) {
+                        const TsdfVoxel& v0 = *hood.voxel(x, y, z);
+                        if (v0.weight < minWeight || !(std::abs(v0.tsdf) < 1.0f)) continue;
+                        for (int axis = 0; axis < 3; axis++) {
+                            const TsdfVoxel* v1 = hood.voxel(x + (axis == 0), y + (axis == 1), z + (axis == 2));
+                            if (!v1 || v1->weight < minWeight || !(std::abs(v1->tsdf) < 1.0f)) continue;
+                            if ((v0.tsdf < 0.0f) == (v1->tsdf < 0.0f)) continue;
+                            const float s = v0.tsdf / (v0.tsdf - v1->tsdf);
+                            cv::Vec3f p((origin[0] + x) * vs, (origin[1] + y) * vs, (origin[2] + z) * vs);
+                            p[axis] += s * vs;
+                            indices[((z * kTsdfBlockSide + y) * kTsdfBlockSide + x) * 3 + axis] =
+                                static_cast<int>(vertices.size());
+                            vertices.push_back(p);
+                        }
+                    }
+                }
+            }
+        }
+    });
+
+    std::vector<int> vertexOffset(blocks + 1, 0);
+    for (int b = 0; b < blocks; b++) vertexOffset[b + 1] = vertexOffset[b] + static_cast<int>(blockVertices[b].size());
+
+    // 2. Triangles of the cubes whose lower corner lies in each block
+    std::vector<std::vector<cv::Vec3i>> blockFaces(blocks);
+    cv::parallel_for_(cv::Range(0, blocks), [&](const cv::Range& range) {
+        for (int b = range.start; b < range.end; b++) {
+            const BlockNeighborhood& hood = hoods[b];
+            std::vector<cv::Vec3i>& faces = blockFaces[b];
+            faces.clear();
+
+            for (int z = 0; z < kTsdfBlockSide; z++) {
+                for (int y = 0; y < kTsdfBlockSide; y++) {
+                    for (int x = 0; x < kTsdfBlockSide; x++) {
+                        int config = 0;
+                        bool observed = true;
+                        for (int c = 0; c < 8 && observed; c++) {
+                            const TsdfVoxel* v = hood.voxel(x + (c & 1), y + ((c >> 1) & 1), z + (c >> 2));
+                            observed = v && v->weight >= minWeight;
+                            if (observed && v->tsdf < 0.0f) config |= 1 << c;
+                        }
+                        if (!observed || config == 0 || config == 255) continue;
+
+                        int ids[12];
+                        bool complete = true;
+                        for (int e = 0; e < 12; e++) ids[e] = -1;
+                        for (const signed char* t = mc.triangles[config]; *t >= 0 && complete; t++) {
+                            if (ids[*t] >= 0) continue;
+                            const int start = mc.edgeStart[*t];
+                            int block = 0, local = 0;
+                            hood.voxel(x + (start & 1), y + ((start >> 1) & 1), z + (start >> 2), &block, &local);
+                            const int id = localIndex[(static_cast<size_t>(block) * kTsdfBlockVoxels + local) * 3 +
+                                                      mc.edgeAxis[*t]];
+                            complete = id >= 0;
+                            ids[*t] = vertexOffset[block] + id;
+                        }
+                        // Edges with a truncated end have no vertex; the cube is left open
+                        if (!complete) continue;
+                        for (const signed char* t = mc.triangles[config]; *t >= 0; t += 3) {
+                            faces.push_back(cv::Vec3i(ids[t[0]], ids[t[1]], ids[t[2]]));
+                        }
+                    }
+                }
+            }
+        }
+    });
+
+    std::vector<int> faceOffset(blocks + 1, 0);
+    for (int b = 0; b < blocks; b++) faceOffset[b + 1] = faceOffset[b] + static_cast<int>(blockFaces[b].size());
+
+    mesh.vertices.create(std::max(1, vertexOffset[blocks]), 1, CV_32FC3);
+    mesh.faces.create(std::max(1, faceOffset[blocks]), 1, CV_32SC3);
+    cv::parallel_for_(cv::Range(0, blocks), [&](const cv::Range& range) {
+        for (int b = range.start; b < range.end; b++) {
+            if (!blockVertices[b].empty()) {
+                std::memcpy(mesh.vertices.ptr<float>(vertexOffset[b]), blockVertices[b].data(),
+                            blockVertices[b].size() * sizeof(cv::Vec3f));
+            }
+            if (!blockFaces[b].empty()) {
+                std::memcpy(mesh.faces.ptr<int>(faceOffset[b]), blockFaces[b].data(),
+                            blockFaces[b].size() * sizeof(cv::Vec3i));
+            }
+        }
+    });
+    mesh.vertices = mesh.vertices.rowRange(0, vertexOffset[blocks]);
+    mesh.faces = mesh.faces.rowRange(0, faceOffset[blocks]);
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Capture
+// ═══════════════════════════════════════════════════════════════════════
+
+int captureIntoTsdf(XEMA::XCamera* camera, const cv::Matx44d& pose, TsdfVolume& volume) {
+    int width = 0, height = 0;
+    if (0 != camera->getCameraResolution(&width, &height) || width <= 0 || height <= 0) {
+        std::cerr << "Get Camera Resolution Error!" << std::endl;
+        return -1;
+    }
+
+    char timestamp[30] = "";
+    cv::Mat depth(height, width, CV_32FC1);
+    XEMA::CalibrationParam calibration;
+    if (0 != camera->captureData(1, timestamp) || 0 != camera->getDepthData(depth.ptr<float>()) ||
+        0 != camera->getCalibrationParam(&calibration)) {
+        std::cerr << "Capture Data Error!" << std::endl;
+        return -1;
+    }
+    integrateDepth(volume, depth, calibration, pose);
+    return 0;
+}
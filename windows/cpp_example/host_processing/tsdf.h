@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <opencv2/core.hpp>
+#include "xcamera.h"
+#include "depth_cloud.h"
+#include "ply_io.h"
+
+// ═══════════════════════════════════════════════════════════════════════
+// TSDF Volume Fusion
+// ═══════════════════════════════════════════════════════════════════════
+//
+// Fuses depth captures taken from known poses (robot arm, turntable) into
+// a truncated signed distance field and extracts a closed mesh from it.
+//
+// Storage is sparse: voxels live in 8x8x8 blocks, found through an
+// open-addressing hash on the block coordinate, and only blocks near an
+// observed surface are ever allocated. Captures can be integrated one at
+// a time as they arrive; the mesh can be extracted at any point.
+//
+// Integration of one depth map:
+//   1. Allocation: rays of every allocationStep-th pixel are sampled
+//      within the truncation band around the measured depth; the blocks
+//      hit are looked up or created (stripes in parallel, inserts serial).
+//   2. Update: the blocks seen in this capture are integrated in parallel.
+//      Each voxel is projected into the depth map (with the calibrated
+//      distortion), 4 voxels per SIMD step; the projective distance
+//      d(pixel) - z(voxel), truncated to [-truncation, truncation] and
+//      scaled to [-1, 1], enters a running weighted mean.
+//
+// tsdf > 0 in front of the surface (toward the camera), < 0 behind it.
+// Extraction is marching cubes with vertices shared between cubes and
+// blocks, so the mesh is watertight wherever the field is observed.
+
+const int kTsdfBlockSide = 8;
+const int kTsdfBlockVoxels = kTsdfBlockSide * kTsdfBlockSide * kTsdfBlockSide;
+
+struct TsdfParams {
+    float voxelSize = 1.0f;         // mm
+    float truncation = 4.0f;        // mm; a few voxels
+    float maxWeight = 64.0f;        // caps the running mean, so later captures still count
+    float minDepth = 100.0f;        // mm; depths outside are ignored
+    float maxDepth = 3000.0f;
+    int allocationStep = 4;         // pixel step of the allocation rays
+};
+
+struct TsdfVoxel {
+    float tsdf;
+    float weight;                   // 0 = never observed
+};
+
+struct TsdfBlock {
+    cv::Vec3i coord;                // block coordinate (voxel coordinate / 8)
+    int lastFrame;                  // last capture that touched the block
+    TsdfVoxel voxels[kTsdfBlockVoxels];     // x fastest, then y, then z
+};
+
+struct TsdfVolume {
+    TsdfParams params;
+    std::vector<TsdfBlock> blocks;
+    std::vector<uint64_t> slotKeys; // block hash: packed coordinate per slot
+    std::vector<int> slotBlocks;    // index into blocks, -1 = empty slot
+    int frames = 0;                 // captures integrated
+
+    // Allocation rays, rebuilt when the image size or calibration changes
+    DepthRays rays;
+    float rayCalibration[14] = {0};
+};
+
+// Drops all blocks
+void resetTsdfVolume(TsdfVolume& volume, const TsdfParams& params = TsdfParams());
+
+// depth: getDepthData (CV_32FC1, mm, z <= 0 invalid). pose: camera ->
+// volume frame (robot flange pose times hand-eye transform, or
+// poseFromExtrinsic for a fixed rig).
+void integrateDepth(TsdfVolume& volume, const cv::Mat& depth, const XEMA::CalibrationParam& calibration,
+                    const cv::Matx44d& pose);
+
+// Marching cubes over all blocks; cubes with a voxel of weight below
+// minWeight are skipped. Blocks run in parallel, output in block order.
+void extractTsdfMesh(const TsdfVolume& volume, TriangleMesh& mesh, float minWeight = 1.0f);
+
+// captureData(1) + getDepthData + getCalibrationParam + integrateDepth.
+// Returns 0 on success, -1 on any SDK error.
+int captureIntoTsdf(XEMA::XCamera* camera, const cv::Matx44d& pose, TsdfVolume& volume);
@@ -0,0 +1,221 @@
+#include "voxel_grid.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <opencv2/core/hal/intrin.hpp>
+#include "voxel_key.h"
+
+// ═══════════════════════════════════════════════════════════════════════
+// Voxel Table
+// ═══════════════════════════════════════════════════════════════════════
+
+namespace {
+
+const int kStripes = 64;
+const int kPartitionBits = 6;
+const int kPartitions = 1 << kPartitionBits;
+
+using voxel_key::voxelHash;
+using voxel_key::voxelIndex;
+using voxel_key::voxelKey;
+
+// Coordinates are summed in double: float sums of many points lose
+// sub-millimetre resolution far from the origin
+struct VoxelSum {
+    uint64_t key;
+    double x, y, z;
+    float c[3];
+    int count;
+};
+
+// Open addressing with linear probing. Slots carry the key next to the
+// index into `sums`, so a probe never touches the sums.
+class VoxelTable {
+public:
+    explicit VoxelTable(size_t expected = 1024) {
+        size_t capacity = 64;
+        while (capacity < 2 * expected) capacity <<= 1;
+        slots_.assign(capacity, Slot{0, -1});
+        sums_.reserve(expected);
+    }
+
+    // Index of the key's sum, created empty when missing; indices stay
+    // valid while the table grows
+    int index(uint64_t key) {
+        if (2 * (sums_.size() + 1) > slots_.size()) grow();
+        const size_t mask = slots_.size() - 1;
+        size_t slot = (voxelHash(key) >> 20) & mask;
+        while (true) {
+            Slot& s = slots_[slot];
+            if (s.index < 0) {
+                s.key = key;
+                s.index = static_cast<int>(sums_.size());
+                sums_.push_back(VoxelSum{key, 0.0, 0.0, 0.0, {0.0f, 0.0f, 0.0f}, 0});
+                return s.index;
+            }
+            if (s.key == key) return s.index;
+            slot = (slot + 1) & mask;
+        }
+    }
+
+    VoxelSum& operator[](int i) { return sums_[i]; }
+    const std::vector<VoxelSum>& sums() const { return sums_; }
+
+private:
+    struct Slot {
+        uint64_t key;
+        int index;
+    };
+
+    void grow() {
+        std::vector<Slot> slots(slots_.size() * 2, Slot{0, -1});
+        const size_t mask = slots.size() - 1;
+        for (const Slot& s : slots_) {
+            if (s.index < 0) continue;
+            size_t slot = (voxelHash(s.key) >> 20) & mask;
+            while (slots[slot].index >= 0) slot = (slot + 1) & mask;
+            slots[slot] = s;
+        }
+        slots_.swap(slots);
+    }
+
+    std::vector<Slot> slots_;
+    std::vector<VoxelSum> sums_;
+};
+
+inline int partitionOf(uint64_t key) {
+    return static_cast<int>(voxelHash(key) >> (64 - kPartitionBits));
+}
+
+}  // namespace
+
+// ═══════════════════════════════════════════════════════════════════════
+// Downsampling
+// ═══════════════════════════════════════════════════════════════════════
+
+void voxelGridDownsample(const cv::Mat& cloud, const cv::Mat& color, VoxelCloud& result, const VoxelGridParams& params) {
+    CV_Assert(cloud.type() == CV_32FC3 && params.voxelSize > 0.0f);
+    CV_Assert(color.empty() || ((color.type() == CV_8UC1 || color.type() == CV_8UC3) && color.size() == cloud.size()));
+    const int channels = color.empty() ? 0 : color.channels();
+    const cv::Rect frame(0, 0, cloud.cols, cloud.rows);
+    const cv::Rect area = params.roi.area() > 0 ? params.roi & frame : frame;
+    const float invVoxel = 1.0f / params.voxelSize;
+
+    // 1. Stripe sums, flushed into per-partition lists
+    const int stripes = std::max(1, std::min(kStripes, area.height));
+    std::vector<std::vector<std::vector<VoxelSum>>> buckets(stripes, std::vector<std::vector<VoxelSum>>(kPartitions));
+
+    cv::parallel_for_(cv::Range(0, stripes), [&](const cv::Range& range) {
+        std::vector<int> ix(area.width + 4), iy(area.width + 4), iz(area.width + 4);
+        for (int s = range.start; s < range.end; s++) {
+            const int y0 = area.y + area.height * s / stripes, y1 = area.y + area.height * (s + 1) / stripes;
+            VoxelTable table(static_cast<size_t>(y1 - y0) * area.width / 8 + 64);
+            std::vector<uint64_t> aboveKey(area.width, ~0ull);
+            std::vector<int> aboveIndex(area.width, -1);
+
+            for (int y = y0; y < y1; y++) {
+                const float* p = cloud.ptr<float>(y) + 3 * area.x;
+                const uchar* c = channels ? color.ptr<uchar>(y) + channels * area.x : nullptr;
+
+                // Voxel indices of the row
+                int x = 0;
+#if CV_SIMD128
+                const cv::v_float32x4 vinv = cv::v_setall_f32(invVoxel);
+                for (; x <= area.width - 4; x += 4) {
+                    cv::v_float32x4 px, py, pz;
+                    cv::v_load_deinterleave(p + 3 * x, px, py, pz);
+                    cv::v_store(&ix[x], cv::v_floor(px * vinv));
+                    cv::v_store(&iy[x], cv::v_floor(py * vinv));
+                    cv::v_store(&iz[x], cv::v_floor(pz * vinv));
+                }
+#endif
+                for (; x < area.width; x++) {
+                    ix[x] = voxelIndex(p[3 * x] * invVoxel);
+                    iy[x] = voxelIndex(p[3 * x + 1] * invVoxel);
+                    iz[x] = voxelIndex(p[3 * x + 2] * invVoxel);
+                }
+
+                // A point mostly shares its voxel with the previous point of
+                // the row or the point above it; the hash is probed otherwise
+                uint64_t lastKey = ~0ull;
+                int last = -1;
+                for (x = 0; x < area.width; x++) {
+                    const float px = p[3 * x], py = p[3 * x + 1], pz = p[3 * x + 2];
+                    if (!(pz > 0.0f) || !std::isfinite(px) || !std::isfinite(py) || !std::isfinite(pz)) continue;
+                    const uint64_t key = voxelKey(ix[x], iy[x], iz[x]);
+                    if (key != lastKey) {
+                        last = key == aboveKey[x] ? aboveIndex[x] : table.index(key);
+                        lastKey = key;
+                    }
+                    aboveKey[x] = key;
+                    aboveIndex[x] = last;
+
+                    VoxelSum& sum = table[last];
+                    sum.x += px;
+                    sum.y += py;
+                    sum.z += pz;
+                    for (int k = 0; k < channels; k++) sum.c[k] += c[channels * x + k];
+                    sum.count++;
+                }
+            }
+
+            for (const VoxelSum& v : table.sums()) buckets[s][partitionOf(v.key)].push_back(v);
+        }
+    });
+
+    // 2. Partition merge, stripes in order
+    std::vector<std::vector<VoxelSum>> merged(kPartitions);
+    cv::parallel_for_(cv::Range(0, kPartitions), [&](const cv::Range& range) {
+        for (int part = range.start; part < range.end; part++) {
+            size_t total = 0;
+            for (int s = 0; s < stripes; s++) total += buckets[s][part].size();
+            VoxelTable table(total / 2 + 64);
+            for (int s = 0; s < stripes; s++) {
+                for (const VoxelSum& v : buckets[s][part]) {
+                    VoxelSum& sum = table[table.index(v.key)];
+                    sum.x += v.x;
+                    sum.y += v.y;
+                    sum.z += v.z;
+                    for (int k = 0; k < 3; k++) sum.c[k] += v.c[k];
+                    sum.count += v.count;
+                }
+                std::vector<VoxelSum>().swap(buckets[s][part]);
+            }
+            merged[part].clear();
+            for (const VoxelSum& v : table.sums()) {
+                if (v.count >= params.minPoints) merged[part].push_back(v);
+            }
+        }
+    });
+
+    // 3. Averages
+    std::vector<int> offsets(kPartitions + 1, 0);
+    for (int part = 0; part < kPartitions; part++) offsets[part + 1] = offsets[part] + static_cast<int>(merged[part].size());
+    const int n = offsets[kPartitions];
+
+    result.points.create(n, 1, CV_32FC3);
+    result.counts.create(n, 1, CV_32SC1);
+    if (channels) result.colors.create(n, 1, CV_8UC(channels));
+    else result.colors.release();
+    if (n == 0) return;
+
+    cv::parallel_for_(cv::Range(0, kPartitions), [&](const cv::Range& range) {
+        for (int part = range.start; part < range.end; part++) {
+            for (size_t i = 0; i < merged[part].size(); i++) {
+                const VoxelSum& v = merged[part][i];
+                const int row = offsets[part] + static_cast<int>(i);
+                const float inv = 1.0f / v.count;
+                float* p = result.points.ptr<float>(row);
+                p[0] = static_cast<float>(v.x / v.count);
+                p[1] = static_cast<float>(v.y / v.count);
+                p[2] = static_cast<float>(v.z / v.count);
+                result.counts.at<int>(row) = v.count;
+                if (channels) {
+                    uchar* c = result.colors.ptr<uchar>(row);
+                    for (int k = 0; k < channels; k++) c[k] = cv::saturate_cast<uchar>(v.c[k] * inv);
+                }
+            }
+        }
+    });
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <opencv2/core.hpp>
+
+// ═══════════════════════════════════════════════════════════════════════
+// Voxel Grid Downsampling
+// ═══════════════════════════════════════════════════════════════════════
+//
+// Averages an organized getPointcloudData buffer (CV_32FC3, z <= 0
+// invalid) over a cubic voxel grid, XYZ and color in the same pass.
+// Invalid points are skipped in place, no compacted copy is made.
+//
+//   1. The rows are split into fixed stripes; each stripe sums its points
+//      into a private open-addressing hash table keyed by the voxel index.
+//      Neighboring pixels mostly share voxels, so the tables stay small.
+//   2. The stripe tables are split by key hash into partitions, and the
+//      partitions are merged in parallel, each into its own table.
+//   3. Partition sizes are prefix-summed and the averages written out.
+//
+// Stripes and partitions are fixed in number and merged in order, so the
+// output is identical for any thread count.
+
+struct VoxelGridParams {
+    cv::Rect roi;               // points taken from this region; empty = whole frame
+    float voxelSize = 1.5f;     // mm
+    int minPoints = 1;          // voxels with fewer points are dropped
+};
+
+struct VoxelCloud {
+    cv::Mat points;             // N x 1 CV_32FC3, voxel centroids
+    cv::Mat colors;             // N x 1 CV_8UC1 / CV_8UC3 mean color, empty without color input
+    cv::Mat counts;             // N x 1 CV_32SC1, points per voxel
+};
+
+// cloud: CV_32FC3. color (optional): CV_8UC1 or CV_8UC3 of the same size
+// (getBrightnessData / getColorBrightnessData), channels averaged as given.
+void voxelGridDownsample(const cv::Mat& cloud, const cv::Mat& color, VoxelCloud& result,
+                         const VoxelGridParams& params = VoxelGridParams());
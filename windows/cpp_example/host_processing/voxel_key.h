@@ -0,0 +1,44 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <opencv2/core.hpp>
+
+// ═══════════════════════════════════════════════════════════════════════
+// Packed Voxel Keys (internal)
+// ═══════════════════════════════════════════════════════════════════════
+//
+// Shared by voxel_grid, cloud_fusion and tsdf: integer voxel (or block)
+// coordinates packed into one 64-bit hash key, 21 bits per axis, biased so
+// negative coordinates stay positive. Coordinates outside
+// [-2^20, 2^20) wrap.
+
+namespace voxel_key {
+
+const int kKeyBits = 21;
+const int kKeyBias = 1 << (kKeyBits - 1);
+const uint64_t kKeyMask = (1ull << kKeyBits) - 1;
+
+// floor(v) for finite v in int range; 0 otherwise (converting NaN or Inf
+// is undefined, and such points are rejected before their key is used)
+inline int voxelIndex(float v) {
+    return std::isfinite(v) && std::fabs(v) < 1e9f ? static_cast<int>(std::floor(v)) : 0;
+}
+
+inline uint64_t voxelKey(int ix, int iy, int iz) {
+    return ((static_cast<uint64_t>(ix + kKeyBias) & kKeyMask) << (2 * kKeyBits)) |
+           ((static_cast<uint64_t>(iy + kKeyBias) & kKeyMask) << kKeyBits) |
+           (static_cast<uint64_t>(iz + kKeyBias) & kKeyMask);
+}
+
+inline cv::Vec3i voxelCoord(uint64_t key) {
+    return cv::Vec3i(static_cast<int>((key >> (2 * kKeyBits)) & kKeyMask) - kKeyBias,
+                     static_cast<int>((key >> kKeyBits) & kKeyMask) - kKeyBias,
+                     static_cast<int>(key & kKeyMask) - kKeyBias);
+}
+
+// Fibonacci hashing: use the high bits
+inline uint64_t voxelHash(uint64_t key) {
+    return key * 0x9E3779B97F4A7C15ull;
+}
+
+} // namespace voxel_key
@@ -0,0 +1,363 @@
+#include "circle_grid.h"
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <deque>
+#include <map>
+#include <utility>
+#include <opencv2/imgproc.hpp>
+
+// ═══════════════════════════════════════════════════════════════════════
+// Blob Extraction
+// ═══════════════════════════════════════════════════════════════════════
+
+struct BlobCandidate {
+    int label;
+    cv::Rect box;
+    int area;
+    cv::Point2f center;
+    float radius;
+    bool valid;
+};
+
+static void binarize(const cv::Mat& image, const CircleGridParams& params, cv::Mat& binary) {
+    int type = params.darkDots ? cv::THRESH_BINARY_INV : cv::THRESH_BINARY;
+    if (params.adaptiveBlockSize > 1) {
+        cv::adaptiveThreshold(image, binary, 255, cv::ADAPTIVE_THRESH_MEAN_C, type,
+                              params.adaptiveBlockSize | 1, 5);
+    } else {
+        cv::threshold(image, binary, 0, 255, type | cv::THRESH_OTSU);
+    }
+}
+
+// Validates one blob with an ellipse fit of its boundary and computes a
+// gray-level weighted centroid, which uses the anti-aliased edge pixels.
+static void refineBlob(const cv::Mat& image, const cv::Mat& labels, const CircleGridParams& params,
+                       BlobCandidate& blob) {
+    const int label = blob.label;
+    const cv::Rect& box = blob.box;
+
+    std::vector<cv::Point> boundary;
+    for (int y = box.y; y < box.y + box.height; y++) {
+        const int* row = labels.ptr<int>(y);
+        const int* up = y > 0 ? labels.ptr<int>(y - 1) : nullptr;
+        const int* down = y + 1 < labels.rows ? labels.ptr<int>(y + 1) : nullptr;
+        for (int x = box.x; x < box.x + box.width; x++) {
+            if (row[x] != label) continue;
+            bool edge = !up || !down || x == 0 || x + 1 == labels.cols ||
+                        row[x - 1] != label || row[x + 1] != label || up[x] != label || down[x] != label;
+            if (edge) boundary.push_back(cv::Point(x, y));
+        }
+    }
+    if (boundary.size() < 6) return;
+
+    cv::RotatedRect ellipse = cv::fitEllipse(boundary);
+    float major = std::max(ellipse.size.width, ellipse.size.height) * 0.5f;
+    float minor = std::min(ellipse.size.width, ellipse.size.height) * 0.5f;
+    if (!(minor > 0.5f) || major / minor > params.maxAxisRatio) return;
+
+    // Boundary pixel centers lie half a pixel inside the true edge
+    double ellipseArea = CV_PI * (major + 0.5) * (minor + 0.5);
+    if (std::abs(ellipseArea - blob.area) > 0.35 * ellipseArea + 4.0) return;
+
+    // Dot and board gray levels around the blob; other blobs are excluded
+    const float outerRadius = major * 1.5f + 2.0f;
+    const float weightRadius = major * 1.3f + 1.0f;
+    int r = cvCeil(outerRadius);
+    cv::Rect window = cv::Rect(cvFloor(ellipse.center.x) - r, cvFloor(ellipse.center.y) - r, 2 * r + 2, 2 * r + 2)
+                    & cv::Rect(0, 0, image.cols, image.rows);
+
+    double inner = 0.0, outer = 0.0;
+    int innerCount = 0, outerCount = 0;
+    for (int y = window.y; y < window.y + window.height; y++) {
+        const uchar* img = image.ptr<uchar>(y);
+        const int* lab = labels.ptr<int>(y);
+        float dy = y - ellipse.center.y;
+        for (int x = window.x; x < window.x + window.width; x++) {
+            if (lab[x] == label) {
+                inner += img[x];
+                innerCount++;
+            } else if (lab[x] == 0) {
+                float dx = x - ellipse.center.x;
+                float d2 = dx * dx + dy * dy;
+                if (d2 > weightRadius * weightRadius && d2 <= outerRadius * outerRadius) {
+                    outer += img[x];
+                    outerCount++;
+                }
+            }
+        }
+    }
+    if (innerCount == 0 || outerCount == 0) return;
+    inner /= innerCount;
+    outer /= outerCount;
+    if (std::abs(outer - inner) < 10.0) return;
+
+    // Weight = fraction of "dot" in each pixel, works for dark and bright dots
+    const float scale = static_cast<float>(1.0 / (outer - inner));
+    const float level = static_cast<float>(outer);
+    double sw = 0.0, sx = 0.0, sy = 0.0;
+    for (int y = window.y; y < window.y + window.height; y++) {
+        const uchar* img = image.ptr<uchar>(y);
+        const int* lab = labels.ptr<int>(y);
+        float dy = y - ellipse.center.y;
+        for (int x = window.x; x < window.x + window.width; x++) {
+            if (lab[x] != label && lab[x] != 0) continue;
+            float dx = x - ellipse.center.x;
+            if (dx * dx + dy * dy > weightRadius * weightRadius) continue;
+            float w = std::min(std::max((level - img[x]) * scale, 0.0f), 1.0f);
+            sw += w;
+            sx += w * x;
+            sy += w * y;
+        }
+    }
+    if (sw <= 0.0) return;
+
+    blob.center = cv::Point2f(static_cast<float>(sx / sw), static_cast<float>(sy / sw));
+    blob.radius = 0.5f * (major + minor) + 0.5f;
+    blob.valid = true;
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Grid Ordering
+// ═══════════════════════════════════════════════════════════════════════
+
+// Assigns (col, row) cells to dots by growing from a central seed along
+// the two grid axes. The axes are re-estimated locally at every step, so
+// perspective distortion does not accumulate. Growth is repeated from
+// the remaining dots, so boards at different depths form separate grids.
+// Returns the grid index of every dot, -1 for dots outside any grid.
+static std::vector<int> orderGrids(const std::vector<cv::Point2f>& pts, const std::vector<float>& radii,
+                                   std::vector<cv::Point>& cells) {
+    const int n = static_cast<int>(pts.size());
+    std::vector<int> grid(n, -1);
+    cells.assign(n, cv::Point(0, 0));
+    if (n < 4) return grid;
+
+    // k nearest neighbors (boards have at most a few hundred dots)
+    const int K = std::min(8, n - 1);
+    std::vector<std::vector<int>> knn(n);
+    std::vector<float> nearest(n);
+    cv::parallel_for_(cv::Range(0, n), [&](const cv::Range& range) {
+        std::vector<std::pair<float, int>> dist(n);
+        for (int i = range.start; i < range.end; i++) {
+            for (int j = 0; j < n; j++) {
+                cv::Point2f d = pts[j] - pts[i];
+                dist[j] = std::make_pair(i == j ? FLT_MAX : d.x * d.x + d.y * d.y, j);
+            }
+            std::partial_sort(dist.begin(), dist.begin() + K, dist.end());
+            knn[i].resize(K);
+            for (int k = 0; k < K; k++) knn[i][k] = dist[k].second;
+            nearest[i] = std::sqrt(dist[0].first);
+        }
+    });
+
+    // Board rotation from the 4-fold symmetric angle of the neighbor vectors
+    double c4 = 0.0, s4 = 0.0;
+    for (int i = 0; i < n; i++) {
+        for (int j : knn[i]) {
+            cv::Point2f d = pts[j] - pts[i];
+            if (cv::norm(d) > 1.5 * nearest[i]) continue;
+            double theta = std::atan2(d.y, d.x);
+            c4 += std::cos(4.0 * theta);
+            s4 += std::sin(4.0 * theta);
+        }
+    }
+    const double phi = std::atan2(s4, c4) / 4.0;
+    const cv::Point2f dirU(static_cast<float>(std::cos(phi)), static_cast<float>(std::sin(phi)));
+    const cv::Point2f dirV(-dirU.y, dirU.x);
+
+    const int stepCol[4] = { 1, -1, 0, 0 };
+    const int stepRow[4] = { 0, 0, 1, -1 };
+    std::vector<cv::Point2f> localU(n), localV(n);
+    std::vector<bool> tried(n, false);
+    int numGrids = 0;
+
+    while (true) {
+        // Seed at the untried dot closest to the centroid of the untried dots
+        cv::Point2f mean(0.0f, 0.0f);
+        int remaining = 0;
+        for (int i = 0; i < n; i++) {
+            if (tried[i]) continue;
+            mean += pts[i];
+            remaining++;
+        }
+        if (remaining < 4) break;
+        mean *= 1.0f / remaining;
+        int seed = -1;
+        for (int i = 0; i < n; i++) {
+            if (tried[i]) continue;
+            if (seed < 0 || cv::norm(pts[i] - mean) < cv::norm(pts[seed] - mean)) seed = i;
+        }
+
+        std::vector<int> members(1, seed);
+        std::map<std::pair<int, int>, int> occupied;
+        std::deque<int> queue(1, seed);
+        localU[seed] = dirU * nearest[seed];
+        localV[seed] = dirV * nearest[seed];
+        cells[seed] = cv::Point(0, 0);
+        grid[seed] = numGrids;
+        tried[seed] = true;
+        occupied[std::make_pair(0, 0)] = seed;
+
+        while (!queue.empty()) {
+            int p = queue.front();
+            queue.pop_front();
+            for (int k = 0; k < 4; k++) {
+                cv::Point2f delta = k < 2 ? localU[p] * static_cast<float>(stepCol[k])
+                                          : localV[p] * static_cast<float>(stepRow[k]);
+                cv::Point cell(cells[p].x + stepCol[k], cells[p].y + stepRow[k]);
+                if (occupied.count(std::make_pair(cell.x, cell.y))) continue;
+
+                cv::Point2f predicted = pts[p] + delta;
+                float bestDist = 0.35f * static_cast<float>(cv::norm(delta));
+                int best = -1;
+                for (int q : knn[p]) {
+                    if (grid[q] >= 0) continue;
+                    float ratio = radii[q] / radii[p];
+                    if (ratio < 0.67f || ratio > 1.5f) continue;
+                    float d = static_cast<float>(cv::norm(pts[q] - predicted));
+                    if (d < bestDist) {
+                        bestDist = d;
+                        best = q;
+                    }
+                }
+                if (best < 0) continue;
+
+                cv::Point2f actual = pts[best] - pts[p];
+                localU[best] = k < 2 ? actual * static_cast<float>(stepCol[k]) : localU[p];
+                localV[best] = k < 2 ? localV[p] : actual * static_cast<float>(stepRow[k]);
+                cells[best] = cell;
+                grid[best] = numGrids;
+                tried[best] = true;
+                occupied[std::make_pair(cell.x, cell.y)] = best;
+                members.push_back(best);
+                queue.push_back(best);
+            }
+        }
+
+        if (members.size() < 4) {
+            for (int m : members) grid[m] = -1;
+        } else {
+            numGrids++;
+        }
+    }
+
+    return grid;
+}
+
+static CircleGridResult collectGrid(const std::vector<cv::Point2f>& pts, const std::vector<float>& radii,
+                                    const std::vector<cv::Point>& cells, const std::vector<int>& grid,
+                                    int gridIndex, const CircleGridParams& params) {
+    CircleGridResult result;
+
+    int minCol = INT_MAX, minRow = INT_MAX, maxCol = INT_MIN, maxRow = INT_MIN;
+    for (size_t i = 0; i < pts.size(); i++) {
+        if (grid[i] != gridIndex) continue;
+        minCol = std::min(minCol, cells[i].x);
+        minRow = std::min(minRow, cells[i].y);
+        maxCol = std::max(maxCol, cells[i].x);
+        maxRow = std::max(maxRow, cells[i].y);
+    }
+    if (minCol == INT_MAX) return result;
+
+    int cols = maxCol - minCol + 1;
+    int rows = maxRow - minRow + 1;
+    bool rotate = params.patternSize.area() > 0 && cols != params.patternSize.width &&
+                  cols == params.patternSize.height && rows == params.patternSize.width;
+
+    for (size_t i = 0; i < pts.size(); i++) {
+        if (grid[i] != gridIndex) continue;
+        CircleGridDot dot;
+        dot.center = pts[i];
+        dot.radius = radii[i];
+        dot.col = cells[i].x - minCol;
+        dot.row = cells[i].y - minRow;
+        if (rotate) {
+            // Board seen rotated by 90 degrees
+            int col = dot.col;
+            dot.col = dot.row;
+            dot.row = cols - 1 - col;
+        }
+        result.dots.push_back(dot);
+    }
+    if (rotate) std::swap(cols, rows);
+
+    std::sort(result.dots.begin(), result.dots.end(), [](const CircleGridDot& a, const CircleGridDot& b) {
+        return a.row != b.row ? a.row < b.row : a.col < b.col;
+    });
+
+    result.cols = cols;
+    result.rows = rows;
+    result.complete = static_cast<int>(result.dots.size()) == cols * rows &&
+                      (params.patternSize.area() == 0 ||
+                       (cols == params.patternSize.width && rows == params.patternSize.height));
+    return result;
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Detector
+// ═══════════════════════════════════════════════════════════════════════
+
+std::vector<CircleGridResult> detectCircleGrids(const cv::Mat& image, const CircleGridParams& params) {
+    std::vector<CircleGridResult> results;
+    CV_Assert(image.type() == CV_8UC1);
+
+    // 1. Single-pass blob extraction
+    cv::Mat binary, labels, stats, centroids;
+    binarize(image, params, binary);
+    int numLabels = cv::connectedComponentsWithStats(binary, labels, stats, centroids, 8, CV_32S);
+
+    std::vector<BlobCandidate> blobs;
+    for (int i = 1; i < numLabels; i++) {
+        const int* s = stats.ptr<int>(i);
+        int area = s[cv::CC_STAT_AREA];
+        int w = s[cv::CC_STAT_WIDTH];
+        int h = s[cv::CC_STAT_HEIGHT];
+        if (area < params.minArea || area > params.maxArea) continue;
+        float fill = static_cast<float>(area) / (w * h);
+        if (fill < params.minFillRatio || fill > 0.95f) continue;
+
+        BlobCandidate blob;
+        blob.label = i;
+        blob.box = cv::Rect(s[cv::CC_STAT_LEFT], s[cv::CC_STAT_TOP], w, h);
+        blob.area = area;
+        blob.radius = 0.0f;
+        blob.valid = false;
+        blobs.push_back(blob);
+    }
+    if (blobs.size() < 4) return results;
+
+    // 2. Parallel ellipse validation and sub-pixel centers
+    cv::parallel_for_(cv::Range(0, static_cast<int>(blobs.size())), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; i++) {
+            refineBlob(image, labels, params, blobs[i]);
+        }
+    });
+
+    std::vector<cv::Point2f> pts;
+    std::vector<float> radii;
+    for (const auto& blob : blobs) {
+        if (!blob.valid) continue;
+        pts.push_back(blob.center);
+        radii.push_back(blob.radius);
+    }
+
+    // 3. Grid ordering
+    std::vector<cv::Point> cells;
+    std::vector<int> grid = orderGrids(pts, radii, cells);
+    int numGrids = grid.empty() ? 0 : *std::max_element(grid.begin(), grid.end()) + 1;
+
+    for (int g = 0; g < numGrids; g++) {
+        results.push_back(collectGrid(pts, radii, cells, grid, g, params));
+    }
+    std::stable_sort(results.begin(), results.end(), [](const CircleGridResult& a, const CircleGridResult& b) {
+        return a.dots.size() > b.dots.size();
+    });
+    return results;
+}
+
+CircleGridResult detectCircleGrid(const cv::Mat& image, const CircleGridParams& params) {
+    std::vector<CircleGridResult> grids = detectCircleGrids(image, params);
+    return grids.empty() ? CircleGridResult() : grids.front();
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <vector>
+#include <opencv2/core.hpp>
+
+// ═══════════════════════════════════════════════════════════════════════
+// Circle-Grid Calibration Board Detector
+// ═══════════════════════════════════════════════════════════════════════
+//
+// Single-pass blob extraction with connected components, parallel
+// ellipse validation and gray-level sub-pixel centers, then ordering of
+// the blobs into grid rows and columns by local neighbor propagation
+// (tolerates perspective). Boards at different depths are returned as
+// separate grids.
+
+struct CircleGridParams {
+    cv::Size patternSize = cv::Size(0, 0);  // columns x rows; (0, 0) accepts any grid
+    bool darkDots = true;                   // black dots on a white board
+    int adaptiveBlockSize = 0;              // 0: global Otsu, otherwise adaptive threshold block (odd)
+    int minArea = 20;                       // blob area limits (pixels)
+    int maxArea = 40000;
+    float minFillRatio = 0.6f;              // blob area / bounding-box area (ellipse ~0.785)
+    float maxAxisRatio = 3.0f;              // fitted ellipse major / minor
+};
+
+struct CircleGridDot {
+    cv::Point2f center;     // sub-pixel center
+    float radius;           // mean ellipse semi-axis
+    int row;
+    int col;
+};
+
+struct CircleGridResult {
+    std::vector<CircleGridDot> dots;    // row-major order
+    int rows = 0;
+    int cols = 0;
+    bool complete = false;              // every grid position found (and matches patternSize)
+};
+
+// image must be CV_8UC1. Returns the largest grid.
+CircleGridResult detectCircleGrid(const cv::Mat& image, const CircleGridParams& params = CircleGridParams());
+
+// Every grid in the image (e.g. one board per plane), largest first.
+std::vector<CircleGridResult> detectCircleGrids(const cv::Mat& image, const CircleGridParams& params = CircleGridParams());
@@ -0,0 +1,289 @@
+#include "marker_localization.h"
+#include <cmath>
+#include <opencv2/core/hal/intrin.hpp>
+
+// ═══════════════════════════════════════════════════════════════════════
+// Neighborhood Gathering
+// ═══════════════════════════════════════════════════════════════════════
+
+// Copies one row segment of the depth map into a float buffer.
+static void gatherRow(const cv::Mat& depthMap, int y, int x0, int count, float* dst) {
+    int k = 0;
+    if (depthMap.type() == CV_16UC1) {
+        const unsigned short* src = depthMap.ptr<unsigned short>(y) + x0;
+#if CV_SIMD128
+        for (; k <= count - 4; k += 4) {
+            cv::v_uint32x4 raw = cv::v_load_expand(src + k);
+            cv::v_store(dst + k, cv::v_cvt_f32(cv::v_reinterpret_as_s32(raw)));
+        }
+#endif
+        for (; k < count; k++) dst[k] = src[k];
+    } else {
+        const float* src = depthMap.ptr<float>(y) + x0;
+#if CV_SIMD128
+        for (; k <= count - 4; k += 4) {
+            cv::v_store(dst + k, cv::v_load(src + k));
+        }
+#endif
+        for (; k < count; k++) dst[k] = src[k];
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Moment Accumulation
+// ═══════════════════════════════════════════════════════════════════════
+
+// Monomials u^a * v^b of the local surface, in coefficient order.
+static const int kMonomials[6][2] = { {0, 0}, {1, 0}, {0, 1}, {2, 0}, {1, 1}, {0, 2} };
+
+struct SurfaceMoments {
+    double m[5][5];     // sum of u^a * v^b over valid pixels, a + b <= 4
+    double z[3][3];     // sum of u^a * v^b * z over valid pixels, a + b <= 2 (z relative to zRef)
+    double zz;          // sum of z^2 (z relative to zRef)
+    int count;
+};
+
+struct SurfaceFit {
+    double coef[6];
+    int numCoef;
+    int support;
+    double rms;
+    bool ok;
+};
+
+static float evaluateSurface(const SurfaceFit& fit, float u, float v) {
+    const float terms[6] = { 1.0f, u, v, u * u, u * v, v * v };
+    float z = 0.0f;
+    for (int i = 0; i < fit.numCoef; i++) z += static_cast<float>(fit.coef[i]) * terms[i];
+    return z;
+}
+
+// Accumulates the moments of one gathered window, depth taken relative to
+// zRef so z^2 stays small against the float lane sums. When `gate` is
+// given, only pixels within `threshold` of that surface contribute.
+static SurfaceMoments accumulateMoments(const float* window, int rows, int cols,
+                                        float u0, float v0, float invRadius, float zRef,
+                                        const SurfaceFit* gate, float threshold) {
+    SurfaceMoments mom = {};
+
+    float g[6] = { 0, 0, 0, 0, 0, 0 };
+    if (gate) {
+        for (int i = 0; i < gate->numCoef; i++) g[i] = static_cast<float>(gate->coef[i]);
+    }
+
+    for (int r = 0; r < rows; r++) {
+        const float* zrow = window + r * cols;
+        const float v = v0 + r * invRadius;
+
+        // Row sums: s[k] = sum u^k (k <= 4), t[k] = sum u^k z (k <= 2)
+        double s[5] = { 0, 0, 0, 0, 0 };
+        double t[3] = { 0, 0, 0 };
+        double zz = 0.0;
+
+        // Per-row part of the gate surface: z = ga + gb*u + gc*u^2
+        const float ga = g[0] + g[2] * v + g[5] * v * v;
+        const float gb = g[1] + g[4] * v;
+        const float gc = g[3];
+
+        int c = 0;
+#if CV_SIMD128
+        const cv::v_float32x4 zero = cv::v_setzero_f32();
+        const cv::v_float32x4 one = cv::v_setall_f32(1.0f);
+        const cv::v_float32x4 step = cv::v_setall_f32(4.0f * invRadius);
+        const cv::v_float32x4 vga = cv::v_setall_f32(ga), vgb = cv::v_setall_f32(gb), vgc = cv::v_setall_f32(gc);
+        const cv::v_float32x4 vthr = cv::v_setall_f32(threshold);
+        const cv::v_float32x4 vref = cv::v_setall_f32(zRef);
+        cv::v_float32x4 vu(u0, u0 + invRadius, u0 + 2.0f * invRadius, u0 + 3.0f * invRadius);
+        cv::v_float32x4 s0 = zero, s1 = zero, s2 = zero, s3 = zero, s4 = zero;
+        cv::v_float32x4 t0 = zero, t1 = zero, t2 = zero, q = zero;
+
+        for (; c <= cols - 4; c += 4) {
+            cv::v_float32x4 vz = cv::v_load(zrow + c);
+            cv::v_float32x4 mask = vz > zero;   // false for zero and NaN
+            vz -= vref;
+            cv::v_float32x4 u2 = vu * vu;
+            if (gate) {
+                cv::v_float32x4 pred = cv::v_muladd(vgc, u2, cv::v_muladd(vgb, vu, vga));
+                mask = mask & (cv::v_abs(vz - pred) < vthr);
+            }
+            cv::v_float32x4 w = cv::v_select(mask, one, zero);
+            cv::v_float32x4 wz = cv::v_select(mask, vz, zero);
+            cv::v_float32x4 wu = w * vu;
+            cv::v_float32x4 wzu = wz * vu;
+            s0 += w;
+            s1 += wu;
+            s2 += wu * vu;
+            s3 += wu * u2;
+            s4 = cv::v_muladd(w * u2, u2, s4);
+            t0 += wz;
+            t1 += wzu;
+            t2 = cv::v_muladd(wzu, vu, t2);
+            q = cv::v_muladd(wz, vz, q);
+            vu += step;
+        }
+        // Lanes hold a few pixels each; the window sums are kept in double
+        s[0] = cv::v_reduce_sum(s0); s[1] = cv::v_reduce_sum(s1); s[2] = cv::v_reduce_sum(s2);
+        s[3] = cv::v_reduce_sum(s3); s[4] = cv::v_reduce_sum(s4);
+        t[0] = cv::v_reduce_sum(t0); t[1] = cv::v_reduce_sum(t1); t[2] = cv::v_reduce_sum(t2);
+        zz = cv::v_reduce_sum(q);
+#endif
+        for (; c < cols; c++) {
+            if (!(zrow[c] > 0.0f)) continue;
+            const float z = zrow[c] - zRef;
+            const float u = u0 + c * invRadius;
+            if (gate && std::abs(z - (ga + gb * u + gc * u * u)) >= threshold) continue;
+            const double u2 = static_cast<double>(u) * u;
+            s[0] += 1.0; s[1] += u; s[2] += u2; s[3] += u2 * u; s[4] += u2 * u2;
+            t[0] += z; t[1] += z * u; t[2] += z * u2;
+            zz += static_cast<double>(z) * z;
+        }
+
+        // Fold the row into the 2D moments with powers of v
+        double vp[5] = { 1.0, v, 0.0, 0.0, 0.0 };
+        for (int b = 2; b < 5; b++) vp[b] = vp[b - 1] * v;
+        for (int a = 0; a < 5; a++) {
+            for (int b = 0; a + b < 5; b++) mom.m[a][b] += s[a] * vp[b];
+        }
+        for (int a = 0; a < 3; a++) {
+            for (int b = 0; a + b < 3; b++) mom.z[a][b] += t[a] * vp[b];
+        }
+        mom.zz += zz;
+        mom.count += cvRound(s[0]);
+    }
+
+    return mom;
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Least-Squares Surface Fit
+// ═══════════════════════════════════════════════════════════════════════
+
+static SurfaceFit solveSurface(const SurfaceMoments& mom, int numCoef) {
+    SurfaceFit fit = {};
+    fit.numCoef = numCoef;
+    fit.support = mom.count;
+    if (mom.count < 2 * numCoef) return fit;
+
+    cv::Mat A(numCoef, numCoef, CV_64F);
+    cv::Mat b(numCoef, 1, CV_64F);
+    for (int i = 0; i < numCoef; i++) {
+        for (int j = 0; j < numCoef; j++) {
+            A.at<double>(i, j) = mom.m[kMonomials[i][0] + kMonomials[j][0]][kMonomials[i][1] + kMonomials[j][1]];
+        }
+        b.at<double>(i) = mom.z[kMonomials[i][0]][kMonomials[i][1]];
+    }
+
+    cv::Mat x;
+    if (!cv::solve(A, b, x, cv::DECOMP_CHOLESKY)) return fit;
+
+    // Residual sum of squares from the moments: zz - 2 x.b + x'Ax
+    double rss = mom.zz;
+    for (int i = 0; i < numCoef; i++) {
+        fit.coef[i] = x.at<double>(i);
+        rss -= 2.0 * fit.coef[i] * b.at<double>(i);
+        for (int j = 0; j < numCoef; j++) rss += fit.coef[i] * A.at<double>(i, j) * x.at<double>(j);
+    }
+    fit.rms = std::sqrt(std::max(rss, 0.0) / mom.count);
+    fit.ok = std::isfinite(fit.coef[0]);
+    return fit;
+}
+
+static SurfaceFit fitSurface(const SurfaceMoments& mom, LocalSurfaceModel model) {
+    if (model == LocalSurfaceModel::Quadric) {
+        SurfaceFit fit = solveSurface(mom, 6);
+        if (fit.ok) return fit;
+    }
+    return solveSurface(mom, 3);
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Marker Localization
+// ═══════════════════════════════════════════════════════════════════════
+
+static MarkerLocation invalidLocation(const cv::Point2f& center, const MarkerLocalizationParams& params) {
+    MarkerLocation loc;
+    loc.position = cv::Point3f(center.x, center.y, 0.0f);
+    loc.support = 0;
+    loc.rms = 0.0f;
+    loc.model = params.model;
+    loc.valid = false;
+    return loc;
+}
+
+static MarkerLocation localizeMarker(const cv::Point2f& center, const cv::Mat& depthMap,
+                                     const MarkerLocalizationParams& params) {
+    MarkerLocation loc = invalidLocation(center, params);
+
+    const int radius = std::max(params.windowRadius, 1);
+    const int cx = cvRound(center.x);
+    const int cy = cvRound(center.y);
+    cv::Rect window = cv::Rect(cx - radius, cy - radius, 2 * radius + 1, 2 * radius + 1)
+                    & cv::Rect(0, 0, depthMap.cols, depthMap.rows);
+    if (window.area() == 0) return loc;
+
+    std::vector<float> buffer(window.area());
+    for (int r = 0; r < window.height; r++) {
+        gatherRow(depthMap, window.y + r, window.x, window.width, &buffer[r * window.width]);
+    }
+
+    // Mean valid depth: the moments are taken relative to it
+    double sum = 0.0;
+    int valid = 0;
+    for (float z : buffer) {
+        if (!(z > 0.0f)) continue;
+        sum += z;
+        valid++;
+    }
+    if (valid == 0) return loc;
+    const float zRef = static_cast<float>(sum / valid);
+
+    const float invRadius = 1.0f / radius;
+    const float u0 = (window.x - center.x) * invRadius;
+    const float v0 = (window.y - center.y) * invRadius;
+
+    // Pass 1: fit all valid pixels
+    SurfaceMoments mom = accumulateMoments(buffer.data(), window.height, window.width,
+                                           u0, v0, invRadius, zRef, nullptr, 0.0f);
+    SurfaceFit fit = fitSurface(mom, params.model);
+    if (!fit.ok) return loc;
+
+    // Pass 2: refit on inliers of the first surface (drops flying pixels at ring edges)
+    SurfaceMoments inlierMom = accumulateMoments(buffer.data(), window.height, window.width,
+                                                 u0, v0, invRadius, zRef, &fit, params.inlierThreshold);
+    if (inlierMom.count >= params.minValidPoints) {
+        SurfaceFit refit = fitSurface(inlierMom, params.model);
+        if (refit.ok) fit = refit;
+    }
+
+    const float z = zRef + evaluateSurface(fit, 0.0f, 0.0f);
+    if (fit.support < params.minValidPoints || !(z > 0.0f)) return loc;
+
+    loc.position.z = z;
+    loc.support = fit.support;
+    loc.rms = static_cast<float>(fit.rms);
+    loc.model = fit.numCoef == 6 ? LocalSurfaceModel::Quadric : LocalSurfaceModel::Plane;
+    loc.valid = true;
+    return loc;
+}
+
+std::vector<MarkerLocation> localizeMarkers(const std::vector<cv::Point2f>& centers,
+                                            const cv::Mat& depthMap,
+                                            const MarkerLocalizationParams& params) {
+    std::vector<MarkerLocation> locations(centers.size());
+    if (centers.empty()) return locations;
+
+    // Other depth types carry no usable depth: every marker is left invalid,
+    // and the caller falls back to its plane equation
+    if (depthMap.type() != CV_16UC1 && depthMap.type() != CV_32FC1) {
+        for (size_t i = 0; i < centers.size(); i++) locations[i] = invalidLocation(centers[i], params);
+        return locations;
+    }
+
+    cv::parallel_for_(cv::Range(0, static_cast<int>(centers.size())), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; i++) {
+            locations[i] = localizeMarker(centers[i], depthMap, params);
+        }
+    });
+
+    return locations;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <vector>
+#include <opencv2/core.hpp>
+
+// ═══════════════════════════════════════════════════════════════════════
+// Sub-pixel 3D Marker Localization
+// ═══════════════════════════════════════════════════════════════════════
+//
+// Fits a local surface z = f(u, v) to the valid depth around each marker
+// center and evaluates it at the sub-pixel center, instead of reading the
+// single depth pixel at cvRound(center).
+//
+// u, v are pixel offsets from the center scaled by 1 / windowRadius, so
+// the fitted value at the center is simply the constant term.
+
+enum class LocalSurfaceModel {
+    Plane = 0,      // z = a + b*u + c*v
+    Quadric = 1,    // z = a + b*u + c*v + d*u^2 + e*u*v + f*v^2
+};
+
+struct MarkerLocalizationParams {
+    int windowRadius = 7;                           // neighborhood half-size (pixels)
+    LocalSurfaceModel model = LocalSurfaceModel::Quadric;
+    int minValidPoints = 12;                        // below this the marker is rejected
+    float inlierThreshold = 2.0f;                   // refit gate on |residual| (depth units)
+};
+
+struct MarkerLocation {
+    cv::Point3f position;   // (sub-pixel x, sub-pixel y, fitted depth)
+    int support;            // valid pixels used by the final fit
+    float rms;              // RMS residual of the final fit
+    LocalSurfaceModel model;// model actually used (quadric falls back to plane)
+    bool valid;
+};
+
+// Depth map CV_16UC1 or CV_32FC1; zero and NaN are invalid. Other types
+// return every marker invalid.
+// Markers are processed in parallel; result[i] corresponds to centers[i].
+std::vector<MarkerLocation> localizeMarkers(const std::vector<cv::Point2f>& centers,
+                                            const cv::Mat& depthMap,
+                                            const MarkerLocalizationParams& params = MarkerLocalizationParams());
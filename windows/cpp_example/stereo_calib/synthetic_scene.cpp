@@ -0,0 +1,141 @@
+#include "synthetic_scene.h"
+#include <cmath>
+#include <opencv2/imgproc.hpp>
+
+// ═══════════════════════════════════════════════════════════════════════
+// Ground Truth Geometry
+// ═══════════════════════════════════════════════════════════════════════
+
+// z = z0 + tiltX * x + tiltY * y, written as a unit-normal xsctt plane
+static Plane makePlane(float z0, float tiltX, float tiltY) {
+    float norm = std::sqrt(tiltX * tiltX + tiltY * tiltY + 1.0f);
+    Plane plane;
+    plane.a = tiltX / norm;
+    plane.b = tiltY / norm;
+    plane.c = -1.0f / norm;
+    plane.d = z0 / norm;
+    return plane;
+}
+
+static float planeDepth(const Plane& plane, float x, float y) {
+    return -(plane.a * x + plane.b * y + plane.d) / plane.c;
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Rendering
+// ═══════════════════════════════════════════════════════════════════════
+
+// Three black crowns on white, outer radius `radius`, like a CCTag3 marker
+static void drawRingMarker(cv::Mat& image, const cv::Point2f& center, float radius) {
+    const float crowns[6] = { 1.0f, 0.84f, 0.68f, 0.52f, 0.36f, 0.20f };
+    const int shift = 4;
+    cv::Point c(cvRound(center.x * (1 << shift)), cvRound(center.y * (1 << shift)));
+
+    cv::circle(image, c, cvRound(radius * 1.25f * (1 << shift)), cv::Scalar(255), cv::FILLED, cv::LINE_AA, shift);
+    for (int i = 0; i < 6; i++) {
+        cv::Scalar color = (i % 2 == 0) ? cv::Scalar(20) : cv::Scalar(235);
+        cv::circle(image, c, cvRound(radius * crowns[i] * (1 << shift)), color, cv::FILLED, cv::LINE_AA, shift);
+    }
+    cv::circle(image, c, cvRound(radius * 0.06f * (1 << shift)), cv::Scalar(20), cv::FILLED, cv::LINE_AA, shift);
+}
+
+// Filled black dot of a circle-grid board
+static void drawDotMarker(cv::Mat& image, const cv::Point2f& center, float radius) {
+    const int shift = 4;
+    cv::Point c(cvRound(center.x * (1 << shift)), cvRound(center.y * (1 << shift)));
+    cv::circle(image, c, cvRound(radius * (1 << shift)), cv::Scalar(20), cv::FILLED, cv::LINE_AA, shift);
+}
+
+SyntheticScene renderSyntheticScene(const SyntheticSceneParams& params, cv::RNG& rng) {
+    SyntheticScene scene;
+    const int W = params.width;
+    const int H = params.height;
+
+    // Plane 1 (index 0) is the far left half, plane 2 (index 1) the near right half.
+    // Both share the tilt, so the offset below gives exactly params.planeDistance.
+    float norm = std::sqrt(params.tiltX * params.tiltX + params.tiltY * params.tiltY + 1.0f);
+    scene.planes.push_back(makePlane(params.farDepth, params.tiltX, params.tiltY));
+    scene.planes.push_back(makePlane(params.farDepth - params.planeDistance * norm, params.tiltX, params.tiltY));
+    scene.planeDistance = std::abs(scene.planes[0].d - scene.planes[1].d);
+
+    const int margin = W / 32;
+    for (int i = 0; i < 2; i++) {
+        PlaneRegion region;
+        region.rect = cv::Rect(i * W / 2 + margin, margin, W / 2 - 2 * margin, H - 2 * margin);
+        region.index = i;
+        scene.regions.push_back(region);
+    }
+
+    // Markers on a grid inside each region, jittered to sub-pixel positions
+    int cols = std::max(1, static_cast<int>(std::ceil(std::sqrt(static_cast<float>(params.markersPerPlane)))));
+    int rows = (params.markersPerPlane + cols - 1) / cols;
+    int id = 1;
+    for (const auto& region : scene.regions) {
+        for (int k = 0; k < params.markersPerPlane; k++) {
+            SyntheticMarker marker;
+            marker.center.x = region.rect.x + region.rect.width * ((k % cols) + 0.5f) / cols + rng.uniform(-8.0f, 8.0f);
+            marker.center.y = region.rect.y + region.rect.height * ((k / cols) + 0.5f) / rows + rng.uniform(-8.0f, 8.0f);
+            marker.id = id++;
+            marker.planeIndex = region.index;
+            marker.depth = planeDepth(scene.planes[region.index], marker.center.x, marker.center.y);
+            scene.markers.push_back(marker);
+        }
+    }
+
+    // Brightness
+    scene.brightness = cv::Mat(H, W, CV_8UC1, cv::Scalar(110));
+    for (const auto& region : scene.regions) {
+        scene.brightness(region.rect).setTo(cv::Scalar(150));
+    }
+    for (const auto& marker : scene.markers) {
+        if (params.dotMarkers) {
+            drawDotMarker(scene.brightness, marker.center, params.markerRadius * 0.5f);
+        } else {
+            drawRingMarker(scene.brightness, marker.center, params.markerRadius);
+        }
+    }
+    if (params.brightnessNoise > 0) {
+        cv::Mat noise(H, W, CV_16SC1);
+        rng.fill(noise, cv::RNG::NORMAL, cv::Scalar(0), cv::Scalar(params.brightnessNoise));
+        cv::Mat noisy;
+        scene.brightness.convertTo(noisy, CV_16SC1);
+        noisy += noise;
+        noisy.convertTo(scene.brightness, CV_8UC1);
+    }
+
+    // Depth (float first, converted at the end)
+    cv::Mat depth(H, W, CV_32FC1);
+    for (int y = 0; y < H; y++) {
+        float* row = depth.ptr<float>(y);
+        for (int x = 0; x < W; x++) {
+            const Plane& plane = scene.planes[x < W / 2 ? 0 : 1];
+            row[x] = planeDepth(plane, static_cast<float>(x), static_cast<float>(y));
+        }
+    }
+    if (params.depthNoise > 0) {
+        cv::Mat noise(H, W, CV_32FC1);
+        rng.fill(noise, cv::RNG::NORMAL, cv::Scalar(0), cv::Scalar(params.depthNoise));
+        depth += noise;
+    }
+
+    // Isolated dropouts
+    int dropouts = static_cast<int>(params.dropoutFraction * W * H);
+    for (int i = 0; i < dropouts; i++) {
+        depth.at<float>(rng.uniform(0, H), rng.uniform(0, W)) = 0.0f;
+    }
+
+    // Hole blobs; the first sits on a marker center to exercise the plane fallback
+    for (int i = 0; i < params.holeCount; i++) {
+        cv::Point2f c(rng.uniform(0.0f, static_cast<float>(W)), rng.uniform(0.0f, static_cast<float>(H)));
+        if (i == 0 && !scene.markers.empty()) c = scene.markers[rng.uniform(0, static_cast<int>(scene.markers.size()))].center;
+        cv::circle(depth, c, cvRound(params.markerRadius * 0.5f), cv::Scalar(0), cv::FILLED);
+    }
+
+    if (params.depthType == CV_16UC1) {
+        depth.convertTo(scene.depthMap, CV_16UC1);
+    } else {
+        scene.depthMap = depth;
+    }
+
+    return scene;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include <opencv2/core.hpp>
+#include "xsctt_core.h"
+
+// ═══════════════════════════════════════════════════════════════════════
+// Synthetic Calibration Scene
+// ═══════════════════════════════════════════════════════════════════════
+//
+// Renders a brightness/depth pair of the xsctt target without a camera:
+// two parallel planes (left half far, right half near) whose separation
+// is known exactly, ring or dot markers on both planes, depth noise and
+// holes.
+
+struct SyntheticSceneParams {
+    int width = 1920;
+    int height = 1200;
+    int depthType = CV_32FC1;           // CV_32FC1 (getDepthData) or CV_16UC1 (tiff export)
+    float farDepth = 1300.0f;           // plane 1 depth at the image origin (mm)
+    float planeDistance = kExpectedPlaneDistance;
+    float tiltX = 0.01f;                // depth gradient per pixel along x (both planes)
+    float tiltY = -0.005f;              // depth gradient per pixel along y (both planes)
+    float depthNoise = 0.3f;            // Gaussian depth noise sigma (mm)
+    float dropoutFraction = 0.01f;      // fraction of isolated invalid depth pixels
+    int holeCount = 4;                  // larger zero-depth blobs, the first one on a marker
+    int markersPerPlane = 4;
+    float markerRadius = 40.0f;         // outer ring radius (pixels)
+    bool dotMarkers = false;            // filled dots of markerRadius / 2 (circle-grid board) instead of rings
+    float brightnessNoise = 4.0f;       // Gaussian gray-level noise sigma
+};
+
+struct SyntheticMarker {
+    cv::Point2f center;
+    int id;
+    int planeIndex;
+    float depth;            // ground-truth depth at the exact center
+};
+
+struct SyntheticScene {
+    cv::Mat brightness;     // CV_8UC1
+    cv::Mat depthMap;       // params.depthType
+    std::vector<PlaneRegion> regions;
+    std::vector<Plane> planes;              // ground truth, xsctt (x, y, z) convention
+    std::vector<SyntheticMarker> markers;
+    float planeDistance;                    // ground truth for planeDistance(planes)
+};
+
+SyntheticScene renderSyntheticScene(const SyntheticSceneParams& params, cv::RNG& rng);
@@ -0,0 +1,622 @@
+#include "target_ba.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <opencv2/calib3d.hpp>
+#include "marker_localization.h"
+
+// ═══════════════════════════════════════════════════════════════════════
+// Inputs
+// ═══════════════════════════════════════════════════════════════════════
+
+CameraIntrinsics intrinsicsFromCalibration(const float intrinsic[9], const float distortion[12]) {
+    CameraIntrinsics cam;
+    for (int i = 0; i < 9; i++) cam.K.val[i] = intrinsic[i];
+    cam.distortion = cv::Mat(1, 5, CV_64F);
+    for (int i = 0; i < 5; i++) cam.distortion.at<double>(i) = distortion[i];
+    return cam;
+}
+
+TargetView makeTargetView(int frame, int camera, const std::vector<Circle>& circles, const cv::Mat& depthMap) {
+    TargetView view;
+    view.frame = frame;
+    view.camera = camera;
+
+    std::vector<MarkerLocation> locations;
+    if (!depthMap.empty()) {
+        std::vector<cv::Point2f> centers;
+        for (const auto& c : circles) centers.push_back(c.center);
+        locations = localizeMarkers(centers, depthMap);
+    }
+
+    for (size_t i = 0; i < circles.size(); i++) {
+        MarkerObservation obs;
+        obs.id = circles[i].id;
+        obs.center = circles[i].center;
+        obs.depth = (!locations.empty() && locations[i].valid) ? locations[i].position.z : 0.0f;
+        view.markers.push_back(obs);
+    }
+    return view;
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Problem Setup
+// ═══════════════════════════════════════════════════════════════════════
+
+struct Pose {
+    cv::Matx33d R = cv::Matx33d::eye();
+    cv::Vec3d t = cv::Vec3d(0, 0, 0);
+};
+
+struct Observation {
+    int point;
+    int camera;
+    cv::Point2d normalized;     // undistorted, z = 1
+    double depth;               // 0 = none
+    double fx, fy;
+};
+
+struct BundleState {
+    std::vector<cv::Vec3d> points;
+    std::vector<Pose> frames;
+    std::vector<Pose> cameras;
+};
+
+static cv::Matx33d skew(const cv::Vec3d& v) {
+    return cv::Matx33d(0, -v[2], v[1],
+                       v[2], 0, -v[0],
+                       -v[1], v[0], 0);
+}
+
+static cv::Matx33d expRotation(const cv::Vec3d& theta) {
+    cv::Matx33d R;
+    cv::Rodrigues(theta, R);
+    return R;
+}
+
+static cv::Vec3d transform(const Pose& pose, const cv::Vec3d& p) {
+    return pose.R * p + pose.t;
+}
+
+static Pose inverse(const Pose& pose) {
+    Pose inv;
+    inv.R = pose.R.t();
+    inv.t = -(inv.R * pose.t);
+    return inv;
+}
+
+static Pose compose(const Pose& a, const Pose& b) {
+    Pose c;
+    c.R = a.R * b.R;
+    c.t = a.R * b.t + a.t;
+    return c;
+}
+
+// Rigid transform with dst ~ R * src + t (Kabsch); false if degenerate.
+static bool alignRigid(const std::vector<cv::Vec3d>& src, const std::vector<cv::Vec3d>& dst, Pose& pose) {
+    if (src.size() < 3) return false;
+    cv::Vec3d ms(0, 0, 0), md(0, 0, 0);
+    for (size_t i = 0; i < src.size(); i++) {
+        ms += src[i];
+        md += dst[i];
+    }
+    ms *= 1.0 / src.size();
+    md *= 1.0 / src.size();
+
+    cv::Matx33d H = cv::Matx33d::zeros();
+    for (size_t i = 0; i < src.size(); i++) H += (src[i] - ms) * (dst[i] - md).t();
+
+    cv::Mat w, u, vt;
+    cv::SVDecomp(cv::Mat(H), w, u, vt);
+    if (w.at<double>(1) < 1e-6 * w.at<double>(0)) return false;     // collinear
+
+    cv::Matx33d U(u), Vt(vt);
+    cv::Matx33d R = Vt.t() * U.t();
+    if (cv::determinant(R) < 0) {
+        cv::Matx33d D = cv::Matx33d::eye();
+        D(2, 2) = -1;
+        R = Vt.t() * D * U.t();
+    }
+    pose.R = R;
+    pose.t = md - R * ms;
+    return true;
+}
+
+// Camera-space point from an observation with depth
+static cv::Vec3d backProject(const Observation& obs) {
+    return cv::Vec3d(obs.normalized.x, obs.normalized.y, 1.0) * obs.depth;
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Initialization
+// ═══════════════════════════════════════════════════════════════════════
+
+// Poses and points are chained from the gauge frame through shared
+// markers with depth until nothing new can be initialized.
+static void initializeState(const std::vector<std::vector<Observation>>& frameObs, int gaugeFrame,
+                            BundleState& state, std::vector<bool>& frameKnown,
+                            std::vector<bool>& cameraKnown, std::vector<bool>& pointKnown) {
+    frameKnown[gaugeFrame] = true;
+    cameraKnown[0] = true;
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t f = 0; f < frameObs.size(); f++) {
+            for (size_t c = 0; c < cameraKnown.size(); c++) {
+                std::vector<const Observation*> obs;
+                for (const auto& o : frameObs[f]) {
+                    if (o.camera == static_cast<int>(c) && o.depth > 0) obs.push_back(&o);
+                }
+                if (obs.empty()) continue;
+
+                std::vector<cv::Vec3d> src, dst;
+                if (frameKnown[f] && cameraKnown[c]) {
+                    // New markers
+                    Pose camToTarget = inverse(compose(state.cameras[c], state.frames[f]));
+                    for (const Observation* o : obs) {
+                        if (pointKnown[o->point]) continue;
+                        state.points[o->point] = transform(camToTarget, backProject(*o));
+                        pointKnown[o->point] = true;
+                        changed = true;
+                    }
+                } else if (cameraKnown[c]) {
+                    // Target pose of this frame
+                    for (const Observation* o : obs) {
+                        if (!pointKnown[o->point]) continue;
+                        src.push_back(state.points[o->point]);
+                        dst.push_back(backProject(*o));
+                    }
+                    Pose targetToCam;
+                    if (alignRigid(src, dst, targetToCam)) {
+                        state.frames[f] = compose(inverse(state.cameras[c]), targetToCam);
+                        frameKnown[f] = true;
+                        changed = true;
+                    }
+                } else if (frameKnown[f]) {
+                    // Extrinsics of this camera
+                    for (const Observation* o : obs) {
+                        if (!pointKnown[o->point]) continue;
+                        src.push_back(transform(state.frames[f], state.points[o->point]));
+                        dst.push_back(backProject(*o));
+                    }
+                    Pose worldToCam;
+                    if (alignRigid(src, dst, worldToCam)) {
+                        state.cameras[c] = worldToCam;
+                        cameraKnown[c] = true;
+                        changed = true;
+                    }
+                }
+            }
+        }
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Residuals and Jacobians
+// ═══════════════════════════════════════════════════════════════════════
+
+struct Linearization {
+    cv::Vec3d r;            // weighted residual (depth row 0 when unused)
+    cv::Matx33d Jp;         // weighted d r / d p_camera
+    cv::Vec3d q;            // R_frame * X
+    cv::Vec3d s;            // R_camera * p_world
+    double reprojSq;        // unweighted squared pixel error
+    double depthSq;         // unweighted squared depth error (mm^2)
+    double cost;            // robust cost
+};
+
+static double huberWeight(double norm, double delta) {
+    return norm <= delta ? 1.0 : delta / norm;
+}
+
+static double huberCost(double norm, double delta) {
+    return norm <= delta ? norm * norm : 2.0 * delta * norm - delta * delta;
+}
+
+static Linearization linearize(const Observation& obs, const BundleState& state, int frame,
+                               const BundleParams& params) {
+    Linearization lin;
+    const Pose& F = state.frames[frame];
+    const Pose& C = state.cameras[obs.camera];
+
+    lin.q = F.R * state.points[obs.point];
+    lin.s = C.R * (lin.q + F.t);
+    cv::Vec3d pc = lin.s + C.t;
+    double z = std::max(pc[2], 1e-6);
+    double iz = 1.0 / z;
+
+    double ex = obs.fx * (pc[0] * iz - obs.normalized.x);
+    double ey = obs.fy * (pc[1] * iz - obs.normalized.y);
+    double norm = std::sqrt(ex * ex + ey * ey);
+    double w = std::sqrt(huberWeight(norm, params.huberDelta));
+    lin.reprojSq = ex * ex + ey * ey;
+    lin.cost = huberCost(norm, params.huberDelta);
+
+    lin.r = cv::Vec3d(w * ex, w * ey, 0.0);
+    lin.Jp = cv::Matx33d(w * obs.fx * iz, 0, -w * obs.fx * pc[0] * iz * iz,
+                         0, w * obs.fy * iz, -w * obs.fy * pc[1] * iz * iz,
+                         0, 0, 0);
+
+    lin.depthSq = 0.0;
+    if (obs.depth > 0) {
+        double ed = (pc[2] - obs.depth) / params.depthSigma;
+        double wd = std::sqrt(huberWeight(std::abs(ed), params.huberDelta));
+        lin.r[2] = wd * ed;
+        lin.Jp(2, 2) = wd / params.depthSigma;
+        lin.depthSq = (pc[2] - obs.depth) * (pc[2] - obs.depth);
+        lin.cost += huberCost(std::abs(ed), params.huberDelta);
+    }
+    return lin;
+}
+
+struct CostSummary {
+    double cost = 0.0;
+    double reprojSq = 0.0;
+    double depthSq = 0.0;
+    int reprojCount = 0;
+    int depthCount = 0;
+};
+
+static CostSummary evaluateCost(const std::vector<std::vector<Observation>>& frameObs,
+                                const std::vector<int>& activeFrames, const BundleState& state,
+                                const BundleParams& params) {
+    std::vector<CostSummary> perFrame(activeFrames.size());
+    cv::parallel_for_(cv::Range(0, static_cast<int>(activeFrames.size())), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; i++) {
+            int f = activeFrames[i];
+            CostSummary& sum = perFrame[i];
+            for (const auto& obs : frameObs[f]) {
+                Linearization lin = linearize(obs, state, f, params);
+                sum.cost += lin.cost;
+                sum.reprojSq += lin.reprojSq;
+                sum.reprojCount++;
+                if (obs.depth > 0) {
+                    sum.depthSq += lin.depthSq;
+                    sum.depthCount++;
+                }
+            }
+        }
+    });
+
+    CostSummary total;
+    for (const auto& s : perFrame) {
+        total.cost += s.cost;
+        total.reprojSq += s.reprojSq;
+        total.depthSq += s.depthSq;
+        total.reprojCount += s.reprojCount;
+        total.depthCount += s.depthCount;
+    }
+    return total;
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Schur Complement
+// ═══════════════════════════════════════════════════════════════════════
+
+// Reduced unknowns: 3 per marker, then 6 per camera other than camera 0.
+struct ReducedLayout {
+    std::vector<int> pointOffset;
+    std::vector<int> cameraOffset;      // -1 for camera 0 and unknown cameras
+    int size = 0;
+};
+
+// One frame's contribution, already reduced over its own pose.
+struct FrameSystem {
+    std::vector<int> globalOffset;      // reduced block offsets touched by this frame
+    std::vector<int> blockSize;
+    std::vector<int> localOffset;
+    cv::Mat S;                          // T x T
+    cv::Mat b;                          // T x 1
+    cv::Mat diagV;                      // T x 1, undamped diagonal of the reduced block
+    cv::Mat UinvW;                      // 6 x T, for back-substitution
+    cv::Mat Uinvg;                      // 6 x 1
+    bool hasPose = false;
+};
+
+template <int m, int n>
+static void addBlock(cv::Mat& M, int r0, int c0, const cv::Matx<double, m, n>& B) {
+    for (int i = 0; i < m; i++) {
+        double* row = M.ptr<double>(r0 + i) + c0;
+        for (int j = 0; j < n; j++) row[j] += B(i, j);
+    }
+}
+
+template <int m>
+static void addVec(cv::Mat& v, int r0, const cv::Vec<double, m>& x) {
+    for (int i = 0; i < m; i++) v.at<double>(r0 + i) += x[i];
+}
+
+static cv::Matx<double, 3, 6> hconcat(const cv::Matx33d& a, const cv::Matx33d& b) {
+    cv::Matx<double, 3, 6> r;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            r(i, j) = a(i, j);
+            r(i, j + 3) = b(i, j);
+        }
+    }
+    return r;
+}
+
+static FrameSystem buildFrameSystem(const std::vector<Observation>& obsList, const BundleState& state, int frame,
+                                    bool hasPose, const ReducedLayout& layout, double lambda,
+                                    const BundleParams& params) {
+    FrameSystem sys;
+    sys.hasPose = hasPose;
+
+    // Local layout of the touched reduced blocks
+    std::map<int, int> local;
+    int T = 0;
+    auto touch = [&](int offset, int size) {
+        if (offset < 0 || local.count(offset)) return;
+        local[offset] = T;
+        sys.globalOffset.push_back(offset);
+        sys.blockSize.push_back(size);
+        sys.localOffset.push_back(T);
+        T += size;
+    };
+    for (const auto& obs : obsList) {
+        touch(layout.pointOffset[obs.point], 3);
+        touch(layout.cameraOffset[obs.camera], 6);
+    }
+
+    cv::Mat V = cv::Mat::zeros(T, T, CV_64F);
+    cv::Mat g = cv::Mat::zeros(T, 1, CV_64F);
+    cv::Mat W = cv::Mat::zeros(6, T, CV_64F);
+    cv::Matx66d U = cv::Matx66d::zeros();
+    cv::Vec6d gf(0, 0, 0, 0, 0, 0);
+
+    const Pose& F = state.frames[frame];
+    for (const auto& obs : obsList) {
+        Linearization lin = linearize(obs, state, frame, params);
+        const Pose& C = state.cameras[obs.camera];
+
+        int px = local[layout.pointOffset[obs.point]];
+        int cOffset = layout.cameraOffset[obs.camera];
+        int pc = cOffset >= 0 ? local[cOffset] : -1;
+
+        cv::Matx33d AX = lin.Jp * C.R * F.R;
+        cv::Matx<double, 3, 6> AC = hconcat(lin.Jp * -skew(lin.s), lin.Jp);
+        cv::Matx<double, 3, 6> AF = hconcat(lin.Jp * C.R * -skew(lin.q), lin.Jp * C.R);
+
+        addBlock(V, px, px, cv::Matx33d(AX.t() * AX));
+        addVec(g, px, cv::Vec3d(AX.t() * -lin.r));
+        if (pc >= 0) {
+            cv::Matx<double, 3, 6> XC = AX.t() * AC;
+            addBlock(V, pc, pc, cv::Matx66d(AC.t() * AC));
+            addBlock(V, px, pc, XC);
+            addBlock(V, pc, px, cv::Matx<double, 6, 3>(XC.t()));
+            addVec(g, pc, cv::Vec6d(AC.t() * -lin.r));
+        }
+        if (hasPose) {
+            U += AF.t() * AF;
+            gf += AF.t() * -lin.r;
+            addBlock(W, 0, px, cv::Matx<double, 6, 3>(AF.t() * AX));
+            if (pc >= 0) addBlock(W, 0, pc, cv::Matx66d(AF.t() * AC));
+        }
+    }
+
+    sys.diagV = V.diag().clone();
+    if (!hasPose) {
+        sys.S = V;
+        sys.b = g;
+        return sys;
+    }
+
+    // Eliminate the frame pose: S = V - W^T U^-1 W, b = g - W^T U^-1 g_f
+    for (int i = 0; i < 6; i++) U(i, i) += lambda * U(i, i) + 1e-12;
+    cv::Matx66d Uinv = U.inv(cv::DECOMP_CHOLESKY);
+    sys.UinvW = cv::Mat(Uinv) * W;
+    sys.Uinvg = cv::Mat(Uinv * gf);
+    sys.S = V - W.t() * sys.UinvW;
+    sys.b = g - W.t() * sys.Uinvg;
+    return sys;
+}
+
+// ═══════════════════════════════════════════════════════════════════════
+// Solver
+// ═══════════════════════════════════════════════════════════════════════
+
+static cv::Matx44d toMatrix(const Pose& pose) {
+    return cv::Matx44d(pose.R(0, 0), pose.R(0, 1), pose.R(0, 2), pose.t[0],
+                       pose.R(1, 0), pose.R(1, 1), pose.R(1, 2), pose.t[1],
+                       pose.R(2, 0), pose.R(2, 1), pose.R(2, 2), pose.t[2],
+                       0, 0, 0, 1);
+}
+
+BundleResult solveTargetBundle(const std::vector<TargetView>& views,
+                               const std::vector<CameraIntrinsics>& intrinsics,
+                               const BundleParams& params) {
+    BundleResult result;
+    const int numCameras = static_cast<int>(intrinsics.size());
+
+    // 1. Undistort observations and index markers / frames
+    int numFrames = 0;
+    std::map<int, int> pointIndex;
+    std::vector<int> pointIds;
+    for (const auto& view : views) {
+        numFrames = std::max(numFrames, view.frame + 1);
+        for (const auto& m : view.markers) {
+            if (!pointIndex.count(m.id)) {
+                pointIndex[m.id] = static_cast<int>(pointIds.size());
+                pointIds.push_back(m.id);
+            }
+        }
+    }
+    result.frameValid.assign(numFrames, false);
+    result.framePoses.assign(numFrames, cv::Matx44d::eye());
+    result.cameraExtrinsics.assign(numCameras, cv::Matx44d::eye());
+
+    std::vector<std::vector<Observation>> frameObs(numFrames);
+    int gaugeFrame = -1;
+    for (const auto& view : views) {
+        if (view.camera < 0 || view.camera >= numCameras || view.markers.empty()) continue;
+        const CameraIntrinsics& cam = intrinsics[view.camera];
+
+        std::vector<cv::Point2f> pixels, normalized;
+        for (const auto& m : view.markers) pixels.push_back(m.center);
+        cv::undistortPoints(pixels, normalized, cv::Mat(cam.K), cam.distortion);
+
+        int withDepth = 0;
+        for (size_t i = 0; i < view.markers.size(); i++) {
+            Observation obs;
+            obs.point = pointIndex[view.markers[i].id];
+            obs.camera = view.camera;
+            obs.normalized = cv::Point2d(normalized[i].x, normalized[i].y);
+            obs.depth = view.markers[i].depth;
+            obs.fx = cam.K(0, 0);
+            obs.fy = cam.K(1, 1);
+            frameObs[view.frame].push_back(obs);
+            if (obs.depth > 0) withDepth++;
+        }
+        if (view.camera == 0 && withDepth >= 3 && (gaugeFrame < 0 || view.frame < gaugeFrame)) {
+            gaugeFrame = view.frame;
+        }
+    }
+    if (gaugeFrame < 0) {
+        std::cerr << "Bundle: no camera-0 view with at least 3 depth markers" << std::endl;
+        return result;
+    }
+
+    // 2. Initial guess
+    BundleState state;
+    state.points.assign(pointIds.size(), cv::Vec3d(0, 0, 0));
+    state.frames.assign(numFrames, Pose());
+    state.cameras.assign(numCameras, Pose());
+    std::vector<bool> frameKnown(numFrames, false), cameraKnown(numCameras, false), pointKnown(pointIds.size(), false);
+    initializeState(frameObs, gaugeFrame, state, frameKnown, cameraKnown, pointKnown);
+
+    // Observations that cannot be used are dropped
+    std::vector<int> activeFrames;
+    for (int f = 0; f < numFrames; f++) {
+        if (!frameKnown[f]) {
+            frameObs[f].clear();
+            continue;
+        }
+        auto& obs = frameObs[f];
+        obs.erase(std::remove_if(obs.begin(), obs.end(), [&](const Observation& o) {
+            return !pointKnown[o.point] || !cameraKnown[o.camera];
+        }), obs.end());
+        if (!obs.empty()) activeFrames.push_back(f);
+    }
+
+    ReducedLayout layout;
+    layout.pointOffset.assign(pointIds.size(), -1);
+    layout.cameraOffset.assign(numCameras, -1);
+    for (size_t j = 0; j < pointIds.size(); j++) {
+        if (!pointKnown[j]) continue;
+        layout.pointOffset[j] = layout.size;
+        layout.size += 3;
+    }
+    for (int c = 1; c < numCameras; c++) {
+        if (!cameraKnown[c]) continue;
+        layout.cameraOffset[c] = layout.size;
+        layout.size += 6;
+    }
+
+    CostSummary current = evaluateCost(frameObs, activeFrames, state, params);
+    result.initialRms = current.reprojCount ? std::sqrt(current.reprojSq / current.reprojCount) : 0.0;
+
+    // 3. Levenberg-Marquardt
+    double lambda = params.initialLambda;
+    std::vector<FrameSystem> systems(activeFrames.size());
+    for (int iter = 0; iter < params.maxIterations && lambda < 1e10; iter++) {
+        cv::parallel_for_(cv::Range(0, static_cast<int>(activeFrames.size())), [&](const cv::Range& range) {
+            for (int i = range.start; i < range.end; i++) {
+                int f = activeFrames[i];
+                systems[i] = buildFrameSystem(frameObs[f], state, f, f != gaugeFrame, layout, lambda, params);
+            }
+        });
+
+        cv::Mat S = cv::Mat::zeros(layout.size, layout.size, CV_64F);
+        cv::Mat b = cv::Mat::zeros(layout.size, 1, CV_64F);
+        cv::Mat diagV = cv::Mat::zeros(layout.size, 1, CV_64F);
+        for (const auto& sys : systems) {
+            for (size_t bi = 0; bi < sys.globalOffset.size(); bi++) {
+                int gi = sys.globalOffset[bi], li = sys.localOffset[bi], ni = sys.blockSize[bi];
+                for (int r = 0; r < ni; r++) {
+                    b.at<double>(gi + r) += sys.b.at<double>(li + r);
+                    diagV.at<double>(gi + r) += sys.diagV.at<double>(li + r);
+                }
+                for (size_t bj = 0; bj < sys.globalOffset.size(); bj++) {
+                    int gj = sys.globalOffset[bj], lj = sys.localOffset[bj], nj = sys.blockSize[bj];
+                    for (int r = 0; r < ni; r++) {
+                        const double* src = sys.S.ptr<double>(li + r) + lj;
+                        double* dst = S.ptr<double>(gi + r) + gj;
+                        for (int c = 0; c < nj; c++) dst[c] += src[c];
+                    }
+                }
+            }
+        }
+        for (int i = 0; i < layout.size; i++) S.at<double>(i, i) += lambda * diagV.at<double>(i) + 1e-12;
+
+        cv::Mat dx;
+        if (!cv::solve(S, b, dx, cv::DECOMP_CHOLESKY)) cv::solve(S, b, dx, cv::DECOMP_SVD);
+
+        // Back-substitute the frame poses and apply the step
+        BundleState candidate = state;
+        for (size_t j = 0; j < pointIds.size(); j++) {
+            int o = layout.pointOffset[j];
+            if (o < 0) continue;
+            candidate.points[j] += cv::Vec3d(dx.at<double>(o), dx.at<double>(o + 1), dx.at<double>(o + 2));
+        }
+        for (int c = 1; c < numCameras; c++) {
+            int o = layout.cameraOffset[c];
+            if (o < 0) continue;
+            const double* d = dx.ptr<double>(o);
+            candidate.cameras[c].R = expRotation(cv::Vec3d(d[0], d[1], d[2])) * state.cameras[c].R;
+            candidate.cameras[c].t += cv::Vec3d(d[3], d[4], d[5]);
+        }
+        cv::parallel_for_(cv::Range(0, static_cast<int>(activeFrames.size())), [&](const cv::Range& range) {
+            for (int i = range.start; i < range.end; i++) {
+                const FrameSystem& sys = systems[i];
+                if (!sys.hasPose) continue;
+                cv::Mat dxLocal(static_cast<int>(sys.S.rows), 1, CV_64F);
+                for (size_t bi = 0; bi < sys.globalOffset.size(); bi++) {
+                    for (int r = 0; r < sys.blockSize[bi]; r++) {
+                        dxLocal.at<double>(sys.localOffset[bi] + r) = dx.at<double>(sys.globalOffset[bi] + r);
+                    }
+                }
+                cv::Mat df = sys.Uinvg - sys.UinvW * dxLocal;
+                int f = activeFrames[i];
+                const double* d = df.ptr<double>();
+                candidate.frames[f].R = expRotation(cv::Vec3d(d[0], d[1], d[2])) * state.frames[f].R;
+                candidate.frames[f].t += cv::Vec3d(d[3], d[4], d[5]);
+            }
+        });
+
+        CostSummary next = evaluateCost(frameObs, activeFrames, candidate, params);
+        result.iterations = iter + 1;
+        if (next.cost < current.cost) {
+            double improvement = (current.cost - next.cost) / std::max(current.cost, 1e-300);
+            state = candidate;
+            current = next;
+            lambda = std::max(lambda * 0.1, 1e-12);
+            if (improvement < params.stopRelativeCost) {
+                result.converged = true;
+                break;
+            }
+        } else {
+            lambda *= 10.0;
+        }
+    }
+    if (lambda >= 1e10) result.converged = true;    // no further descent possible
+
+    // 4. Output
+    result.finalRms = current.reprojCount ? std::sqrt(current.reprojSq / current.reprojCount) : 0.0;
+    result.depthRms = current.depthCount ? std::sqrt(current.depthSq / current.depthCount) : 0.0;
+    for (size_t j = 0; j < pointIds.size(); j++) {
+        if (!pointKnown[j]) continue;
+        const cv::Vec3d& p = state.points[j];
+        result.targetPoints[pointIds[j]] = cv::Point3f(static_cast<float>(p[0]), static_cast<float>(p[1]),
+                                                       static_cast<float>(p[2]));
+    }
+    for (int f : activeFrames) {
+        result.frameValid[f] = true;
+        result.framePoses[f] = toMatrix(state.frames[f]);
+    }
+    for (int c = 0; c < numCameras; c++) {
+        if (cameraKnown[c]) result.cameraExtrinsics[c] = toMatrix(state.cameras[c]);
+    }
+    return result;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <map>
+#include <vector>
+#include <opencv2/core.hpp>
+#include "xsctt_core.h"
+
+// ═══════════════════════════════════════════════════════════════════════
+// Multi-Capture Target Bundle Adjustment
+// ═══════════════════════════════════════════════════════════════════════
+//
+// Jointly estimates the target geometry (3D position of every marker id),
+// the target pose of every capture and the extrinsics of every camera
+// from many captures of the CCTag target. Markers are matched across
+// captures by their CCTag id; circle-grid indices depend on which dots
+// were found and are not stable across views, so they are not accepted.
+//
+//   p_world  = R_frame * X_marker + t_frame      (world = camera 0)
+//   p_camera = R_camera * p_world + t_camera
+//
+// Residuals are the reprojection error of the undistorted marker centers
+// (pixels, Huber-weighted) and, where the depth map has a value, the depth
+// error scaled by 1 / depthSigma. Depth also fixes the scale.
+//
+// Sparse Levenberg-Marquardt: every observation touches one frame pose,
+// one camera and one marker, so the frame poses (hundreds) are eliminated
+// with a Schur complement computed per frame in parallel, and the reduced
+// system over markers and cameras (a few hundred unknowns) is solved
+// densely. Frame 0 fixes the gauge: the target frame is its pose in
+// camera 0.
+
+struct CameraIntrinsics {
+    cv::Matx33d K;
+    cv::Mat distortion;     // k1, k2, p1, p2, k3
+};
+
+// From CalibrationParam::intrinsic (3x3 row-major) and ::distortion
+CameraIntrinsics intrinsicsFromCalibration(const float intrinsic[9], const float distortion[12]);
+
+struct MarkerObservation {
+    int id;
+    cv::Point2f center;     // distorted pixel coordinates
+    float depth;            // camera z (mm), 0 = not measured
+};
+
+struct TargetView {
+    int frame;              // target pose index (same frame = same pose for all cameras)
+    int camera;             // index into the intrinsics list
+    std::vector<MarkerObservation> markers;
+};
+
+// Builds a view from detectCCTag output (circles with their CCTag id), with
+// sub-pixel depth from localizeMarkers (empty depthMap = no depth).
+TargetView makeTargetView(int frame, int camera, const std::vector<Circle>& circles, const cv::Mat& depthMap);
+
+struct BundleParams {
+    int maxIterations = 50;
+    double huberDelta = 2.0;        // pixels
+    double depthSigma = 0.5;        // mm that weigh as much as 1 pixel
+    double initialLambda = 1e-3;
+    double stopRelativeCost = 1e-9; // stop when the cost improves by less than this fraction
+};
+
+struct BundleResult {
+    std::map<int, cv::Point3f> targetPoints;    // marker id -> target frame (mm)
+    std::vector<cv::Matx44d> framePoses;        // target -> world, per frame
+    std::vector<cv::Matx44d> cameraExtrinsics;  // world -> camera, per camera (camera 0 = identity)
+    std::vector<bool> frameValid;               // false: frame could not be initialized
+    double initialRms = 0.0;                    // reprojection RMS (pixels)
+    double finalRms = 0.0;
+    double depthRms = 0.0;                      // final depth RMS (mm)
+    int iterations = 0;
+    bool converged = false;
+};
+
+BundleResult solveTargetBundle(const std::vector<TargetView>& views,
+                               const std::vector<CameraIntrinsics>& intrinsics,
+                               const BundleParams& params = BundleParams());
@@ -0,0 +1,239 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <opencv2/opencv.hpp>
+#include "xsctt_core.h"
+#include "synthetic_scene.h"
+
+// ═══════════════════════════════════════════════════════════════════════
+// xsctt Synthetic Benchmark
+// ═══════════════════════════════════════════════════════════════════════
+//
+// Runs the headless xsctt pipeline (detection, plane fitting, marker
+// localization, measurements) on rendered scenes with known geometry and
+// reports latency percentiles, throughput and error against ground truth.
+//
+// Usage: xsctt_bench [--frames N] [--width W] [--height H] [--markers N]
+//                    [--noise MM] [--dropout FRACTION] [--holes N]
+//                    [--depth16] [--cctag | --grid] [--seed N]
+//                    [--max-plane-error MM] [--max-marker-error MM]
+//
+// --grid renders dot markers and runs the circle-grid detector. Without
+// --cctag or --grid the ground-truth centers are used so that depth
+// accuracy is measured independently of the detector. Exits with 1 when a
+// --max-*-error limit is exceeded.
+
+struct BenchOptions {
+    int frames = 50;
+    bool useCCTag = false;
+    bool useGrid = false;
+    uint64 seed = 12345;
+    float maxPlaneError = -1.0f;
+    float maxMarkerError = -1.0f;
+    SyntheticSceneParams scene;
+};
+
+struct StageTimes {
+    std::vector<double> detect, planes, markers, measure, total;
+};
+
+static double elapsedMs(int64 start) {
+    return (cv::getTickCount() - start) * 1000.0 / cv::getTickFrequency();
+}
+
+static double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    size_t idx = static_cast<size_t>(std::ceil(p / 100.0 * values.size()));
+    return values[std::min(values.size() - 1, idx > 0 ? idx - 1 : 0)];
+}
+
+static double mean(const std::vector<double>& values) {
+    if (values.empty()) return 0.0;
+    double sum = 0.0;
+    for (double v : values) sum += v;
+    return sum / values.size();
+}
+
+static void printLatency(const std::string& name, const std::vector<double>& values) {
+    std::cout << "  " << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(3)
+              << "  p50 " << std::setw(9) << percentile(values, 50)
+              << "  p90 " << std::setw(9) << percentile(values, 90)
+              << "  p99 " << std::setw(9) << percentile(values, 99)
+              << "  max " << std::setw(9) << percentile(values, 100) << " ms" << std::endl;
+}
+
+static void printError(const std::string& name, const std::vector<double>& values, const std::string& unit) {
+    std::cout << "  " << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(4)
+              << "  mean " << std::setw(9) << mean(values)
+              << "  p90 " << std::setw(9) << percentile(values, 90)
+              << "  max " << std::setw(9) << percentile(values, 100) << " " << unit
+              << "  (n=" << values.size() << ")" << std::endl;
+}
+
+static bool parseOptions(int argc, char** argv, BenchOptions& opt) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--frames" && hasValue) opt.frames = std::atoi(argv[++i]);
+        else if (arg == "--width" && hasValue) opt.scene.width = std::atoi(argv[++i]);
+        else if (arg == "--height" && hasValue) opt.scene.height = std::atoi(argv[++i]);
+        else if (arg == "--markers" && hasValue) opt.scene.markersPerPlane = std::atoi(argv[++i]);
+        else if (arg == "--noise" && hasValue) opt.scene.depthNoise = static_cast<float>(std::atof(argv[++i]));
+        else if (arg == "--dropout" && hasValue) opt.scene.dropoutFraction = static_cast<float>(std::atof(argv[++i]));
+        else if (arg == "--holes" && hasValue) opt.scene.holeCount = std::atoi(argv[++i]);
+        else if (arg == "--seed" && hasValue) opt.seed = static_cast<uint64>(std::atoll(argv[++i]));
+        else if (arg == "--max-plane-error" && hasValue) opt.maxPlaneError = static_cast<float>(std::atof(argv[++i]));
+        else if (arg == "--max-marker-error" && hasValue) opt.maxMarkerError = static_cast<float>(std::atof(argv[++i]));
+        else if (arg == "--depth16") opt.scene.depthType = CV_16UC1;
+        else if (arg == "--cctag") opt.useCCTag = true;
+        else if (arg == "--grid") opt.useGrid = opt.scene.dotMarkers = true;
+        else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return false;
+        }
+    }
+    return opt.frames > 0;
+}
+
+// Index of the ground-truth marker nearest to `center`, or -1 if none is
+// within half a marker radius.
+static int matchMarker(const SyntheticScene& scene, const cv::Point2f& center, float radius) {
+    int best = -1;
+    double bestDist = radius * 0.5;
+    for (size_t i = 0; i < scene.markers.size(); i++) {
+        double dist = cv::norm(scene.markers[i].center - center);
+        if (dist < bestDist) {
+            bestDist = dist;
+            best = static_cast<int>(i);
+        }
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    BenchOptions opt;
+    if (!parseOptions(argc, argv, opt)) {
+        std::cerr << "Usage: xsctt_bench [--frames N] [--width W] [--height H] [--markers N] [--noise MM]"
+                  << " [--dropout FRACTION] [--holes N] [--depth16] [--cctag | --grid] [--seed N]"
+                  << " [--max-plane-error MM] [--max-marker-error MM]" << std::endl;
+        return -1;
+    }
+
+    std::cout << "=== xsctt Synthetic Benchmark ===" << std::endl;
+    std::cout << "  Frames: " << opt.frames << ", " << opt.scene.width << "x" << opt.scene.height
+              << (opt.scene.depthType == CV_16UC1 ? " 16U" : " 32F") << " depth, "
+              << 2 * opt.scene.markersPerPlane << " markers, noise " << opt.scene.depthNoise << " mm"
+              << (opt.useCCTag ? ", CCTag detection" : opt.useGrid ? ", circle-grid detection" : ", ground-truth centers") << std::endl;
+
+    cv::RNG rng(opt.seed);
+    StageTimes times;
+    std::vector<double> planeErrors, markerErrors, centerErrors;
+    int expectedMarkers = 0, foundMarkers = 0, failedFrames = 0;
+
+    for (int frame = 0; frame < opt.frames; frame++) {
+        SyntheticScene scene = renderSyntheticScene(opt.scene, rng);
+        expectedMarkers += static_cast<int>(scene.markers.size());
+
+        // Pipeline output is silenced while timing
+        std::streambuf* coutBuf = std::cout.rdbuf(nullptr);
+
+        int64 start = cv::getTickCount();
+        int64 t = start;
+        std::vector<Circle> circles;
+        if (opt.useCCTag) {
+            circles = detectCCTag(scene.brightness);
+        } else if (opt.useGrid) {
+            circles = detectGridCircles(scene.brightness);
+        } else {
+            for (const auto& marker : scene.markers) {
+                Circle c;
+                c.center = marker.center;
+                c.radius = opt.scene.markerRadius;
+                c.id = marker.id;
+                c.planeIndex = -1;
+                circles.push_back(c);
+            }
+        }
+        double detectMs = elapsedMs(t);
+
+        t = cv::getTickCount();
+        std::vector<Plane> planes = fitRegionPlanes(scene.regions, scene.depthMap);
+        double planesMs = elapsedMs(t);
+
+        double markersMs = 0.0, measureMs = 0.0;
+        std::vector<cv::Point3f> coords3d;
+        if (planes.size() == 2) {
+            t = cv::getTickCount();
+            coords3d = computeMarkerCoordinates(circles, scene.regions, planes, scene.depthMap);
+            markersMs = elapsedMs(t);
+
+            t = cv::getTickCount();
+            calculateMeasurements(circles, planes, coords3d);
+            measureMs = elapsedMs(t);
+        }
+        double totalMs = elapsedMs(start);
+
+        std::cout.rdbuf(coutBuf);
+
+        times.detect.push_back(detectMs);
+        times.planes.push_back(planesMs);
+        times.markers.push_back(markersMs);
+        times.measure.push_back(measureMs);
+        times.total.push_back(totalMs);
+
+        if (planes.size() != 2) {
+            failedFrames++;
+            continue;
+        }
+        planeErrors.push_back(std::abs(planeDistance(planes) - scene.planeDistance));
+
+        // coords3d holds one entry per circle that landed in a region
+        size_t k = 0;
+        for (const auto& circle : circles) {
+            if (circle.planeIndex < 0) continue;
+            const cv::Point3f& p = coords3d[k++];
+            int gt = matchMarker(scene, circle.center, opt.scene.markerRadius);
+            if (gt < 0) continue;
+            foundMarkers++;
+            markerErrors.push_back(std::abs(p.z - scene.markers[gt].depth));
+            centerErrors.push_back(cv::norm(circle.center - scene.markers[gt].center));
+        }
+    }
+
+    double totalSec = 0.0;
+    for (double ms : times.total) totalSec += ms / 1000.0;
+
+    std::cout << "\n--- Latency ---" << std::endl;
+    bool detecting = opt.useCCTag || opt.useGrid;
+    if (detecting) printLatency("detect", times.detect);
+    printLatency("planes", times.planes);
+    printLatency("markers", times.markers);
+    printLatency("measure", times.measure);
+    printLatency("total", times.total);
+
+    std::cout << "\n--- Throughput ---" << std::endl;
+    std::cout << "  " << std::fixed << std::setprecision(2) << (totalSec > 0 ? opt.frames / totalSec : 0.0)
+              << " frames/s, " << (totalSec > 0 ? foundMarkers / totalSec : 0.0) << " markers/s" << std::endl;
+
+    std::cout << "\n--- Accuracy vs Ground Truth ---" << std::endl;
+    std::cout << "  Markers found: " << foundMarkers << "/" << expectedMarkers
+              << ", failed frames: " << failedFrames << std::endl;
+    printError("plane distance", planeErrors, "mm");
+    printError("marker depth", markerErrors, "mm");
+    if (detecting) printError("marker center", centerErrors, "px");
+
+    bool pass = true;
+    if (opt.maxPlaneError >= 0 && (planeErrors.empty() || percentile(planeErrors, 100) > opt.maxPlaneError)) {
+        std::cerr << "FAIL: plane distance error above " << opt.maxPlaneError << " mm" << std::endl;
+        pass = false;
+    }
+    if (opt.maxMarkerError >= 0 && (markerErrors.empty() || percentile(markerErrors, 100) > opt.maxMarkerError)) {
+        std::cerr << "FAIL: marker depth error above " << opt.maxMarkerError << " mm" << std::endl;
+        pass = false;
+    }
+    return pass ? 0 : 1;
+}
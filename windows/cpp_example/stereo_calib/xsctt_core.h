@@ -0,0 +1,57 @@
+#pragma once
+#include <cmath>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+
+// ═══════════════════════════════════════════════════════════════════════
+// Data Structures
+// ═══════════════════════════════════════════════════════════════════════
+
+struct Circle {
+    cv::Point2f center;
+    float radius;
+    int id;
+    int planeIndex;
+};
+
+struct Plane {
+    float a, b, c, d;
+    
+    float distance(const cv::Point3f& pt) const {
+        return std::abs(a * pt.x + b * pt.y + c * pt.z + d);
+    }
+};
+
+struct PlaneRegion {
+    cv::Rect rect;
+    int index;
+};
+
+// Ground-truth distance between the two reference planes of the target (70 cm)
+const float kExpectedPlaneDistance = 700.0f;
+
+// Circle detection
+std::vector<Circle> detectCCTag(const cv::Mat& image);
+std::vector<Circle> detectGridCircles(const cv::Mat& image);
+std::vector<Circle> loadCirclesFromFile(const std::string& filename);
+
+// Plane fitting
+std::vector<cv::Point3f> extractPointsFromRegion(const PlaneRegion& region, const cv::Mat& depthMap);
+Plane fitPlaneRANSAC(const std::vector<cv::Point3f>& points, int iterations = 1000, float threshold = 1.0f);
+std::vector<Plane> fitRegionPlanes(const std::vector<PlaneRegion>& regions, const cv::Mat& depthMap);
+
+// Assigns each circle to the region containing it and returns the 3D
+// coordinates of the assigned circles, in circle order.
+std::vector<cv::Point3f> computeMarkerCoordinates(std::vector<Circle>& circles,
+                                                  const std::vector<PlaneRegion>& regions,
+                                                  const std::vector<Plane>& planes,
+                                                  const cv::Mat& depthMap);
+
+// Results
+float planeDistance(const std::vector<Plane>& planes);
+void saveResults(const std::string& filename, const std::vector<Circle>& circles,
+                const std::vector<Plane>& planes, const std::vector<cv::Point3f>& coords3d);
+void calculateMeasurements(const std::vector<Circle>& circles, 
+                          const std::vector<Plane>& planes,
+                          const std::vector<cv::Point3f>& coords3d);
@@ -0,0 +1,194 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "xsctt_core.h"
+#include "target_ba.h"
+
+// ═══════════════════════════════════════════════════════════════════════
+// xsctt Multi-Capture Calibration
+// ═══════════════════════════════════════════════════════════════════════
+//
+// Usage: xsctt_multi <captures.txt> <calibration.txt> [output.txt]
+//
+// captures.txt, one capture per line:
+//     frame camera bright_image depth_map
+// Captures with the same frame index were taken by different cameras with
+// the target in the same pose.
+//
+// calibration.txt, one line per camera (CalibrationParam layout), cameras
+// numbered 0..N-1 without gaps:
+//     camera intrinsic[9] distortion[12]
+//
+// Markers are matched across poses by CCTag ID; captures without CCTag
+// markers are rejected.
+
+struct CaptureEntry {
+    int frame;
+    int camera;
+    std::string brightPath;
+    std::string depthPath;
+};
+
+static std::vector<CaptureEntry> loadCaptureList(const std::string& filename) {
+    std::vector<CaptureEntry> entries;
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Cannot open: " << filename << std::endl;
+        return entries;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream iss(line);
+        CaptureEntry e;
+        if (iss >> e.frame >> e.camera >> e.brightPath >> e.depthPath) entries.push_back(e);
+    }
+    return entries;
+}
+
+static std::vector<CameraIntrinsics> loadCalibration(const std::string& filename) {
+    std::vector<CameraIntrinsics> cameras;
+    std::vector<bool> loaded;
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Cannot open: " << filename << std::endl;
+        return cameras;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream iss(line);
+        int index;
+        float intrinsic[9], distortion[12];
+        bool ok = static_cast<bool>(iss >> index);
+        for (int i = 0; i < 9 && ok; i++) ok = static_cast<bool>(iss >> intrinsic[i]);
+        for (int i = 0; i < 12 && ok; i++) ok = static_cast<bool>(iss >> distortion[i]);
+        if (!ok || index < 0) continue;
+        if (index >= static_cast<int>(cameras.size())) {
+            cameras.resize(index + 1);
+            loaded.resize(index + 1, false);
+        }
+        cameras[index] = intrinsicsFromCalibration(intrinsic, distortion);
+        loaded[index] = true;
+    }
+
+    // A missing index would leave a camera with zero intrinsics in the bundle
+    for (size_t c = 0; c < loaded.size(); c++) {
+        if (!loaded[c]) {
+            std::cerr << "Camera " << c << " missing in: " << filename << std::endl;
+            cameras.clear();
+            break;
+        }
+    }
+    return cameras;
+}
+
+static void printPose(const std::string& name, const cv::Matx44d& T) {
+    std::cout << name << std::endl;
+    for (int r = 0; r < 3; r++) {
+        std::cout << "  " << std::setw(10) << T(r, 0) << " " << std::setw(10) << T(r, 1) << " "
+                  << std::setw(10) << T(r, 2) << " | " << std::setw(10) << T(r, 3) << std::endl;
+    }
+}
+
+static void saveBundle(const std::string& filename, const BundleResult& result) {
+    std::ofstream file(filename);
+    file << std::fixed << std::setprecision(4);
+    file << "# Target geometry (target frame, mm)" << std::endl;
+    file << "# id x y z" << std::endl;
+    for (const auto& kv : result.targetPoints) {
+        file << kv.first << " " << kv.second.x << " " << kv.second.y << " " << kv.second.z << std::endl;
+    }
+    file << "\n# Camera extrinsics (camera 0 -> camera i), row-major 4x4" << std::endl;
+    for (size_t c = 0; c < result.cameraExtrinsics.size(); c++) {
+        file << c;
+        for (int i = 0; i < 16; i++) file << " " << result.cameraExtrinsics[c].val[i];
+        file << std::endl;
+    }
+    file << "\n# Reprojection RMS " << result.finalRms << " px, depth RMS " << result.depthRms << " mm" << std::endl;
+    std::cout << "Saved: " << filename << std::endl;
+}
+
+int main(int argc, char** argv) {
+    std::cout << "=== xsctt Multi-Capture Calibration ===" << std::endl;
+    if (argc < 3) {
+        std::cerr << "Usage: xsctt_multi <captures.txt> <calibration.txt> [output.txt]" << std::endl;
+        return -1;
+    }
+    std::string outputPath = argc > 3 ? argv[3] : "xsctt_multi_result.txt";
+
+    std::vector<CaptureEntry> captures = loadCaptureList(argv[1]);
+    std::vector<CameraIntrinsics> cameras = loadCalibration(argv[2]);
+    if (captures.empty() || cameras.empty()) {
+        std::cerr << "No captures or calibration!" << std::endl;
+        return -1;
+    }
+    std::cout << "Captures: " << captures.size() << ", cameras: " << cameras.size() << std::endl;
+
+    // ═══════════════════════════════════════════════════════════
+    // Step 1: Markers of every capture
+    // ═══════════════════════════════════════════════════════════
+    std::cout << "\n=== Step 1: Marker Detection ===" << std::endl;
+    std::vector<TargetView> views;
+    for (const auto& capture : captures) {
+        cv::Mat bright = cv::imread(capture.brightPath, cv::IMREAD_GRAYSCALE);
+        cv::Mat depth = cv::imread(capture.depthPath, cv::IMREAD_UNCHANGED);
+        if (bright.empty()) {
+            std::cerr << "Cannot load: " << capture.brightPath << std::endl;
+            continue;
+        }
+        if (!depth.empty() && depth.type() != CV_16UC1 && depth.type() != CV_32FC1) {
+            std::cerr << "Unsupported depth type: " << capture.depthPath << std::endl;
+            depth.release();
+        }
+
+        // CCTag IDs only: circle-grid IDs are row-major positions without an
+        // orientation reference, so a rotated, flipped or partly occluded
+        // board would number the same dot differently in every pose and
+        // the bundle would fit wrong correspondences.
+        std::streambuf* coutBuf = std::cout.rdbuf(nullptr);
+        std::vector<Circle> circles = detectCCTag(bright);
+        std::cout.rdbuf(coutBuf);
+
+        std::cout << "  Frame " << capture.frame << ", camera " << capture.camera << ": "
+                  << circles.size() << " markers" << std::endl;
+        if (circles.empty()) {
+            std::cerr << "  No CCTag markers, capture rejected" << std::endl;
+            continue;
+        }
+        views.push_back(makeTargetView(capture.frame, capture.camera, circles, depth));
+    }
+
+    // ═══════════════════════════════════════════════════════════
+    // Step 2: Bundle adjustment
+    // ═══════════════════════════════════════════════════════════
+    std::cout << "\n=== Step 2: Bundle Adjustment ===" << std::endl;
+    int64 start = cv::getTickCount();
+    BundleResult result = solveTargetBundle(views, cameras);
+    double ms = (cv::getTickCount() - start) * 1000.0 / cv::getTickFrequency();
+
+    int validFrames = 0;
+    for (bool valid : result.frameValid) validFrames += valid ? 1 : 0;
+    std::cout << std::fixed << std::setprecision(4);
+    std::cout << "  Frames used: " << validFrames << "/" << result.frameValid.size()
+              << ", markers: " << result.targetPoints.size() << std::endl;
+    std::cout << "  Reprojection RMS: " << result.initialRms << " -> " << result.finalRms << " px" << std::endl;
+    std::cout << "  Depth RMS: " << result.depthRms << " mm" << std::endl;
+    std::cout << "  Iterations: " << result.iterations << (result.converged ? " (converged)" : "")
+              << ", " << std::setprecision(1) << ms << " ms" << std::endl;
+    std::cout << std::setprecision(4);
+
+    for (size_t c = 1; c < result.cameraExtrinsics.size(); c++) {
+        printPose("Camera " + std::to_string(c) + " extrinsics (camera 0 -> camera " + std::to_string(c) + "):",
+                  result.cameraExtrinsics[c]);
+    }
+
+    saveBundle(outputPath, result);
+    return result.targetPoints.empty() ? -1 : 0;
+}